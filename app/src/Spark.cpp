@@ -46,17 +46,39 @@
 #include <memory>
 #include <chrono>
 #include <cmath>
-#include <queue>
+#include <atomic>
 #include <thread>
+#include <deque>
+#include <future>
 #include "PreRuntime.h"
+#include "DrpaiMemoryPlanner.h"
 #include <optional>
 #include <utility> // for std::pair
 
 #include "SparkProducerSocket.h"
 #include "DiskUtils.h"
 #include "ParkingSpot.h"
-
-/* DRP-AI memory offset for model object file*/
+#include "FrameRing.h"
+#include "CapturedFrame.h"
+#include "FrameSource.h"
+#include "PatchSampler.h"
+#include "PatchBatch.h"
+#include "PatchPipeline.h"
+#include "PipelinedExecutor.h"
+#include "AsyncInference.h"
+#include "HalfFloat.h"
+#include "InferenceScheduler.h"
+#include "ChangeDetector.h"
+#include "Camera.h"
+#include "PipelineConfig.h"
+#include "PipelineStats.h"
+#include "DownscaleBench.h"
+#include "PatchPipelineBench.h"
+#include "PreRuntimeBench.h"
+#include "PyramidBench.h"
+#include "BatchBench.h"
+
+/* DRP-AI memory offset for model object file whose size is unknown, see plan_model_memory*/
 #define DRPAI_MEM_OFFSET (0X38E0000)
 
 using namespace cv;
@@ -92,6 +114,9 @@ namespace
     const int ESC_KEY = 27;
 
     const auto TRANSMISSION_PERIOD = std::chrono::seconds(2);
+    const auto STATS_REPORT_PERIOD = std::chrono::seconds(10);
+    // How long process_frames sleeps for a frame before re-checking the stop flag
+    const auto FRAME_WAIT_TIMEOUT = std::chrono::milliseconds(100);
 
     void printMatInfo(const cv::Mat &mat)
     {
@@ -110,11 +135,6 @@ namespace
         std::cout << "Estimated Memory Size: " << totalSize << " bytes" << std::endl;
     }
 
-    float float16_to_float32(uint16_t a)
-    {
-        return __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(a);
-    }
-
     /// @brief Display header1 and header2 text on img as white text on on the black background
     /// @param img img to write over
     /// @param header1 Primary header
@@ -140,12 +160,15 @@ namespace
 }
 
 /* Global variables */
-vector<ParkingSpot> parking_spots;
+// ROIs of each camera, indexed like inputs
+vector<vector<ParkingSpot>> camera_parking_spots;
+// Camera whose ROIs the slot editor is working on
+size_t editing_camera = 0;
 
 Mat img;
 Mat frame1 = Mat::zeros(400, 400, CV_8UC3);
 
-std::string filename;
+std::vector<std::string> inputs;
 
 Point2f box_start, box_end;
 cv::Rect rect;
@@ -153,61 +176,37 @@ bool add_slot_in_figure = false;
 bool start_inference_parking_slot = false;
 bool drawing_box = false;
 bool re_draw = false;
-bool camera_input = false;
 
 MeraDrpRuntimeWrapper runtime;
+PipelineConfig pipeline_config;
 
 bool runtime_status = false;
 
-/**
- * Convert HWC format to CHW
- */
-cv::Mat hwc2chw(const cv::Mat &image)
+/// @brief Draws a parking spot's box, id and occupancy label onto img
+/// @param coords Where the spot is in img, see CapturedFrame::toImage
+void draw_parking_spot(Mat &img, const ParkingSpot &parking_spot, const Rect &coords)
 {
-    std::vector<cv::Mat> rgb_images;
-    cv::split(image, rgb_images);
-    cv::Mat m_flat_r = rgb_images[0].reshape(1, 1);
-    cv::Mat m_flat_g = rgb_images[1].reshape(1, 1);
-    cv::Mat m_flat_b = rgb_images[2].reshape(1, 1);
-    cv::Mat matArray[] = {m_flat_r, m_flat_g, m_flat_b};
-    cv::Mat flat_image;
-    cv::hconcat(matArray, 3, flat_image);
-    return flat_image;
-}
+    const std::string label = parking_spot.is_occupied ? "taken" : "empty";
+    const Scalar boxColor = parking_spot.is_occupied ? OCCUPIED_COLOR : UNOCCUPIED_COLOR;
 
-cv::Mat hwc2chwNormalized(const cv::Mat &image, const cv::Scalar &mean, const cv::Scalar &std)
-{
-    // Check if image is empty
-    if (image.empty())
-    {
-        std::cerr << "Input image is empty." << std::endl;
-        return cv::Mat();
-    }
+    int baseline = 0;
+    int thickness = 2;
+    Size textSize = getTextSize("id: " + to_string(parking_spot.slot_id), FONT_HERSHEY_DUPLEX, SECONDARY_LABEL_SCALE, thickness, &baseline);
+    Size labelSize = getTextSize(label, FONT_HERSHEY_DUPLEX, PRIMARY_LABEL_SCALE, thickness, &baseline);
 
-    // Convert image to floating point for processing
-    cv::Mat imageFloat;
-    image.convertTo(imageFloat, CV_32FC3, 1.0 / 255);
+    // Calculate the position for the text background
+    Point textOrg(coords.x + coords.width - textSize.width - thickness, coords.y + coords.height - 5 * thickness);
+    Point labelOrg(coords.x, coords.y - baseline - thickness);
 
-    // Split the image into separate color channels
-    std::vector<cv::Mat> rgb_images;
-    cv::split(imageFloat, rgb_images);
+    // Draw the background rectangle for better visibility
+    rectangle(img, textOrg + Point(0, baseline), textOrg + Point(textSize.width, -textSize.height), boxColor, FILLED);
+    rectangle(img, labelOrg + Point(0, baseline), labelOrg + Point(labelSize.width, -labelSize.height), boxColor, FILLED);
 
-    // Normalize each channel
-    for (int i = 0; i < 3; ++i)
-    {
-        rgb_images[i] = (rgb_images[i] - mean[i]) / std[i];
-    }
-
-    // Reshape each channel to a single row (flatten)
-    cv::Mat m_flat_r = rgb_images[0].reshape(1, 1);
-    cv::Mat m_flat_g = rgb_images[1].reshape(1, 1);
-    cv::Mat m_flat_b = rgb_images[2].reshape(1, 1);
-
-    // Concatenate the flattened channels into a single matrix
-    cv::Mat flat_image;
-    cv::vconcat(std::vector<cv::Mat>{m_flat_r, m_flat_g, m_flat_b}, flat_image);
+    // Now draw the text over the rectangle
+    putText(img, "id: " + to_string(parking_spot.slot_id), textOrg + Point(0, 3), FONT_HERSHEY_DUPLEX, SECONDARY_LABEL_SCALE, BLACK, thickness);
+    putText(img, label, labelOrg + Point(0, 2), FONT_HERSHEY_DUPLEX, PRIMARY_LABEL_SCALE, BLACK, thickness);
 
-    return flat_image;
+    rectangle(img, coords, boxColor, thickness);
 }
 
 /*****************************************
@@ -219,6 +218,7 @@ cv::Mat hwc2chwNormalized(const cv::Mat &image, const cv::Scalar &mean, const cv
  ******************************************/
 void get_patches(int event, int x, int y, int flags, void *param)
 {
+    auto &parking_spots = camera_parking_spots[editing_camera];
     // clone the image so we can mutate parking_spots array without leaving artifacts on img
     cv::Mat frame_copy = img.clone();
     if (event == EVENT_LBUTTONDOWN)
@@ -275,6 +275,7 @@ void get_patches(int event, int x, int y, int flags, void *param)
  ******************************************/
 int draw_rectangle(void)
 {
+    const auto &parking_spots = camera_parking_spots[editing_camera];
     // Clone the image so we can mutate parking_spots array without leaving artifacts on img
     auto img_clone = img.clone();
     for (int i = 0; i < parking_spots.size(); i++)
@@ -306,31 +307,36 @@ int draw_rectangle(void)
 
 /*****************************************
  * Function Name     : addButtonCallback
- * Description       : add slots to the parking_spots vector(user can draw bounding box)
+ * Description       : add slots to each camera's parking_spots vector(user can draw bounding box)
  ******************************************/
 void addButtonCallback(int, void *)
 {
-    cv::VideoCapture vid;
-redraw_rectangle:
-    if (camera_input)
+    // Walk through the cameras one after the other
+    for (editing_camera = 0; editing_camera < inputs.size(); editing_camera++)
     {
-        vid.open(0);
-        vid.set(CAP_PROP_FRAME_WIDTH, 1920);
-        vid.set(CAP_PROP_FRAME_HEIGHT, 1080);
+    redraw_rectangle:
+        auto source = FrameSource::create(inputs[editing_camera], pipeline_config);
+        bool is_success = source->open();
+        // Skip the first frames while the camera settles its exposure
+        for (int frame = 0; is_success && frame <= 10; frame++)
+        {
+            CapturedFrame captured;
+            is_success = source->read(captured);
+            if (is_success && frame == 10)
+            {
+                // Copy out: the editor keeps img long after the source is gone
+                convertToBgr(captured, img);
+            }
+            source->release(std::move(captured));
+        }
+        if (is_success == true)
+            std::cout << "Draw rectangle for camera " << editing_camera + 1 << " (" << inputs[editing_camera] << ") !!!\n";
+        source.reset();
+        re_draw = draw_rectangle();
+        if (re_draw == true)
+            goto redraw_rectangle;
     }
-    else
-        vid.open(filename);
-    for (int frame = 0; frame < 10; frame++)
-    {
-        vid.read(img);
-    }
-    bool is_success = vid.read(img);
-    if (is_success == true)
-        std::cout << "Draw rectangle !!!\n";
-    vid.release();
-    re_draw = draw_rectangle();
-    if (re_draw == true)
-        goto redraw_rectangle;
+    editing_camera = 0;
 }
 
 /*****************************************
@@ -354,197 +360,497 @@ void main_window_mouse_callback(int event, int x, int y, int flags, void *userda
     }
 }
 
-void read_frames(const string &videoFile, queue<Mat> &frames, bool &stop)
+void read_frames(Camera &camera, FrameArrivals &arrivals, std::atomic<bool> &stop)
 {
-    VideoCapture cap;
-    if (filename == "0")
+    if (!camera.source->open())
     {
-        cap.open(0);
-        cap.set(CAP_PROP_FRAME_WIDTH, 1920);
-        cap.set(CAP_PROP_FRAME_HEIGHT, 1080);
-    }
-    else
-    {
-        cap.open(videoFile);
-    }
-
-    if (!cap.isOpened())
-    {
-        cerr << "Failed " << videoFile << endl;
+        cerr << "Failed " << camera.input << endl;
+        camera.frames.shutdown();
+        arrivals.notify();
         return;
     }
 
     try
     {
-        Mat frame;
+        uint64_t sequence = 0;
         while (!stop)
         {
-            if (!cap.read(frame) || frame.empty())
-                throw new runtime_error("Failed to read frame from video file");
+            CapturedFrame frame;
+            if (!camera.source->read(frame))
+                throw runtime_error("Failed to read frame from " + camera.input);
+            frame.sequence = sequence++;
 
-            frames.push(frame);
+            auto rejected = camera.frames.push(std::move(frame));
+            if (rejected)
+            {
+                camera.source->release(std::move(*rejected));
+            }
+            arrivals.notify();
         }
     }
     catch (const std::exception &e)
     {
         std::cerr << e.what() << std::endl;
 
-        stop = true;
-        cap.release();
+        // Only this camera is done; the worker keeps serving the others
+        camera.frames.shutdown();
+        arrivals.notify();
         return;
     }
 }
 
-/// @brief The primary business logic of the parking lot detection application
-/// @param frames The queue of VideoCapture frames to process
-/// @param stop The flag to stop the processing
-/// @param producerSocket The SparkProducerSocket to send occupancy data through
-void process_frames(queue<Mat> &frames, bool &stop, std::shared_ptr<SparkProducerSocket> producerSocket)
+/// @brief Takes the next frame of camera to run inference on, honouring the ingest mode and max frame age
+/// @return false if camera has nothing (fresh enough) to process right now
+bool take_frame(Camera &camera, CapturedFrame &frame)
 {
+    if (!camera.frames.pop(frame))
+    {
+        return false;
+    }
 
-    Rect box;
-    Mat patch1, patch_con, patch_norm, inp_img;
-    namedWindow(app_name, WINDOW_NORMAL);
-    setWindowProperty(app_name, cv::WND_PROP_FULLSCREEN, cv::WINDOW_FULLSCREEN);
+    if (pipeline_config.ingest_mode == IngestMode::LatestWins)
+    {
+        // Anything still queued behind this frame is newer; keep only the newest
+        CapturedFrame newer;
+        while (camera.frames.pop(newer))
+        {
+            camera.ingest_stats.skipped++;
+            camera.source->release(std::move(frame));
+            frame = std::move(newer);
+        }
+    }
 
-    if (!parking_spots.empty())
+    if (pipeline_config.max_frame_age.count() > 0 && frame.age() > pipeline_config.max_frame_age)
     {
-        disk_utils::serializeROIs(parking_spots);
+        camera.ingest_stats.stale++;
+        camera.source->release(std::move(frame));
+        return false;
     }
+    return true;
+}
 
-    while (!stop)
+/// @brief Polls the cameras round-robin, starting after the one served last, so one busy camera can't starve the others
+Camera *poll_cameras(std::vector<std::unique_ptr<Camera>> &cameras, size_t &next_camera, CapturedFrame &frame)
+{
+    for (size_t i = 0; i < cameras.size(); i++)
     {
-        if (!frames.empty())
+        Camera &camera = *cameras[(next_camera + i) % cameras.size()];
+        if (take_frame(camera, frame))
         {
-            auto t1 = std::chrono::high_resolution_clock::now();
-            Mat frame = frames.front();
-            frames.pop();
-            img = frame;
-            int taken = 0, empty = 0;
-            for (auto &parking_spot : parking_spots)
-            {
-                box = parking_spot.coords;
-                patch1 = img(box);
-                resize(patch1, patch1, Size(28, 28));
-                // patch is 28x28x3 (aka dont forget its BGR)
-                cvtColor(patch1, patch1, COLOR_BGR2RGB);
-                inp_img = hwc2chw(patch1);
-
-                if (!inp_img.isContinuous())
-                    patch_con = inp_img.clone();
-                else
-                    patch_con = inp_img;
-
-                // Replicate the 'ToTensor()' function in the PyTorch model
-                patch_con.convertTo(patch_norm, CV_32F, 1.0 / 255.0, 0);
-                runtime.SetInput(0, patch_norm.ptr<float>());
-                runtime.Run();
-                auto output_num = runtime.GetNumOutput();
-                if (output_num != 1)
-                {
-                    std::cerr << "[ERROR] Output size : not 1." << std::endl;
-                    return;
-                }
-                auto output_buffer = runtime.GetOutput(0);
-                int64_t out_size = std::get<2>(output_buffer);
-                float floatarr[out_size];
+            next_camera = (camera.index + 1) % cameras.size();
+            return &camera;
+        }
+    }
+    return nullptr;
+}
 
-                if (InOutDataType::FLOAT16 == std::get<0>(output_buffer))
-                {
-                    /* Extract data in FP16 <uint16_t>. */
-                    uint16_t *data_ptr = reinterpret_cast<uint16_t *>(std::get<1>(output_buffer));
-
-                    /* Post-processing for FP16 */
-                    /* Cast FP16 output data to FP32. */
-                    for (int n = 0; n < out_size; n++)
-                    {
-                        floatarr[n] = float16_to_float32(data_ptr[n]);
-                    }
-                }
-                else if (InOutDataType::FLOAT32 == std::get<0>(output_buffer))
-                {
-                    /* Extract data in FP32 <float>. */
-                    float *data_ptr = reinterpret_cast<float *>(std::get<1>(output_buffer));
-                    /*Copy output data to buffer for post-processing. */
-                    std::copy(data_ptr, data_ptr + out_size, floatarr);
-                }
-                else
-                {
-                    std::cerr << "[ERROR] Output data type : not floating point type." << std::endl;
-                    return;
-                }
+/// @brief Next camera with a frame to process, sleeping up to FRAME_WAIT_TIMEOUT if none has one
+/// @return nullptr if nothing arrived in time
+Camera *take_next_frame(std::vector<std::unique_ptr<Camera>> &cameras, size_t &next_camera, FrameArrivals &arrivals, CapturedFrame &frame, WakeupStats &wakeups)
+{
+    // Read before polling: a frame queued after the poll bumps the epoch and ends the wait right away
+    const uint64_t epoch = arrivals.epoch();
+    if (Camera *camera = poll_cameras(cameras, next_camera, frame))
+    {
+        return camera;
+    }
 
-                std::string label;
-                Scalar boxColor;
-                const bool is_occupied = floatarr[0] < floatarr[1];
-                if (is_occupied)
-                {
-                    taken++;
-                    label = "taken";
-                    boxColor = OCCUPIED_COLOR;
-                }
-                else
-                {
-                    empty++;
-                    label = "empty";
-                    boxColor = UNOCCUPIED_COLOR;
-                }
-                parking_spot.update_occupancy(is_occupied);
+    const auto wait_start = std::chrono::steady_clock::now();
+    if (!arrivals.wait_for(epoch, FRAME_WAIT_TIMEOUT))
+    {
+        if (pipeline_config.measure_wakeups)
+        {
+            wakeups.record_idle(std::chrono::steady_clock::now() - wait_start);
+        }
+        return nullptr;
+    }
 
-                int baseline = 0;
-                int thickness = 2;
-                Size textSize = getTextSize("id: " + to_string(parking_spot.slot_id), FONT_HERSHEY_DUPLEX, SECONDARY_LABEL_SCALE, thickness, &baseline);
-                Size labelSize = getTextSize(label, FONT_HERSHEY_DUPLEX, PRIMARY_LABEL_SCALE, thickness, &baseline);
+    Camera *camera = poll_cameras(cameras, next_camera, frame);
+    if (pipeline_config.measure_wakeups)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        wakeups.record_idle(now - wait_start);
+        if (camera != nullptr)
+        {
+            wakeups.record_wakeup(now - camera->frames.last_push_time());
+        }
+    }
+    return camera;
+}
 
-                // Calculate the position for the text background
-                Point textOrg(parking_spot.coords.x + parking_spot.coords.width - textSize.width - thickness, parking_spot.coords.y + parking_spot.coords.height - 5 * thickness);
-                Point labelOrg(parking_spot.coords.x, parking_spot.coords.y - baseline - thickness);
+/// @brief The patch element type a loaded model takes
+/// @return false if its input is neither fp32 nor fp16
+bool model_input_type(MeraDrpRuntimeWrapper &model, patch_sampler::OutputType &type)
+{
+    switch (model.GetInputDataType(0))
+    {
+    case InOutDataType::FLOAT32:
+        type = patch_sampler::OutputType::Float32;
+        return true;
+    case InOutDataType::FLOAT16:
+        type = patch_sampler::OutputType::Float16;
+        return true;
+    default:
+        return false;
+    }
+}
 
-                // Draw the background rectangle for better visibility
-                rectangle(img, textOrg + Point(0, baseline), textOrg + Point(textSize.width, -textSize.height), boxColor, FILLED);
-                rectangle(img, labelOrg + Point(0, baseline), labelOrg + Point(labelSize.width, -labelSize.height), boxColor, FILLED);
+/// @brief Runs model on n contiguous patches of its input type and reads their outputs as
+///        floats, GetOutputSizePerItem() per patch; split into runs of the model's batch size
+/// @return false on an unrecoverable runtime error
+bool run_model(MeraDrpRuntimeWrapper &model, const void *patches, size_t n, std::vector<float> &logits)
+{
+    auto output_num = model.GetNumOutput();
+    if (output_num != 1)
+    {
+        std::cerr << "[ERROR] Output size : not 1." << std::endl;
+        return false;
+    }
+    logits.resize(n * model.GetOutputSizePerItem());
 
-                // Now draw the text over the rectangle
-                putText(img, "id: " + to_string(parking_spot.slot_id), textOrg + Point(0, 3), FONT_HERSHEY_DUPLEX, SECONDARY_LABEL_SCALE, BLACK, thickness);
-                putText(img, label, labelOrg + Point(0, 2), FONT_HERSHEY_DUPLEX, PRIMARY_LABEL_SCALE, BLACK, thickness);
+    bool ran = false;
+    switch (model.GetInputDataType(0))
+    {
+    case InOutDataType::FLOAT16:
+        ran = model.RunBatch(static_cast<const unsigned short *>(patches), n, logits.data());
+        break;
+    case InOutDataType::FLOAT32:
+        ran = model.RunBatch(static_cast<const float *>(patches), n, logits.data());
+        break;
+    default:
+        break;
+    }
+    if (!ran)
+    {
+        std::cerr << "[ERROR] Input or output data type : not floating point type." << std::endl;
+        return false;
+    }
+    return true;
+}
 
-                rectangle(img, parking_spot.coords, boxColor, thickness);
+/// @brief One chunk of a camera's spots submitted to the inference thread
+struct PendingChunk
+{
+    Camera *camera;
+    std::vector<size_t> spot_indices;
+    std::future<InferenceResult> result;
+    // Set on a frame's last chunk: when classification of the frame started
+    std::optional<std::chrono::steady_clock::time_point> frame_started;
+    // The frame's CapturedFrame::captured_at, for its capture-to-decision latency
+    std::chrono::steady_clock::time_point captured_at;
+};
+
+/// @brief Applies the decisions of pending chunks to their cameras, in submission order
+/// @param camera Waits for every chunk of camera, and so for those queued before them; nullptr
+///        applies only the chunks that are already finished
+/// @return false on an unrecoverable runtime error
+bool apply_results(std::deque<PendingChunk> &pending, const Camera *camera)
+{
+    while (!pending.empty())
+    {
+        PendingChunk &chunk = pending.front();
+        const bool must_wait = camera != nullptr && std::any_of(pending.begin(), pending.end(), [&](const PendingChunk &p)
+                                                                 { return p.camera == camera; });
+        if (!must_wait && chunk.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            break;
+        }
+
+        InferenceResult result;
+        try
+        {
+            result = chunk.result.get();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[ERROR] Inference failed: " << e.what() << std::endl;
+            return false;
+        }
+
+        Camera &owner = *chunk.camera;
+        for (size_t i = 0; i < chunk.spot_indices.size(); i++)
+        {
+            const float *spot_logits = result.logits.data() + i * result.outputs_per_item;
+            const bool is_occupied = spot_logits[0] < spot_logits[1];
+            owner.parking_spots[chunk.spot_indices[i]].update_occupancy(is_occupied);
+            owner.change_detector.mark_classified(chunk.spot_indices[i]);
+            owner.stats.spots_classified++;
+        }
+        owner.stats.drpai_time += result.run_time;
+        if (chunk.frame_started)
+        {
+            owner.inference_duration = std::chrono::duration_cast<std::chrono::milliseconds>(result.finished - *chunk.frame_started).count();
+            // Every decision of the frame is in place only now
+            owner.ingest_stats.processed++;
+            owner.ingest_stats.latency.record(std::chrono::steady_clock::now() - chunk.captured_at);
+        }
+        pending.pop_front();
+    }
+    return true;
+}
+
+/// @brief Submits the parking spots of camera that changed in frame for classification.
+///        Their decisions are applied by apply_results once the inference thread is done
+/// @param batch Scratch batch the changed spots are preprocessed into
+/// @param executor Samples the batch chunk by chunk on its own thread, ahead of the DRP-AI
+/// @param pending Receives one entry per submitted chunk; with nothing to submit the frame is
+///        accounted as processed right away
+void classify_spots(Camera &camera, const CapturedFrame &frame, PatchBatch &batch, PipelinedExecutor &executor, AsyncInference &inference,
+                    std::deque<PendingChunk> &pending, DutyCycleStats &duty_cycle)
+{
+    const auto started = std::chrono::steady_clock::now();
+    {
+        StageTimer timer(duty_cycle, Stage::Preprocess);
+        batch.clear();
+        for (size_t spot_index = 0; spot_index < camera.parking_spots.size(); spot_index++)
+        {
+            auto &parking_spot = camera.parking_spots[spot_index];
+            const Rect box = frame.toImage(parking_spot.coords);
+            if (!camera.change_detector.needs_inference(spot_index, frame, box))
+            {
+                // Nothing moved in this spot; its last decision still stands
+                continue;
             }
-            auto t2 = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+            batch.add(spot_index, box, parking_spot.resample_plan);
+        }
+    }
 
-            const std::string drp_header = "DRP-AI Processing Time: " + to_string(duration) + " ms";
-            const std::string esc_header = "Press esc to go back";
-            display_header1_header2(img, drp_header, esc_header);
+    if (batch.empty())
+    {
+        // Every decision of the frame stands already
+        camera.ingest_stats.processed++;
+        camera.ingest_stats.latency.record(frame.age());
+        return;
+    }
 
-            if (waitKey(3) == ESC_KEY) // Wait for 'Esc' key press to stop inference window!!
+    // Whole multiples of the compiled batch, so only a frame's last run can be short
+    const size_t model_batch = inference.batch_size();
+    const size_t chunk = (pipeline_config.pipeline_chunk + model_batch - 1) / model_batch * model_batch;
+    const size_t chunks = (batch.size() + chunk - 1) / chunk;
+    executor.run(
+        chunks,
+        [&](size_t c, size_t)
+        {
+            if (c == 0)
             {
-                stop = true;
-                for (auto &spot : parking_spots)
+                // Once per frame, over the large ROIs only
+                batch.build_pyramid(frame);
+            }
+            // Replicate the 'ToTensor()' (and optional 'Normalize()') of the PyTorch model
+            batch.fill(frame, c * chunk, (c + 1) * chunk);
+        },
+        [&](size_t c, size_t)
+        {
+            // Only blocks while the inference queue is full
+            StageTimer timer(duty_cycle, Stage::Inference);
+            const size_t begin = c * chunk;
+            const size_t end = std::min(batch.size(), begin + chunk);
+
+            PendingChunk submitted{&camera, {}, inference.submit(batch.share(begin), end - begin), std::nullopt, frame.captured_at};
+            for (size_t i = begin; i < end; i++)
+            {
+                submitted.spot_indices.push_back(batch.spot_index(i));
+            }
+            if (end == batch.size())
+            {
+                submitted.frame_started = started;
+            }
+            pending.push_back(std::move(submitted));
+            return true;
+        });
+    // Sampling the worker had to wait for is the part of preprocessing inference did not hide
+    duty_cycle.add(Stage::Preprocess, executor.last_run().inference_starved);
+}
+
+void print_worker_stats(const std::vector<std::unique_ptr<Camera>> &cameras, const DutyCycleStats &duty_cycle, const WakeupStats &wakeups, const PatchBatch &batch,
+                        const PipelinedExecutor &executor, const AsyncInference &inference)
+{
+    std::cout << "Duty cycle: " << duty_cycle << std::endl;
+    std::cout << "Preprocess batches: " << batch.stats() << std::endl;
+    std::cout << "Pipeline (depth " << executor.depth() << ", chunk " << pipeline_config.pipeline_chunk << "): " << executor.stats() << std::endl;
+    std::cout << "Inference queue (capacity " << inference.capacity() << "): " << inference.stats() << std::endl;
+    if (pipeline_config.profile_every_n > 0)
+    {
+        // Thread-safe, unlike the rest of the runtime the inference thread owns
+        std::cout << "Model profile (every " << pipeline_config.profile_every_n << " runs): " << runtime.GetProfileStats() << std::endl;
+    }
+    if (wakeups.wakeups().samples() > 0)
+    {
+        std::cout << "Worker: " << wakeups << std::endl;
+    }
+
+    std::chrono::steady_clock::duration total_drpai_time{0};
+    for (const auto &camera : cameras)
+    {
+        total_drpai_time += camera->stats.drpai_time;
+    }
+    for (const auto &camera : cameras)
+    {
+        printCameraStats(std::cout, *camera, total_drpai_time);
+        std::cout << std::endl;
+    }
+}
+
+/// @brief The primary business logic of the parking lot detection application.
+///        A single worker serves every camera, so there is one MeraDrpRuntimeWrapper for the whole lot.
+/// @param cameras The cameras whose frame rings to process
+/// @param arrivals Signalled by the readers whenever a frame is queued
+/// @param stop The flag to stop the processing
+/// @param producerSocket The SparkProducerSocket to send occupancy data through
+void process_frames(std::vector<std::unique_ptr<Camera>> &cameras, FrameArrivals &arrivals, std::atomic<bool> &stop, std::shared_ptr<SparkProducerSocket> producerSocket)
+{
+    for (const auto &camera : cameras)
+    {
+        const std::string window = camera->window_name(app_name);
+        namedWindow(window, WINDOW_NORMAL);
+        setWindowProperty(window, cv::WND_PROP_FULLSCREEN, cv::WINDOW_FULLSCREEN);
+    }
+
+    patch_sampler::OutputType input_type;
+    if (!model_input_type(runtime, input_type))
+    {
+        std::cerr << "[ERROR] Input data type : not FP32 or FP16." << std::endl;
+        return;
+    }
+    if (runtime.GetNumOutput() != 1)
+    {
+        std::cerr << "[ERROR] Output size : not 1." << std::endl;
+        return;
+    }
+    // The kernels for every source format are picked here, once, for the model's input
+    const patch_sampler::PatchPipeline pipeline(pipeline_config.tensor_spec, input_type);
+    std::cout << "Preprocessing: " << patch_sampler::to_string(pipeline.output_type()) << " output, "
+              << (pipeline.size_specialized() ? "size-specialized" : "generic-size") << " kernels" << std::endl;
+
+    CapturedFrame frame;
+    DutyCycleStats duty_cycle;
+    WakeupStats wakeups;
+    PatchBatch batch(pipeline, static_cast<int>(pipeline_config.pyramid_levels));
+    PipelinedExecutor executor(pipeline_config.pipeline_depth);
+    // From here on only its thread runs the model
+    AsyncInference inference(runtime, pipeline_config.inference_queue);
+    std::deque<PendingChunk> pending;
+    // Occupancy of the whole lot, cameras in order, for the producer socket
+    std::vector<ParkingSpot> lot_spots;
+    size_t next_camera = 0;
+    auto last_stats_report = std::chrono::steady_clock::now();
+    while (!stop)
+    {
+        Camera *camera = nullptr;
+        {
+            StageTimer timer(duty_cycle, Stage::Wait);
+            camera = take_next_frame(cameras, next_camera, arrivals, frame, wakeups);
+        }
+        if (camera == nullptr)
+        {
+            const bool all_done = std::all_of(cameras.begin(), cameras.end(), [](const std::unique_ptr<Camera> &c)
+                                              { return c->frames.is_shutdown() && c->frames.size() == 0; });
+            if (all_done)
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Decisions of earlier frames that the DRP-AI has finished since
+        if (!apply_results(pending, nullptr))
+        {
+            return;
+        }
+        // Between inference runs the overlay keeps showing each spot's last known state
+        if (camera->scheduler.should_run())
+        {
+            {
+                // Change detection needs this camera's previous decisions in place
+                StageTimer timer(duty_cycle, Stage::Inference);
+                if (!apply_results(pending, camera))
                 {
-                    spot.is_online = false;
+                    return;
                 }
+            }
+            classify_spots(*camera, frame, batch, executor, inference, pending, duty_cycle);
+            camera->scheduler.mark_run();
+        }
 
-                destroyAllWindows();
-                break;
+        if (std::chrono::steady_clock::now() - last_stats_report >= STATS_REPORT_PERIOD)
+        {
+            print_worker_stats(cameras, duty_cycle, wakeups, batch, executor, inference);
+            for (auto &c : cameras)
+            {
+                c->ingest_stats.latency.reset();
+                c->change_detector.reset_stats();
+                c->stats = CameraStats();
             }
+            wakeups.reset();
+            duty_cycle.reset();
+            batch.reset_stats();
+            executor.reset_stats();
+            inference.reset_stats();
+            runtime.ResetProfileStats();
+            last_stats_report = std::chrono::steady_clock::now();
+        }
+
+        StageTimer timer(duty_cycle, Stage::Render);
+        Mat display = frame.image;
+        if (frame.format != FORMAT_BGR)
+        {
+            convertToBgr(frame, camera->bgr_frame);
+            display = camera->bgr_frame;
+        }
+        for (const auto &parking_spot : camera->parking_spots)
+        {
+            draw_parking_spot(display, parking_spot, frame.toImage(parking_spot.coords));
+        }
+
+        const std::string drp_header = "DRP-AI Processing Time: " + to_string(camera->inference_duration) + " ms";
+        const std::string esc_header = "Press esc to go back";
+        display_header1_header2(display, drp_header, esc_header);
 
-            imshow(app_name, img);
-            if (producerSocket && producerSocket->sendOccupancyDataThrottled(parking_spots))
+        if (waitKey(3) == ESC_KEY) // Wait for 'Esc' key press to stop inference window!!
+        {
+            stop = true;
+            for (auto &c : cameras)
             {
-                // std::cout << "Sent occupancy data" << std::endl;
+                c->frames.shutdown();
+                for (auto &spot : c->parking_spots)
+                {
+                    spot.is_online = false;
+                }
             }
+
+            destroyAllWindows();
+            camera->source->release(std::move(frame));
+            break;
+        }
+
+        imshow(camera->window_name(app_name), display);
+        // imshow keeps its own copy, so the buffer can go back to the source
+        camera->source->release(std::move(frame));
+
+        lot_spots.clear();
+        for (const auto &c : cameras)
+        {
+            lot_spots.insert(lot_spots.end(), c->parking_spots.begin(), c->parking_spots.end());
+        }
+        if (producerSocket && producerSocket->sendOccupancyDataThrottled(lot_spots))
+        {
+            // std::cout << "Sent occupancy data" << std::endl;
         }
     }
+    for (const auto &camera : cameras)
+    {
+        apply_results(pending, camera.get());
+    }
+    print_worker_stats(cameras, duty_cycle, wakeups, batch, executor, inference);
 }
 
 /*****************************************
- * Function Name : get_drpai_start_addr
- * Description   : Function to get the start address of DRPAImem.
+ * Function Name : get_drpai_area
+ * Description   : Function to get the start address and size of DRPAImem.
  * Arguments     : -
- * Return value  : uint32_t = DRPAImem start address in 32-bit.
+ * Return value  : drpai_data_t = DRPAImem start address and size in 32-bit.
  ******************************************/
-std::optional<uint32_t> get_drpai_start_addr()
+std::optional<drpai_data_t> get_drpai_area(DrpaiDriver &driver = DrpaiDriver::system())
 {
     int fd = 0;
     int ret = 0;
@@ -553,7 +859,7 @@ std::optional<uint32_t> get_drpai_start_addr()
 
     errno = 0;
 
-    fd = open("/dev/drpai0", O_RDWR);
+    fd = driver.open();
     if (0 > fd)
     {
         LOG(FATAL) << "[ERROR] Failed to open DRP-AI Driver : errno=" << errno;
@@ -561,29 +867,168 @@ std::optional<uint32_t> get_drpai_start_addr()
     }
 
     /* Get DRP-AI Memory Area Address via DRP-AI Driver */
-    ret = ioctl(fd, DRPAI_GET_DRPAI_AREA, &drpai_data);
+    ret = driver.ioctl(fd, DRPAI_GET_DRPAI_AREA, &drpai_data);
+    driver.close(fd);
     if (-1 == ret)
     {
         LOG(FATAL) << "[ERROR] Failed to get DRP-AI Memory Area : errno=" << errno;
         return std::nullopt;
     }
 
-    return drpai_data.address;
+    return drpai_data;
+}
+
+/// @brief Plans the model's region of the DRP-AI area. Its size is SPARK_MODEL_DRPAI_BYTES or
+///        else what the address maps of its DRP-AI subgraphs add up to; a model with neither
+///        keeps the historic place at DRPAI_MEM_OFFSET and everything above it
+/// @return the model's start address, nullopt if the area cannot hold it
+std::optional<uint32_t> plan_model_memory(DrpaiMemoryPlanner &planner, const drpai_data_t &area)
+{
+    const std::optional<uint32_t> footprint = pipeline_config.model_drpai_bytes > 0
+                                                  ? std::optional<uint32_t>(static_cast<uint32_t>(pipeline_config.model_drpai_bytes))
+                                                  : DrpaiMemoryPlanner::modelFootprint(model_dir);
+    if (footprint)
+    {
+        return planner.allocate("model " + model_dir, *footprint);
+    }
+    const uint32_t rest = area.size > DRPAI_MEM_OFFSET ? area.size - DRPAI_MEM_OFFSET : 0;
+    return planner.reserve("model " + model_dir + " (size unknown)", area.address + DRPAI_MEM_OFFSET, rest);
+}
+
+/// @brief `spark --validate-fp16 <recording> <fp32_model_dir>`: classifies every spot of every
+///        frame of a recorded input with the deployed fp16 model and with its fp32 build, and
+///        compares the decisions and logits.
+///
+/// The fp16 side is exactly what the worker runs: the loaded model fed Float16 patches. The
+/// reference is the fp32 build from fp32_model_dir, loaded next to it into a region of its own,
+/// fed Float32 patches of the same ROIs. Uses camera 1's ROIs.
+/// @return process exit code, non-zero if any decision differs
+int validate_fp16(const std::string &input, const std::string &fp32_model_dir, DrpaiMemoryPlanner &planner)
+{
+    patch_sampler::OutputType model_type;
+    if (!model_input_type(runtime, model_type) || model_type != patch_sampler::OutputType::Float16)
+    {
+        std::cerr << "[ERROR] --validate-fp16 needs an fp16 model in " << model_dir << std::endl;
+        return 1;
+    }
+    std::vector<ParkingSpot> &parking_spots = camera_parking_spots[0];
+    if (parking_spots.empty())
+    {
+        std::cerr << "[ERROR] No parking spots to validate with, draw them first" << std::endl;
+        return 1;
+    }
+
+    const std::optional<uint32_t> footprint = DrpaiMemoryPlanner::modelFootprint(fp32_model_dir);
+    if (!footprint.has_value())
+    {
+        std::cerr << "[ERROR] " << fp32_model_dir << " has no DRP-AI address map to plan its memory from" << std::endl;
+        return 1;
+    }
+    const std::optional<uint32_t> reference_address = planner.allocate("model " + fp32_model_dir, *footprint);
+    if (!reference_address.has_value())
+    {
+        std::cerr << "[ERROR] DRP-AI memory area exhausted." << std::endl;
+        planner.report(std::cerr);
+        return 1;
+    }
+    MeraDrpRuntimeWrapper reference_model;
+    patch_sampler::OutputType reference_type;
+    if (!reference_model.LoadModel(fp32_model_dir, reference_address.value()) ||
+        !model_input_type(reference_model, reference_type) || reference_type != patch_sampler::OutputType::Float32)
+    {
+        std::cerr << "[ERROR] Failed to load an fp32 model from " << fp32_model_dir << std::endl;
+        return 1;
+    }
+    std::cout << "reference model:" << fp32_model_dir << "\n";
+
+    Camera camera(0, input, parking_spots, pipeline_config);
+    if (!camera.source->open())
+    {
+        std::cerr << "Failed " << input << std::endl;
+        return 1;
+    }
+
+    const patch_sampler::PatchPipeline fp32(pipeline_config.tensor_spec, patch_sampler::OutputType::Float32);
+    const patch_sampler::PatchPipeline fp16(pipeline_config.tensor_spec, patch_sampler::OutputType::Float16);
+    const size_t elements = 3 * static_cast<size_t>(pipeline_config.tensor_spec.size.area());
+    std::vector<float> reference(elements);
+    std::vector<uint16_t> half(elements);
+    std::vector<float> reference_logits, fp16_logits;
+
+    uint64_t patches = 0;
+    uint64_t disagreements = 0;
+    float max_logit_difference = 0.0f;
+    CapturedFrame frame;
+    while (camera.source->read(frame))
+    {
+        for (auto &parking_spot : parking_spots)
+        {
+            const Rect box = frame.toImage(parking_spot.coords);
+            fp32.sample(frame, box, parking_spot.resample_plan, reference.data());
+            fp16.sample(frame, box, parking_spot.resample_plan, half.data());
+
+            if (!run_model(reference_model, reference.data(), 1, reference_logits) ||
+                !run_model(runtime, half.data(), 1, fp16_logits))
+            {
+                return 1;
+            }
+
+            patches++;
+            if ((reference_logits[0] < reference_logits[1]) != (fp16_logits[0] < fp16_logits[1]))
+            {
+                disagreements++;
+            }
+            for (size_t i = 0; i < reference_logits.size(); i++)
+            {
+                max_logit_difference = std::max(max_logit_difference, std::abs(reference_logits[i] - fp16_logits[i]));
+            }
+        }
+        camera.source->release(std::move(frame));
+    }
+
+    std::cout << "fp16 validation: {"
+              << "model: " << model_dir << ", "
+              << "reference: " << fp32_model_dir << ", "
+              << "conversion: " << half_float::instructionSet() << ", "
+              << "patches: " << patches << ", "
+              << "decision_mismatches: " << disagreements << ", "
+              << "max_logit_difference: " << max_logit_difference
+              << "}" << std::endl;
+    return disagreements == 0 ? 0 : 1;
 }
 
 int main(int argc, char **argv)
 {
+    if (argc == 2 && std::string(argv[1]) == "--bench-downscale")
+    {
+        // Needs neither the DRP-AI nor a camera
+        return runDownscaleBench(std::cout);
+    }
+    if (argc == 2 && std::string(argv[1]) == "--bench-pipelines")
+    {
+        return runPipelineBench(std::cout);
+    }
+    if (argc == 2 && std::string(argv[1]) == "--bench-pyramid")
+    {
+        return runPyramidBench(std::cout);
+    }
+    if ((argc == 2 || argc == 3) && std::string(argv[1]) == "--bench-preruntime")
+    {
+        // Runs on the mock driver, so it needs no board either
+        return runPreRuntimeBench(std::cout, argc == 3 ? argv[2] : model_dir + "/preprocess");
+    }
 
     /*Load model_dir structure and its weight to runtime object */
-    auto drpaimem_addr_start = get_drpai_start_addr();
-    if (!drpaimem_addr_start.has_value())
+    auto drpai_area = get_drpai_area();
+    if (!drpai_area.has_value())
     {
-        /* Error notifications are output from function get_drpai_start_addr(). */
+        /* Error notifications are output from function get_drpai_area(). */
         fprintf(stderr, "[ERROR] Failed to get DRP-AI memory area start address. \n");
         return -1;
     }
 
-    parking_spots = disk_utils::deserializeROIs();
+    pipeline_config = PipelineConfig::fromEnvironment();
+    std::cout << "Pipeline config: " << pipeline_config << std::endl;
 
     std::shared_ptr<SparkProducerSocket> producerSocket;
     try
@@ -596,8 +1041,20 @@ int main(int argc, char **argv)
         producerSocket = nullptr;
     }
 
+    // Every model and PreRuntime bundle loaded into the area gets its region from here
+    DrpaiMemoryPlanner drpai_memory(drpai_area->address, drpai_area->size);
+    const std::optional<uint32_t> model_address = plan_model_memory(drpai_memory, *drpai_area);
+    if (!model_address.has_value())
+    {
+        fprintf(stderr, "[ERROR] DRP-AI memory area exhausted. \n");
+        drpai_memory.report(std::cerr);
+        return -1;
+    }
+    drpai_memory.report(std::cout);
+
     // runtime_status = false
-    runtime_status = runtime.LoadModel(model_dir, drpaimem_addr_start.value() + DRPAI_MEM_OFFSET);
+    runtime.SetProfileInterval(static_cast<uint32_t>(pipeline_config.profile_every_n));
+    runtime_status = runtime.LoadModel(model_dir, model_address.value());
 
     if (!runtime_status)
     {
@@ -607,17 +1064,33 @@ int main(int argc, char **argv)
 
     std::cout << "loaded model:" << model_dir << "\n";
 
+    if (argc == 2 && std::string(argv[1]) == "--bench-batch")
+    {
+        return runBatchBench(runtime, std::cout);
+    }
+    if (argc == 4 && std::string(argv[1]) == "--validate-fp16")
+    {
+        camera_parking_spots.push_back(disk_utils::deserializeROIs(disk_utils::roiFilePath(0)));
+        return validate_fp16(argv[2], argv[3], drpai_memory);
+    }
+
     if (argc == 1)
     {
         std::cout << "Loading from camera input...\n";
-        camera_input = true;
-        filename = "0";
+        inputs.push_back("0");
     }
     else
     {
-        filename = argv[1];
-        camera_input = false;
-        std::cout << "Loading from :" << filename << "\n";
+        // One input per camera of the lot
+        for (int i = 1; i < argc; i++)
+        {
+            inputs.push_back(argv[i]);
+            std::cout << "Loading from :" << inputs.back() << "\n";
+        }
+    }
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        camera_parking_spots.push_back(disk_utils::deserializeROIs(disk_utils::roiFilePath(i)));
     }
     namedWindow(app_name, WINDOW_NORMAL);
     resizeWindow(app_name, 1200, 800);
@@ -646,23 +1119,58 @@ int main(int argc, char **argv)
             destroyAllWindows();
             std::cout << "Running TVM runtime" << std::endl;
 
-            queue<Mat> frames;
-            bool stop = false;
-            thread readThread(read_frames, filename, ref(frames), ref(stop));
+            std::vector<std::unique_ptr<Camera>> cameras;
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                if (!camera_parking_spots[i].empty())
+                {
+                    disk_utils::serializeROIs(camera_parking_spots[i], disk_utils::roiFilePath(i));
+                }
+                cameras.push_back(std::make_unique<Camera>(i, inputs[i], camera_parking_spots[i], pipeline_config));
+            }
+
+            FrameArrivals arrivals;
+            std::atomic<bool> stop{false};
+            std::vector<thread> readThreads;
+            for (auto &camera : cameras)
+            {
+                readThreads.emplace_back(read_frames, ref(*camera), ref(arrivals), ref(stop));
+            }
             cout << "Waiting for read frames to add frames to buffer!" << endl;
-            this_thread::sleep_for(std::chrono::seconds(0));
-            thread processThread(process_frames, ref(frames), ref(stop), producerSocket);
+            thread processThread(process_frames, ref(cameras), ref(arrivals), ref(stop), producerSocket);
             cout << "Processing thread started......" << endl;
             waitKey(0);
-            stop = false;
-            readThread.join();
+            // The processing thread owns the esc key; once it is done, release the readers
             processThread.join();
+            stop = true;
+            for (auto &camera : cameras)
+            {
+                camera->frames.shutdown();
+            }
+            for (auto &readThread : readThreads)
+            {
+                readThread.join();
+            }
+            for (const auto &camera : cameras)
+            {
+                std::cout << "Camera " << camera->index + 1 << " frame ring stats: " << camera->frames.stats() << std::endl;
+                std::cout << "Camera " << camera->index + 1 << " frame source stats: " << *camera->source << std::endl;
+            }
         }
         else
         {
-            if (!parking_spots.empty())
+            size_t slot_count = 0;
+            for (const auto &parking_spots : camera_parking_spots)
             {
-                const std::string slot_text = "Monitoring " + std::to_string(parking_spots.size()) + " slots";
+                slot_count += parking_spots.size();
+            }
+            if (slot_count > 0)
+            {
+                std::string slot_text = "Monitoring " + std::to_string(slot_count) + " slots";
+                if (inputs.size() > 1)
+                {
+                    slot_text += " on " + std::to_string(inputs.size()) + " cameras";
+                }
                 int baseline_slot_text = 0;
                 const auto slot_text_size = getTextSize(slot_text, FONT_HERSHEY_SIMPLEX, SECONDARY_LABEL_SCALE, 2, &baseline_slot_text);
                 putText(frame, slot_text, BUTTON_2_TL - Point(0, baseline_slot_text), FONT_HERSHEY_SIMPLEX, SECONDARY_LABEL_SCALE, WHITE, 2);
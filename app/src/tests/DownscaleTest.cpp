@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "Downscale.h"
+#include "ResamplePlan.h"
+#include "TestUtils.h"
+
+namespace
+{
+    // Odd sizes and ones that leave SIMD tails, from below the patch size up to a close-up spot
+    const cv::Size SOURCE_SIZES[] = {{1, 1}, {3, 2}, {13, 9}, {28, 28}, {29, 31}, {57, 43}, {101, 77}, {333, 211}};
+    // The model's patch, odd and single-pixel outputs, and one beyond MAX_OUTPUT_SIDE that allocates its row buffers
+    const cv::Size OUTPUT_SIZES[] = {{28, 28}, {7, 5}, {1, 1}, {65, 33}};
+    // cv::resize rounds its vectorised and scalar tails differently
+    const int TOLERANCE = 1;
+    const int BORDER = 5;
+
+    int maxDifference(const cv::Mat &a, const cv::Mat &b)
+    {
+        if (a.size() != b.size() || a.type() != b.type())
+        {
+            return 256;
+        }
+        int difference = 0;
+        for (int y = 0; y < a.rows; y++)
+        {
+            const uchar *row_a = a.ptr<uchar>(y);
+            const uchar *row_b = b.ptr<uchar>(y);
+            for (int i = 0; i < a.cols * a.channels(); i++)
+            {
+                difference = std::max(difference, std::abs(row_a[i] - row_b[i]));
+            }
+        }
+        return difference;
+    }
+
+    const char *name(downscale::Kernel kernel)
+    {
+        return kernel == downscale::Kernel::Scalar ? "scalar" : downscale::simdName();
+    }
+
+    /// @brief Every kernel on the ROI views of frame at its corners and centre, against cv::resize
+    ///        and, for bilinear, bit for bit against the scalar kernel
+    void checkViews(const cv::Mat &frame, cv::Size source, cv::Size output, resample::Interpolation interpolation)
+    {
+        const cv::Point corners[] = {{0, 0}, {frame.cols - source.width, frame.rows - source.height}, {BORDER, BORDER},
+                                     {frame.cols - source.width, 0}, {0, frame.rows - source.height}};
+        // Area enlarging along either axis is documented as bilinear
+        const bool area = interpolation == resample::Interpolation::Area && source.width >= output.width && source.height >= output.height;
+
+        for (const auto &corner : corners)
+        {
+            const cv::Rect roi(corner, source);
+            const cv::Mat view = frame(roi);
+            cv::Mat reference;
+            cv::resize(view, reference, output, 0, 0, area ? cv::INTER_AREA : cv::INTER_LINEAR);
+
+            cv::Mat scalar;
+            const resample::Plan plan = resample::buildPlan(roi, output, interpolation);
+            downscale::resize(view, scalar, plan, downscale::Kernel::Scalar);
+
+            for (auto kernel : {downscale::Kernel::Scalar, downscale::Kernel::Simd})
+            {
+                cv::Mat planned, one_off;
+                downscale::resize(view, planned, plan, kernel);
+                if (interpolation == resample::Interpolation::Area)
+                {
+                    downscale::resizeArea(view, one_off, output, kernel);
+                }
+                else
+                {
+                    downscale::resizeBilinear(view, one_off, output, kernel);
+                }
+
+                const bool ok = EXPECT(maxDifference(planned, reference) <= TOLERANCE) &&
+                                EXPECT(maxDifference(one_off, planned) == 0) &&
+                                // Both bilinear paths share their integer arithmetic; area accumulates in float
+                                EXPECT(maxDifference(planned, scalar) <= (area ? TOLERANCE : 0));
+                if (!ok)
+                {
+                    std::cerr << "  " << name(kernel) << " " << resample::to_string(interpolation) << " "
+                              << source.width << "x" << source.height << " at " << corner.x << "," << corner.y
+                              << " -> " << output.width << "x" << output.height << std::endl;
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    cv::RNG rng(2024);
+    std::cout << "downscale kernels: scalar and " << downscale::simdName() << std::endl;
+
+    for (const auto &source : SOURCE_SIZES)
+    {
+        // The views are cut from a larger frame so their rows are strided like a real ROI's
+        cv::Mat frame(source.height + 2 * BORDER, source.width + 2 * BORDER, CV_8UC3);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+        for (const auto &output : OUTPUT_SIZES)
+        {
+            for (auto interpolation : {resample::Interpolation::Bilinear, resample::Interpolation::Area})
+            {
+                checkViews(frame, source, output, interpolation);
+            }
+        }
+    }
+
+    // Saturated extremes must neither wrap nor lose a level to rounding
+    for (int value : {0, 255})
+    {
+        cv::Mat flat(37, 53, CV_8UC3);
+        rng.fill(flat, cv::RNG::UNIFORM, value, value + 1);
+        for (auto kernel : {downscale::Kernel::Scalar, downscale::Kernel::Simd})
+        {
+            cv::Mat bilinear, area;
+            downscale::resizeBilinear(flat, bilinear, cv::Size(28, 28), kernel);
+            downscale::resizeArea(flat, area, cv::Size(28, 28), kernel);
+            cv::Mat expected(28, 28, CV_8UC3);
+            rng.fill(expected, cv::RNG::UNIFORM, value, value + 1);
+            if (!EXPECT(maxDifference(bilinear, expected) == 0) || !EXPECT(maxDifference(area, expected) == 0))
+            {
+                std::cerr << "  " << name(kernel) << " flat " << value << std::endl;
+            }
+        }
+    }
+
+    return test::result("DownscaleTest");
+}
@@ -0,0 +1,516 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "DrpOpInterpreter.h"
+#include "HalfFloat.h"
+#include "TestUtils.h"
+
+namespace
+{
+    // Emulated DRP-AI memory and where each test puts its data in it
+    const uint32_t BASE = 0x90000000;
+    const uint32_t MEMORY_SIZE = 0x100000;
+    const uint32_t PARAMS = BASE;
+    const uint32_t INPUT = BASE + 0x1000;
+    const uint32_t BUFFER_A = BASE + 0x40000;
+    const uint32_t BUFFER_B = BASE + 0x80000;
+    const uint32_t BUFFER_C = BASE + 0xc0000;
+
+    class Memory
+    {
+    public:
+        Memory() : bytes(MEMORY_SIZE) {}
+
+        uint8_t *at(uint32_t address) { return bytes.data() + (address - BASE); }
+        template <typename T>
+        T *as(uint32_t address) { return reinterpret_cast<T *>(at(address)); }
+
+        DrpOpInterpreter::MemoryMap map()
+        {
+            return [this](uint32_t address, uint32_t size) -> uint8_t *
+            {
+                if (address < BASE || static_cast<uint64_t>(address - BASE) + size > MEMORY_SIZE)
+                {
+                    return nullptr;
+                }
+                return at(address);
+            };
+        }
+
+    private:
+        std::vector<uint8_t> bytes;
+    };
+
+    /// @brief An op list and the drp_param.bin it reads, laid out as PreRuntime parses them
+    class OpList
+    {
+    public:
+        OpList &op(const char *name, const char *lib)
+        {
+            s_op_t op;
+            op.name = name;
+            op.lib = lib;
+            op.offset = static_cast<uint16_t>(params.size());
+            ops.push_back(op);
+            return *this;
+        }
+
+        OpList &param(const char *name, uint32_t value, uint16_t size = 2)
+        {
+            s_op_param_t entry;
+            entry.name = name;
+            entry.value = value;
+            entry.offset = static_cast<uint16_t>(params.size() - ops.back().offset);
+            entry.size = size;
+            ops.back().param_list.push_back(entry);
+            for (uint16_t i = 0; i < size; i++)
+            {
+                params.push_back(static_cast<uint8_t>(value >> (8 * i)));
+            }
+            return *this;
+        }
+
+        /// @brief raddr and waddr, which lead every op's parameters
+        OpList &addresses(uint32_t raddr, uint32_t waddr)
+        {
+            return param(P_RADDR, raddr, 4).param(P_WADDR, waddr, 4);
+        }
+
+        /// @brief Writes the params to memory and runs the list on input, as DRPAI_START would
+        uint8_t run(Memory &memory, uint32_t input = INPUT, uint32_t params_address = PARAMS)
+        {
+            if (params_address == PARAMS)
+            {
+                std::memcpy(memory.at(PARAMS), params.data(), params.size());
+            }
+            drpai_data_t proc[DRPAI_INDEX_NUM] = {};
+            proc[DRPAI_INDEX_INPUT] = {input, 0};
+            proc[DRPAI_INDEX_DRP_PARAM] = {params_address, static_cast<uint32_t>(params.size())};
+            return DrpOpInterpreter(ops).Run(proc, memory.map());
+        }
+
+        std::vector<s_op_t> ops;
+        std::vector<uint8_t> params;
+    };
+
+    cv::Mat randomImage(cv::Size size, int type, cv::RNG &rng)
+    {
+        cv::Mat image(size, type);
+        rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+        return image;
+    }
+
+    /// @brief Copies image into memory at address, rows packed
+    void store(Memory &memory, uint32_t address, const cv::Mat &image)
+    {
+        const size_t row = image.cols * image.elemSize();
+        for (int y = 0; y < image.rows; y++)
+        {
+            std::memcpy(memory.at(address) + y * row, image.ptr(y), row);
+        }
+    }
+
+    bool equals(Memory &memory, uint32_t address, const cv::Mat &expected)
+    {
+        const size_t row = expected.cols * expected.elemSize();
+        for (int y = 0; y < expected.rows; y++)
+        {
+            if (0 != std::memcmp(memory.at(address) + y * row, expected.ptr(y), row))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void checkResize(cv::RNG &rng)
+    {
+        const cv::Size in_size(37, 23), out_size(28, 28);
+        const cv::Mat src = randomImage(in_size, CV_8UC3, rng);
+        for (auto algorithm : {ALG_NEAREST, ALG_BILINEAR})
+        {
+            Memory memory;
+            store(memory, INPUT, src);
+            OpList list;
+            // drp_param_info.txt spells the input width IMG_IWIDHT
+            list.op("resize", LIB_RESIZE_HWC).addresses(0, BUFFER_A).param("IMG_IWIDHT", in_size.width).param(P_IMG_IHEIGHT, in_size.height)
+                .param(P_IMG_ICH, 3).param(P_IMG_OWIDTH, out_size.width).param(P_IMG_OHEIGHT, out_size.height)
+                .param(P_RESIZE_ALG, algorithm).param(P_DATA_TYPE, 0);
+            EXPECT(list.run(memory) == PRE_SUCCESS);
+
+            cv::Mat expected;
+            cv::resize(src, expected, out_size, 0, 0, algorithm == ALG_NEAREST ? cv::INTER_NEAREST : cv::INTER_LINEAR);
+            if (!EXPECT(equals(memory, BUFFER_A, expected)))
+            {
+                std::cerr << "  resize_hwc uint8, RESIZE_ALG " << algorithm << std::endl;
+            }
+        }
+
+        // fp16 elements go through fp32 and back
+        Memory memory;
+        std::vector<float> values(static_cast<size_t>(in_size.area()) * 3);
+        for (auto &value : values)
+        {
+            value = rng.uniform(-2.0f, 2.0f);
+        }
+        half_float::fromFloat(values.data(), memory.as<uint16_t>(INPUT), values.size());
+        OpList list;
+        list.op("resize", LIB_RESIZE_HWC).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, in_size.width).param(P_IMG_IHEIGHT, in_size.height)
+            .param(P_IMG_ICH, 3).param(P_IMG_OWIDTH, out_size.width).param(P_IMG_OHEIGHT, out_size.height)
+            .param(P_RESIZE_ALG, ALG_BILINEAR).param(P_DATA_TYPE, 1);
+        EXPECT(list.run(memory) == PRE_SUCCESS);
+
+        half_float::toFloat(memory.as<uint16_t>(INPUT), values.data(), values.size());
+        cv::Mat expected;
+        cv::resize(cv::Mat(in_size, CV_32FC3, values.data()), expected, out_size, 0, 0, cv::INTER_LINEAR);
+        std::vector<float> out(static_cast<size_t>(out_size.area()) * 3);
+        half_float::toFloat(memory.as<uint16_t>(BUFFER_A), out.data(), out.size());
+        float difference = 0.0f;
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            difference = std::max(difference, std::abs(out[i] - expected.ptr<float>()[i]));
+        }
+        // Half an fp16 ULP at 2
+        EXPECT(difference <= 1e-3f);
+    }
+
+    void checkConvYuv2Rgb(cv::RNG &rng)
+    {
+        const cv::Size size(16, 8);
+        const struct
+        {
+            uint16_t format;
+            int type;
+            int rows;
+            int rgb;
+            int bgr;
+        } CASES[] = {
+            {FORMAT_YUYV_422, CV_8UC2, 8, cv::COLOR_YUV2RGB_YUYV, cv::COLOR_YUV2BGR_YUYV},
+            {FORMAT_YVYU_422, CV_8UC2, 8, cv::COLOR_YUV2RGB_YVYU, cv::COLOR_YUV2BGR_YVYU},
+            {FORMAT_UYUV_422, CV_8UC2, 8, cv::COLOR_YUV2RGB_UYVY, cv::COLOR_YUV2BGR_UYVY},
+            {FORMAT_NV12_420, CV_8UC1, 12, cv::COLOR_YUV2RGB_NV12, cv::COLOR_YUV2BGR_NV12},
+            {FORMAT_NV21_420, CV_8UC1, 12, cv::COLOR_YUV2RGB_NV21, cv::COLOR_YUV2BGR_NV21},
+        };
+        for (const auto &test_case : CASES)
+        {
+            const cv::Mat src = randomImage(cv::Size(size.width, test_case.rows), test_case.type, rng);
+            for (uint32_t bgr : {0u, 1u})
+            {
+                Memory memory;
+                store(memory, INPUT, src);
+                OpList list;
+                list.op("yuv2rgb", LIB_CONVYUV2RGB).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+                    .param(P_INPUT_YUV_FORMAT, test_case.format).param(P_DOUT_RGB_FORMAT, bgr);
+                EXPECT(list.run(memory) == PRE_SUCCESS);
+
+                cv::Mat expected;
+                cv::cvtColor(src, expected, bgr == 1 ? test_case.bgr : test_case.rgb);
+                if (!EXPECT(equals(memory, BUFFER_A, expected)))
+                {
+                    std::cerr << "  conv_yuv2rgb format " << test_case.format << ", DOUT_RGB_FORMAT " << bgr << std::endl;
+                }
+            }
+        }
+
+        Memory memory;
+        OpList list;
+        list.op("yuv2rgb", LIB_CONVYUV2RGB).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+            .param(P_INPUT_YUV_FORMAT, FORMAT_IMC1_420);
+        EXPECT(list.run(memory) == PRE_ERROR);
+    }
+
+    void checkConvX2Gray(cv::RNG &rng)
+    {
+        const cv::Size size(16, 8);
+        const cv::Mat packed = randomImage(size, CV_8UC2, rng);
+        const cv::Mat semi_planar = randomImage(cv::Size(size.width, size.height * 3 / 2), CV_8UC1, rng);
+        const cv::Mat bgr = randomImage(size, CV_8UC3, rng);
+
+        cv::Mat yuyv_luma, uyvy_luma, bgr_luma, rgb_luma;
+        cv::extractChannel(packed, yuyv_luma, 0);
+        cv::extractChannel(packed, uyvy_luma, 1);
+        cv::cvtColor(bgr, bgr_luma, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(bgr, rgb_luma, cv::COLOR_RGB2GRAY);
+        const cv::Mat nv12_luma = semi_planar(cv::Rect(0, 0, size.width, size.height));
+
+        const struct
+        {
+            uint32_t format;
+            const cv::Mat &src;
+            const cv::Mat &expected;
+        } CASES[] = {
+            {FORMAT_YUYV_422, packed, yuyv_luma},
+            {FORMAT_UYUV_422, packed, uyvy_luma},
+            {FORMAT_NV12_420, semi_planar, nv12_luma},
+            {DIN_FORMAT_BGR, bgr, bgr_luma},
+            {DIN_FORMAT_RGB, bgr, rgb_luma},
+        };
+        for (const auto &test_case : CASES)
+        {
+            Memory memory;
+            store(memory, INPUT, test_case.src);
+            OpList list;
+            list.op("gray", LIB_CONVX2GRAY).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+                .param(P_DIN_FORMAT, test_case.format);
+            EXPECT(list.run(memory) == PRE_SUCCESS);
+            if (!EXPECT(equals(memory, BUFFER_A, test_case.expected)))
+            {
+                std::cerr << "  conv_x2gray DIN_FORMAT " << test_case.format << std::endl;
+            }
+        }
+    }
+
+    void checkCrop(cv::RNG &rng)
+    {
+        const cv::Size size(20, 10);
+        const cv::Mat src = randomImage(size, CV_8UC3, rng);
+        auto crop = [&](Memory &memory, uint32_t x, uint32_t y, cv::Size out_size)
+        {
+            store(memory, INPUT, src);
+            OpList list;
+            list.op("crop", LIB_CROP).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+                .param(P_IMG_ICH, 3).param(P_IMG_OWIDTH, out_size.width).param(P_IMG_OHEIGHT, out_size.height)
+                .param(P_CROP_POS_X, x).param(P_CROP_POS_Y, y).param(P_DATA_TYPE, 0);
+            return list.run(memory);
+        };
+
+        Memory memory;
+        EXPECT(crop(memory, 3, 2, cv::Size(8, 5)) == PRE_SUCCESS);
+        cv::Mat expected;
+        src(cv::Rect(3, 2, 8, 5)).copyTo(expected);
+        EXPECT(equals(memory, BUFFER_A, expected));
+        // Up to the far corner is fine, a pixel beyond it is not
+        EXPECT(crop(memory, 12, 5, cv::Size(8, 5)) == PRE_SUCCESS);
+        EXPECT(crop(memory, 13, 5, cv::Size(8, 5)) == PRE_ERROR);
+    }
+
+    void checkImageScaler(cv::RNG &rng)
+    {
+        const cv::Size size(5, 3);
+        const size_t count = static_cast<size_t>(size.area()) * 3;
+        const float add[3] = {-0.485f * 255, -0.456f * 255, -0.406f * 255};
+        const float mul[3] = {1 / (0.229f * 255), 1 / (0.224f * 255), 1 / (0.225f * 255)};
+        const cv::Mat src = randomImage(size, CV_8UC3, rng);
+
+        for (uint32_t half_in : {0u, 1u})
+        {
+            Memory memory;
+            half_float::fromFloat(add, memory.as<uint16_t>(BUFFER_B), 3);
+            half_float::fromFloat(mul, memory.as<uint16_t>(BUFFER_B + 8), 3);
+            if (half_in)
+            {
+                std::vector<float> values(src.ptr<uchar>(), src.ptr<uchar>() + count);
+                half_float::fromFloat(values.data(), memory.as<uint16_t>(INPUT), count);
+            }
+            else
+            {
+                store(memory, INPUT, src);
+            }
+            OpList list;
+            list.op("scale", LIB_IMAGESCALER).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+                .param(P_IMG_ICH, 3).param(P_ADD_ADDR, BUFFER_B, 4).param(P_MUL_ADDR, BUFFER_B + 8, 4)
+                .param(P_DIN_FORMAT, half_in).param(P_DOUT_RGB_ORDER, 1);
+            EXPECT(list.run(memory) == PRE_SUCCESS);
+
+            // The coefficients as the DRP-AI holds them, in fp16
+            float add_half[3], mul_half[3];
+            half_float::toFloat(memory.as<uint16_t>(BUFFER_B), add_half, 3);
+            half_float::toFloat(memory.as<uint16_t>(BUFFER_B + 8), mul_half, 3);
+            std::vector<float> out(count);
+            half_float::toFloat(memory.as<uint16_t>(BUFFER_A), out.data(), count);
+            float difference = 0.0f;
+            for (size_t p = 0; p < count; p += 3)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    // DOUT_RGB_ORDER 1 turns BGR into RGB
+                    const float expected = (src.ptr<uchar>()[p + 2 - c] + add_half[c]) * mul_half[c];
+                    difference = std::max(difference, std::abs(out[p + c] - expected));
+                }
+            }
+            if (!EXPECT(difference <= 2e-3f))
+            {
+                std::cerr << "  imagescaler DIN_FORMAT " << half_in << ": " << difference << std::endl;
+            }
+        }
+    }
+
+    void checkTranspose()
+    {
+        const cv::Size size(7, 5);
+        const int channels = 3;
+        const size_t plane = static_cast<size_t>(size.area());
+
+        // HWC to CHW on 2-byte words
+        Memory memory;
+        for (size_t i = 0; i < plane * channels; i++)
+        {
+            memory.as<uint16_t>(INPUT)[i] = static_cast<uint16_t>(i * 7 + 1);
+        }
+        OpList to_chw;
+        to_chw.op("transpose", LIB_TRANSPOSE).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+            .param(P_IMG_ICH, channels).param(P_WORD_SIZE, 1);
+        EXPECT(to_chw.run(memory) == PRE_SUCCESS);
+        bool planar = true;
+        for (size_t p = 0; p < plane; p++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                planar = planar && memory.as<uint16_t>(BUFFER_A)[c * plane + p] == memory.as<uint16_t>(INPUT)[p * channels + c];
+            }
+        }
+        EXPECT(planar);
+
+        // And back, on 4-byte words
+        for (size_t i = 0; i < plane * channels; i++)
+        {
+            memory.as<int32_t>(INPUT)[i] = static_cast<int32_t>(i * 100003);
+        }
+        OpList to_hwc;
+        to_hwc.op("transpose", LIB_TRANSPOSE).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, size.width).param(P_IMG_IHEIGHT, size.height)
+            .param(P_IMG_ICH, channels).param(P_WORD_SIZE, 2).param(P_IS_CHW2HWC, 1);
+        EXPECT(to_hwc.run(memory) == PRE_SUCCESS);
+        bool interleaved = true;
+        for (size_t p = 0; p < plane; p++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                interleaved = interleaved && memory.as<int32_t>(BUFFER_A)[p * channels + c] == memory.as<int32_t>(INPUT)[c * plane + p];
+            }
+        }
+        EXPECT(interleaved);
+    }
+
+    void checkCast()
+    {
+        const size_t count = 4 * 3 * 3;
+        std::vector<float> values(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            values[i] = (static_cast<float>(i) - 17.0f) / 7.0f;
+        }
+
+        Memory memory;
+        half_float::fromFloat(values.data(), memory.as<uint16_t>(INPUT), count);
+        OpList widen;
+        widen.op("cast", LIB_CASTFP16_FP32).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, 4).param(P_IMG_IHEIGHT, 3)
+            .param(P_IMG_ICH, 3).param(P_CAST_MODE, 0);
+        EXPECT(widen.run(memory) == PRE_SUCCESS);
+        std::vector<float> widened(count);
+        half_float::toFloat(memory.as<uint16_t>(INPUT), widened.data(), count);
+        EXPECT(0 == std::memcmp(memory.at(BUFFER_A), widened.data(), count * sizeof(float)));
+
+        std::memcpy(memory.at(INPUT), values.data(), count * sizeof(float));
+        OpList narrow;
+        narrow.op("cast", LIB_CASTFP16_FP32).addresses(0, BUFFER_A).param(P_IMG_IWIDTH, 4).param(P_IMG_IHEIGHT, 3)
+            .param(P_IMG_ICH, 3).param(P_CAST_MODE, 1);
+        EXPECT(narrow.run(memory) == PRE_SUCCESS);
+        std::vector<uint16_t> narrowed(count);
+        half_float::fromFloat(values.data(), narrowed.data(), count);
+        EXPECT(0 == std::memcmp(memory.at(BUFFER_A), narrowed.data(), count * sizeof(uint16_t)));
+    }
+
+    /// @brief The parking model's preprocessing: resize, normalise, HWC to CHW and widen, each op
+    ///        reading what the one before wrote and the first reading DRPAI_START's input
+    void checkChain(cv::RNG &rng)
+    {
+        const cv::Size in_size(64, 48), out_size(28, 28);
+        const size_t count = static_cast<size_t>(out_size.area()) * 3;
+        const float add[3] = {-10.0f, -20.0f, -30.0f};
+        const float mul[3] = {1 / 255.0f, 1 / 128.0f, 1 / 64.0f};
+        const cv::Mat src = randomImage(in_size, CV_8UC3, rng);
+
+        Memory memory;
+        store(memory, INPUT + 0x8000, src);
+        half_float::fromFloat(add, memory.as<uint16_t>(BUFFER_C), 3);
+        half_float::fromFloat(mul, memory.as<uint16_t>(BUFFER_C + 8), 3);
+        OpList list;
+        // raddr of the first op is never read: DRPAI_START says where the input is
+        list.op("resize", LIB_RESIZE_HWC).addresses(INPUT, BUFFER_A).param(P_IMG_IWIDTH, in_size.width).param(P_IMG_IHEIGHT, in_size.height)
+            .param(P_IMG_ICH, 3).param(P_IMG_OWIDTH, out_size.width).param(P_IMG_OHEIGHT, out_size.height)
+            .param(P_RESIZE_ALG, ALG_BILINEAR).param(P_DATA_TYPE, 0);
+        list.op("scale", LIB_IMAGESCALER).addresses(BUFFER_A, BUFFER_B).param(P_IMG_IWIDTH, out_size.width).param(P_IMG_IHEIGHT, out_size.height)
+            .param(P_IMG_ICH, 3).param(P_ADD_ADDR, BUFFER_C, 4).param(P_MUL_ADDR, BUFFER_C + 8, 4).param(P_DIN_FORMAT, 0).param(P_DOUT_RGB_ORDER, 1);
+        list.op("transpose", LIB_TRANSPOSE).addresses(BUFFER_B, BUFFER_A).param(P_IMG_IWIDTH, out_size.width).param(P_IMG_IHEIGHT, out_size.height)
+            .param(P_IMG_ICH, 3).param(P_WORD_SIZE, 1);
+        list.op("cast", LIB_CASTFP16_FP32).addresses(BUFFER_A, BUFFER_B).param(P_IMG_IWIDTH, out_size.width).param(P_IMG_IHEIGHT, out_size.height)
+            .param(P_IMG_ICH, 3).param(P_CAST_MODE, 0);
+        EXPECT(DrpOpInterpreter(list.ops).IsSupported());
+        EXPECT(list.run(memory, INPUT + 0x8000) == PRE_SUCCESS);
+
+        cv::Mat resized;
+        cv::resize(src, resized, out_size, 0, 0, cv::INTER_LINEAR);
+        float add_half[3], mul_half[3];
+        half_float::toFloat(memory.as<uint16_t>(BUFFER_C), add_half, 3);
+        half_float::toFloat(memory.as<uint16_t>(BUFFER_C + 8), mul_half, 3);
+        std::vector<float> expected(count);
+        const size_t plane = static_cast<size_t>(out_size.area());
+        for (size_t p = 0; p < plane; p++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                expected[c * plane + p] = (resized.ptr<uchar>()[p * 3 + 2 - c] + add_half[c]) * mul_half[c];
+            }
+        }
+        // The scaler stores fp16, so the reference goes through it too
+        std::vector<uint16_t> half(count);
+        half_float::fromFloat(expected.data(), half.data(), count);
+        half_float::toFloat(half.data(), expected.data(), count);
+        EXPECT(0 == std::memcmp(memory.at(BUFFER_B), expected.data(), count * sizeof(float)));
+    }
+
+    void checkErrors()
+    {
+        EXPECT(!DrpOpInterpreter({}).IsSupported());
+
+        Memory memory;
+        OpList unsupported;
+        unsupported.op("argmax", LIB_ARGMINMAX).addresses(0, BUFFER_A);
+        EXPECT(!DrpOpInterpreter(unsupported.ops).IsSupported());
+        EXPECT(unsupported.run(memory) == PRE_ERROR);
+
+        auto resize = [](uint32_t waddr, bool with_height)
+        {
+            OpList list;
+            list.op("resize", LIB_RESIZE_HWC).addresses(0, waddr).param(P_IMG_IWIDTH, 8).param(P_IMG_IHEIGHT, 8)
+                .param(P_IMG_ICH, 3).param(P_IMG_OWIDTH, 4).param(P_RESIZE_ALG, ALG_BILINEAR);
+            if (with_height)
+            {
+                list.param(P_IMG_OHEIGHT, 4);
+            }
+            return list;
+        };
+        EXPECT(resize(BUFFER_A, true).run(memory) == PRE_SUCCESS);
+        // Output past the end of DRP-AI memory, a missing parameter, input outside it, and
+        // a param block that is not in it
+        EXPECT(resize(BASE + MEMORY_SIZE - 8, true).run(memory) == PRE_ERROR);
+        EXPECT(resize(BUFFER_A, false).run(memory) == PRE_ERROR);
+        EXPECT(resize(BUFFER_A, true).run(memory, BASE - 0x1000) == PRE_ERROR);
+        EXPECT(resize(BUFFER_A, true).run(memory, INPUT, BASE + MEMORY_SIZE) == PRE_ERROR);
+
+        // A parameter that lies beyond drp_param.bin
+        OpList truncated = resize(BUFFER_A, true);
+        truncated.ops.back().param_list.back().offset = 0x400;
+        EXPECT(truncated.run(memory) == PRE_ERROR);
+    }
+}
+
+int main()
+{
+    cv::RNG rng(2024);
+    checkResize(rng);
+    checkConvYuv2Rgb(rng);
+    checkConvX2Gray(rng);
+    checkCrop(rng);
+    checkImageScaler(rng);
+    checkTranspose();
+    checkCast();
+    checkChain(rng);
+    checkErrors();
+    return test::result("DrpOpInterpreterTest");
+}
@@ -0,0 +1,159 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DrpaiMemoryPlanner.h"
+#include "TestUtils.h"
+
+namespace
+{
+    const uint32_t AREA = 0x80000000;
+    const uint32_t AREA_SIZE = 0x10000;
+
+    bool placedAt(const std::optional<uint32_t> &address, uint32_t expected)
+    {
+        return address.has_value() && *address == expected;
+    }
+
+    /// @brief An address map whose entries end at last_end, starting at first_address
+    void writeAddressMap(const std::string &path, uint32_t first_address, uint32_t last_end)
+    {
+        std::ofstream ofs(path);
+        ofs << std::hex;
+        ofs << "drp_config " << first_address << " 1000" << std::endl;
+        ofs << "desc_aimac " << first_address + 0x1000 << " 100" << std::endl;
+        ofs << "weight " << first_address + 0x1140 << " " << last_end - first_address - 0x1140 << std::endl;
+    }
+
+    void checkAllocate()
+    {
+        DrpaiMemoryPlanner planner(AREA, AREA_SIZE);
+        EXPECT(planner.free_bytes() == AREA_SIZE);
+        EXPECT(planner.largest_free() == AREA_SIZE);
+
+        // First fit from the start of the area, every start aligned
+        EXPECT(placedAt(planner.allocate("a", 0x1010), AREA));
+        EXPECT(placedAt(planner.allocate("b", 0x100), AREA + 0x1040));
+        EXPECT(placedAt(planner.allocate("c", 0x20, 0x1000), AREA + 0x2000));
+        // Into the gap alignment left behind b
+        EXPECT(placedAt(planner.allocate("d", 0x40), AREA + 0x1140));
+        EXPECT(planner.regions().size() == 4);
+        EXPECT(planner.free_bytes() == AREA_SIZE - 0x1010 - 0x100 - 0x20 - 0x40);
+        EXPECT(planner.largest_free() == AREA_SIZE - 0x2020);
+        EXPECT(planner.error().empty());
+
+        // A failure leaves the plan as it was and says why
+        EXPECT(!planner.allocate("huge", AREA_SIZE).has_value());
+        EXPECT(planner.regions().size() == 4);
+        EXPECT(planner.error().find("huge") != std::string::npos);
+        // What is left can still be had, to the last byte
+        EXPECT(placedAt(planner.allocate("rest", AREA_SIZE - 0x2040), AREA + 0x2040));
+        EXPECT(planner.largest_free() == 0x1000 - 0x180);
+        EXPECT(!planner.allocate("one more", 0x1000).has_value());
+    }
+
+    void checkReserve()
+    {
+        DrpaiMemoryPlanner planner(AREA, AREA_SIZE);
+        EXPECT(placedAt(planner.reserve("top", AREA + 0xf000, 0x1000), AREA + 0xf000));
+        EXPECT(placedAt(planner.reserve("middle", AREA + 0x4000, 0x1000), AREA + 0x4000));
+        EXPECT(planner.regions().front().name == "middle");
+
+        // Overlapping the region after, the one before, or reaching outside the area
+        EXPECT(!planner.reserve("before middle", AREA + 0x3000, 0x1001).has_value());
+        EXPECT(planner.error().find("middle") != std::string::npos);
+        EXPECT(!planner.reserve("inside middle", AREA + 0x4800, 0x100).has_value());
+        EXPECT(!planner.reserve("after middle", AREA + 0x4fff, 0x10).has_value());
+        EXPECT(!planner.reserve("below", AREA - 0x100, 0x200).has_value());
+        EXPECT(!planner.reserve("above", AREA + 0xff00, 0x200).has_value());
+        EXPECT(planner.regions().size() == 2);
+        // Touching is not overlapping
+        EXPECT(placedAt(planner.reserve("adjacent", AREA + 0x5000, 0x1000), AREA + 0x5000));
+
+        // allocate() fills around reserved regions
+        EXPECT(placedAt(planner.allocate("low", 0x4000), AREA));
+        EXPECT(placedAt(planner.allocate("next", 0x2000), AREA + 0x6000));
+        EXPECT(!planner.allocate("too big", 0x8000).has_value());
+    }
+
+    /// @brief An area ending at the top of the 32-bit address space must not wrap
+    void checkTopOfAddressSpace()
+    {
+        DrpaiMemoryPlanner planner(0xffff0000, 0x10000);
+        EXPECT(placedAt(planner.allocate("all", 0x10000), 0xffff0000));
+        EXPECT(planner.free_bytes() == 0);
+        EXPECT(!planner.allocate("more", 0x40).has_value());
+        EXPECT(!planner.reserve("wrap", 0xfffffff0, 0x20).has_value());
+    }
+
+    void checkFootprints(const std::string &root)
+    {
+        const std::string model = root + "/model";
+        mkdir(model.c_str(), 0755);
+        mkdir((model + "/preprocess").c_str(), 0755);
+        mkdir((model + "/sub_0000").c_str(), 0755);
+        mkdir((model + "/sub_0001").c_str(), 0755);
+        // The model's PreRuntime bundle has its own region, so it is not counted
+        writeAddressMap(model + "/preprocess/pp_addrmap_intm.txt", 0, 0x80000);
+        writeAddressMap(model + "/sub_0000/sub_0000_addrmap_intm.txt", 0, 0x3000);
+        writeAddressMap(model + "/sub_0001/sub_0001_addrmap_intm.txt", 0, 0x2040);
+        EXPECT(placedAt(DrpaiMemoryPlanner::modelFootprint(model), 0x5040));
+
+        EXPECT(placedAt(DrpaiMemoryPlanner::preRuntimeFootprint(model + "/preprocess"), 0x80000));
+        EXPECT(placedAt(DrpaiMemoryPlanner::preRuntimeFootprint(model + "/preprocess/"), 0x80000));
+
+        // PreRuntime Compile output names its files after the directory, relative to the working one
+        char cwd[4096];
+        EXPECT(getcwd(cwd, sizeof(cwd)) != nullptr);
+        EXPECT(0 == chdir(root.c_str()));
+        mkdir("bundle", 0755);
+        writeAddressMap("bundle/bundle_addrmap_intm.txt", 0, 0x1340);
+        EXPECT(placedAt(DrpaiMemoryPlanner::preRuntimeFootprint("bundle"), 0x1340));
+        EXPECT(0 == chdir(cwd));
+
+        // Not relocatable, no maps at all, or no directory: nothing to plan from
+        const std::string fixed = root + "/fixed";
+        mkdir(fixed.c_str(), 0755);
+        mkdir((fixed + "/sub_0000").c_str(), 0755);
+        writeAddressMap(fixed + "/sub_0000/sub_0000_addrmap_intm.txt", 0x1000, 0x3000);
+        EXPECT(!DrpaiMemoryPlanner::modelFootprint(fixed).has_value());
+        EXPECT(!DrpaiMemoryPlanner::modelFootprint(model + "/preprocess").has_value());
+        EXPECT(!DrpaiMemoryPlanner::modelFootprint(root + "/missing").has_value());
+        EXPECT(!DrpaiMemoryPlanner::preRuntimeFootprint(root + "/missing").has_value());
+    }
+
+    void checkReport()
+    {
+        DrpaiMemoryPlanner planner(AREA, AREA_SIZE);
+        planner.allocate("model", 0x4000);
+        planner.allocate("too big", 0x20000);
+        std::ostringstream os;
+        planner.report(os);
+        const std::string report = os.str();
+        EXPECT(report.find("model") != std::string::npos);
+        EXPECT(report.find("free") != std::string::npos);
+        EXPECT(report.find("failed: too big") != std::string::npos);
+    }
+}
+
+int main()
+{
+    checkAllocate();
+    checkReserve();
+    checkTopOfAddressSpace();
+    checkReport();
+
+    char root[] = "/tmp/DrpaiMemoryPlannerTest.XXXXXX";
+    if (!EXPECT(mkdtemp(root) != nullptr))
+    {
+        return test::result("DrpaiMemoryPlannerTest");
+    }
+    checkFootprints(root);
+    const std::string cleanup = std::string("rm -rf ") + root;
+    std::system(cleanup.c_str());
+    return test::result("DrpaiMemoryPlannerTest");
+}
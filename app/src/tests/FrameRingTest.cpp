@@ -0,0 +1,213 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "FrameRing.h"
+#include "PipelineConfig.h"
+#include "TestUtils.h"
+
+namespace
+{
+    const int STRESS_FRAMES = 200000;
+
+    /// @brief Pops everything queued, in order
+    std::vector<int> drain(FrameRing<int> &ring)
+    {
+        std::vector<int> frames;
+        int frame = 0;
+        while (ring.pop(frame))
+        {
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    void checkBlock()
+    {
+        FrameRing<int> ring(3, OverflowPolicy::Block);
+        for (int i = 1; i <= 3; i++)
+        {
+            EXPECT(!ring.push(int(i)).has_value());
+        }
+        EXPECT(ring.size() == 3);
+        EXPECT((drain(ring) == std::vector<int>{1, 2, 3}));
+
+        const FrameRingStats stats = ring.stats();
+        EXPECT(stats.enqueued == 3);
+        EXPECT(stats.dropped == 0);
+        EXPECT(stats.high_water_mark == 3);
+    }
+
+    void checkDropNewest()
+    {
+        FrameRing<int> ring(2, OverflowPolicy::DropNewest);
+        EXPECT(!ring.push(1).has_value());
+        EXPECT(!ring.push(2).has_value());
+        // The incoming frame is the one handed back
+        const std::optional<int> rejected = ring.push(3);
+        EXPECT(rejected.has_value() && *rejected == 3);
+        EXPECT((drain(ring) == std::vector<int>{1, 2}));
+        EXPECT(ring.stats().enqueued == 2);
+        EXPECT(ring.stats().dropped == 1);
+    }
+
+    void checkDropOldest()
+    {
+        FrameRing<int> ring(2, OverflowPolicy::DropOldest);
+        EXPECT(!ring.push(1).has_value());
+        EXPECT(!ring.push(2).has_value());
+        // Each push into a full ring evicts exactly the oldest frame and hands it back
+        for (int i = 3; i <= 6; i++)
+        {
+            const std::optional<int> evicted = ring.push(int(i));
+            EXPECT(evicted.has_value() && *evicted == i - 2);
+            EXPECT(ring.size() == 2);
+        }
+        EXPECT((drain(ring) == std::vector<int>{5, 6}));
+        EXPECT(ring.stats().enqueued == 6);
+        EXPECT(ring.stats().dropped == 4);
+        EXPECT(ring.stats().high_water_mark == 2);
+    }
+
+    void checkShutdown()
+    {
+        FrameRing<int> ring(1, OverflowPolicy::Block);
+        EXPECT(!ring.push(1).has_value());
+
+        // A producer blocked on a full ring is woken by shutdown and gets its frame back
+        std::optional<int> returned;
+        std::thread producer([&]
+                             { returned = ring.push(2); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.shutdown();
+        producer.join();
+        EXPECT(returned.has_value() && *returned == 2);
+
+        // Frames queued before shutdown can still be taken; pushes after it are refused
+        const std::optional<int> refused = ring.push(3);
+        EXPECT(refused.has_value() && *refused == 3);
+        int frame = 0;
+        EXPECT(ring.pop_wait(frame, std::chrono::seconds(1)) && frame == 1);
+
+        // An empty, shut down ring doesn't make pop_wait sit out its timeout
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT(!ring.pop_wait(frame, std::chrono::seconds(5)));
+        EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    }
+
+    void checkPopWait()
+    {
+        FrameRing<int> ring(2, OverflowPolicy::Block);
+        int frame = 0;
+        EXPECT(!ring.pop_wait(frame, std::chrono::milliseconds(10)));
+
+        std::thread producer([&]
+                             {
+                                 std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                                 ring.push(7); });
+        EXPECT(ring.pop_wait(frame, std::chrono::seconds(5)) && frame == 7);
+        producer.join();
+    }
+
+    /// @brief One producer and one consumer under policy: every frame is either consumed, in
+    ///        order, or handed back to the producer, exactly once
+    void checkConcurrent(OverflowPolicy policy)
+    {
+        FrameRing<int> ring(4, policy);
+        std::vector<int> handed_back;
+        // Frames handed back after they had been queued, as opposed to rejected on arrival
+        size_t evicted = 0;
+        std::thread producer([&]
+                             {
+                                 for (int i = 0; i < STRESS_FRAMES; i++)
+                                 {
+                                     if (const std::optional<int> returned = ring.push(int(i)))
+                                     {
+                                         handed_back.push_back(*returned);
+                                         evicted += *returned != i;
+                                     }
+                                 }
+                                 ring.shutdown(); });
+
+        std::vector<int> consumed;
+        int frame = 0;
+        while (true)
+        {
+            if (ring.pop_wait(frame, std::chrono::milliseconds(100)))
+            {
+                consumed.push_back(frame);
+            }
+            else if (ring.is_shutdown() && ring.size() == 0)
+            {
+                break;
+            }
+        }
+        producer.join();
+
+        std::vector<int> seen(STRESS_FRAMES, 0);
+        bool ordered = true;
+        for (size_t i = 0; i < consumed.size(); i++)
+        {
+            ordered = ordered && (i == 0 || consumed[i] > consumed[i - 1]);
+            seen[consumed[i]]++;
+        }
+        for (int returned : handed_back)
+        {
+            seen[returned]++;
+        }
+        bool exactly_once = true;
+        for (int count : seen)
+        {
+            exactly_once = exactly_once && count == 1;
+        }
+
+        const FrameRingStats stats = ring.stats();
+        const bool ok = EXPECT(ordered) && EXPECT(exactly_once) &&
+                        EXPECT(policy != OverflowPolicy::Block || handed_back.empty()) &&
+                        EXPECT(stats.dropped == handed_back.size()) &&
+                        EXPECT(stats.enqueued == consumed.size() + evicted) &&
+                        EXPECT(stats.high_water_mark <= ring.capacity());
+        if (!ok)
+        {
+            std::cerr << "  " << to_string(policy) << ": consumed " << consumed.size() << ", handed back " << handed_back.size()
+                      << " (" << evicted << " evicted), stats " << stats << std::endl;
+        }
+    }
+
+    /// @brief SPARK_FRAME_RING_CAPACITY keeps the default unless it is a whole number in 1..1024
+    void checkCapacityFromEnvironment()
+    {
+        const size_t default_capacity = PipelineConfig().frame_ring_capacity;
+        for (const char *invalid : {"-1", "0", "8x", "2048", "18446744073709551615", "abc"})
+        {
+            setenv("SPARK_FRAME_RING_CAPACITY", invalid, 1);
+            if (!EXPECT(PipelineConfig::fromEnvironment().frame_ring_capacity == default_capacity))
+            {
+                std::cerr << "  accepted SPARK_FRAME_RING_CAPACITY=" << invalid << std::endl;
+            }
+        }
+        setenv("SPARK_FRAME_RING_CAPACITY", "16", 1);
+        EXPECT(PipelineConfig::fromEnvironment().frame_ring_capacity == 16);
+        unsetenv("SPARK_FRAME_RING_CAPACITY");
+        // Blocking ingest unless asked otherwise: no frame is dropped by default
+        EXPECT(PipelineConfig::fromEnvironment().overflow_policy == OverflowPolicy::Block);
+    }
+}
+
+int main()
+{
+    checkBlock();
+    checkDropNewest();
+    checkDropOldest();
+    checkShutdown();
+    checkPopWait();
+    for (auto policy : {OverflowPolicy::Block, OverflowPolicy::DropOldest, OverflowPolicy::DropNewest})
+    {
+        checkConcurrent(policy);
+    }
+    checkCapacityFromEnvironment();
+    return test::result("FrameRingTest");
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "BenchUtils.h"
+#include "HalfFloat.h"
+#include "PatchPipeline.h"
+#include "TestUtils.h"
+
+namespace
+{
+    using patch_sampler::OutputType;
+
+    /// @brief A format PatchPipeline::supports and how OpenCV converts it to BGR
+    struct SourceFormat
+    {
+        const char *name;
+        uint16_t format;
+        int type;
+        int to_bgr; // -1: already BGR
+        bool chroma_rows;
+    };
+
+    const SourceFormat FORMATS[] = {
+        {"BGR", FORMAT_BGR, CV_8UC3, -1, false},
+        {"RGB", FORMAT_RGB, CV_8UC3, cv::COLOR_RGB2BGR, false},
+        {"GRAY", FORMAT_GRAY, CV_8UC1, cv::COLOR_GRAY2BGR, false},
+        {"YUYV", FORMAT_YUYV_422, CV_8UC2, cv::COLOR_YUV2BGR_YUYV, false},
+        {"YVYU", FORMAT_YVYU_422, CV_8UC2, cv::COLOR_YUV2BGR_YVYU, false},
+        {"UYVY", FORMAT_UYUV_422, CV_8UC2, cv::COLOR_YUV2BGR_UYVY, false},
+        {"NV12", FORMAT_NV12_420, CV_8UC1, cv::COLOR_YUV2BGR_NV12, true},
+        {"NV21", FORMAT_NV21_420, CV_8UC1, cv::COLOR_YUV2BGR_NV21, true},
+    };
+
+    const cv::Size FRAME_SIZE(160, 120);
+    // Odd sizes and offsets, ROIs on every edge, and ones the frame clips
+    const cv::Rect ROIS[] = {{0, 0, 28, 28}, {17, 9, 41, 33}, {3, 5, 97, 61}, {101, 71, 59, 49}, {0, 87, 37, 33},
+                             {131, 0, 29, 45}, {1, 1, 13, 11}, {150, 110, 30, 30}, {-9, -7, 40, 35}};
+    // The model's patch, specialised, and a size the generic kernels serve
+    const cv::Size PATCH_SIZES[] = {{28, 28}, {19, 24}};
+
+    // Mean absolute difference to the OpenCV chain, in 0..255. It rounds to 8 bits after the
+    // resize and converts YUV before blending rather than after, which ROIs enlarged from a few
+    // chroma samples magnify
+    const double MEAN_TOLERANCE = 0.5;
+    const double YUV_MEAN_TOLERANCE = 1.0;
+    // Any one element of a BGR, RGB or GRAY patch: the chain's 8-bit rounding plus its own
+    const double MAX_TOLERANCE = 1.5;
+    const float FP16_TOLERANCE = 1e-3f;
+
+    /// @brief frame's picture in BGR, the way the worker's original chain converted it
+    cv::Mat toBgr(const CapturedFrame &frame, const SourceFormat &source)
+    {
+        if (source.to_bgr < 0)
+        {
+            return frame.image;
+        }
+        cv::Mat bgr;
+        cv::cvtColor(frame.image, bgr, source.to_bgr);
+        return bgr;
+    }
+
+    /// @brief The original chain: crop, cv::resize, BGR to RGB, (v / 255 - mean) / std and HWC to CHW.
+    ///        Area enlarging along either axis is bilinear, as PatchPipeline documents
+    std::vector<float> openCvPatch(const cv::Mat &bgr, const cv::Rect &roi, const patch_sampler::TensorSpec &spec)
+    {
+        const bool area = spec.interpolation == resample::Interpolation::Area && roi.width >= spec.size.width && roi.height >= spec.size.height;
+        cv::Mat patch, rgb;
+        cv::resize(bgr(roi), patch, spec.size, 0, 0, area ? cv::INTER_AREA : cv::INTER_LINEAR);
+        cv::cvtColor(patch, rgb, cv::COLOR_BGR2RGB);
+        const int plane = spec.size.area();
+        std::vector<float> chw(3 * plane);
+        for (int y = 0; y < rgb.rows; y++)
+        {
+            for (int x = 0; x < rgb.cols; x++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    chw[c * plane + y * rgb.cols + x] = (rgb.ptr<uchar>(y)[3 * x + c] / 255.0f - spec.mean[c]) / spec.std[c];
+                }
+            }
+        }
+        return chw;
+    }
+
+    void checkFormat(const SourceFormat &source, cv::RNG &rng)
+    {
+        // Camera-like detail in camera-like values: blending YUV before or after conversion only
+        // agrees on smooth images, and full-range noise converts mostly to colours outside RGB,
+        // where clipping before or after blending differs by far more than any kernel error
+        const bench::FrameFormat frame_format{source.name, source.format, source.type, source.chroma_rows};
+        const CapturedFrame frame = bench::syntheticFrame(frame_format, FRAME_SIZE, rng, 4, 64, 192);
+        const cv::Mat bgr = toBgr(frame, source);
+        const bool yuv = source.format != FORMAT_BGR && source.format != FORMAT_RGB && source.format != FORMAT_GRAY;
+
+        for (const auto &size : PATCH_SIZES)
+        {
+            for (auto interpolation : {resample::Interpolation::Bilinear, resample::Interpolation::Area})
+            {
+                patch_sampler::TensorSpec spec;
+                spec.size = size;
+                spec.interpolation = interpolation;
+                spec.mean = {0.485f, 0.456f, 0.406f};
+                spec.std = {0.229f, 0.224f, 0.225f};
+                const patch_sampler::PatchPipeline fp32(spec, OutputType::Float32);
+                const patch_sampler::PatchPipeline fp16(spec, OutputType::Float16);
+                const size_t elements = 3 * static_cast<size_t>(size.area());
+
+                for (const auto &roi : ROIS)
+                {
+                    const cv::Rect clipped = roi & cv::Rect(cv::Point(0, 0), FRAME_SIZE);
+                    const std::vector<float> reference = openCvPatch(bgr, clipped, spec);
+                    resample::PlanPtr plan;
+                    std::vector<float> out(elements);
+                    std::vector<uint16_t> half(elements);
+                    std::vector<float> widened(elements);
+                    fp32.sample(frame, roi, plan, out.data());
+                    fp16.sample(frame, roi, plan, half.data());
+                    half_float::toFloat(half.data(), widened.data(), elements);
+
+                    double mean_difference = 0.0, max_difference = 0.0;
+                    float fp16_difference = 0.0f;
+                    for (size_t i = 0; i < elements; i++)
+                    {
+                        // Back on the 0..255 scale the chain rounds on
+                        const double difference = 255.0 * std::abs(out[i] - reference[i]) * spec.std[i / size.area()];
+                        mean_difference += difference;
+                        max_difference = std::max(max_difference, difference);
+                        fp16_difference = std::max(fp16_difference, std::abs(widened[i] - out[i]) * spec.std[i / size.area()]);
+                    }
+                    mean_difference /= elements;
+
+                    const bool ok = EXPECT(mean_difference <= (yuv ? YUV_MEAN_TOLERANCE : MEAN_TOLERANCE)) &&
+                                    EXPECT(yuv || max_difference <= MAX_TOLERANCE) &&
+                                    EXPECT(fp16_difference <= FP16_TOLERANCE);
+                    if (!ok)
+                    {
+                        std::cerr << "  " << source.name << " " << resample::to_string(interpolation) << " " << size.width << "x" << size.height
+                                  << " roi " << roi.x << "," << roi.y << " " << roi.width << "x" << roi.height
+                                  << ": mean " << mean_difference << ", max " << max_difference << ", fp16 " << fp16_difference << std::endl;
+                    }
+                }
+            }
+        }
+
+        // The uint8 kernels skip normalisation, so they must match the fp32 ones of a plain ToTensor()
+        patch_sampler::TensorSpec plain;
+        const patch_sampler::PatchPipeline fp32(plain, OutputType::Float32);
+        const patch_sampler::PatchPipeline uint8(plain, OutputType::Uint8);
+        const size_t elements = 3 * static_cast<size_t>(plain.size.area());
+        for (const auto &roi : ROIS)
+        {
+            resample::PlanPtr plan;
+            std::vector<float> out(elements);
+            std::vector<uint8_t> bytes(elements);
+            fp32.sample(frame, roi, plan, out.data());
+            uint8.sample(frame, roi, plan, bytes.data());
+            int difference = 0;
+            for (size_t i = 0; i < elements; i++)
+            {
+                difference = std::max(difference, std::abs(bytes[i] - static_cast<int>(std::lround(out[i] * 255.0f))));
+            }
+            if (!EXPECT(difference <= 1))
+            {
+                std::cerr << "  " << source.name << " uint8 roi " << roi.x << "," << roi.y << " " << roi.width << "x" << roi.height << std::endl;
+            }
+        }
+    }
+
+    /// @brief An empty or fully clipped ROI yields the normalised value of black in every output type
+    void checkEmptyRoi()
+    {
+        CapturedFrame frame;
+        frame.image.create(FRAME_SIZE, CV_8UC3);
+        patch_sampler::TensorSpec spec;
+        spec.mean = {0.5f, 0.25f, 0.125f};
+        spec.std = {0.5f, 0.5f, 0.25f};
+        const size_t plane = static_cast<size_t>(spec.size.area());
+
+        for (const auto &roi : {cv::Rect(), cv::Rect(FRAME_SIZE.width, 0, 20, 20), cv::Rect(-30, -30, 20, 20)})
+        {
+            resample::PlanPtr plan;
+            std::vector<float> out(3 * plane, 1.0f);
+            patch_sampler::PatchPipeline(spec, OutputType::Float32).sample(frame, roi, plan, out.data());
+            std::vector<uint8_t> bytes(3 * plane, 1);
+            patch_sampler::PatchPipeline(spec, OutputType::Uint8).sample(frame, roi, plan, bytes.data());
+            for (size_t i = 0; i < out.size(); i++)
+            {
+                const size_t c = i / plane;
+                if (!EXPECT(std::abs(out[i] + spec.mean[c] / spec.std[c]) < 1e-6f) || !EXPECT(bytes[i] == 0))
+                {
+                    std::cerr << "  empty roi " << roi.x << "," << roi.y << " " << roi.width << "x" << roi.height << std::endl;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    cv::RNG rng(2024);
+    for (const auto &source : FORMATS)
+    {
+        EXPECT(patch_sampler::PatchPipeline::supports(source.format));
+        checkFormat(source, rng);
+    }
+    checkEmptyRoi();
+    return test::result("PatchPipelineTest");
+}
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "DrpOpInterpreter.h"
+#include "DrpaiDriver.h"
+#include "DrpaiMemoryPlanner.h"
+#include "PreRuntime.h"
+#include "TestUtils.h"
+
+namespace
+{
+    using Call = MockDrpaiDriver::Call;
+
+    // The size the bundle was compiled for, and one Pre reparameterises it to
+    const cv::Size INPUT_SIZES[] = {{640, 480}, {320, 240}};
+    const uint32_t INPUT_BYTES = (640 * 480 * 3 + 63) / 64 * 64;
+    const float MEAN[3] = {0.485f, 0.456f, 0.406f};
+    const float STD[3] = {0.229f, 0.224f, 0.225f};
+    // One uint8 LSB after normalisation, plus fp16 rounding of the coefficients and the output
+    const float TOLERANCE = 0.03f;
+
+    /// @brief Copies frame into the area the way the camera's DMA would, through the driver
+    bool writeInput(MockDrpaiDriver &driver, uint32_t address, const cv::Mat &frame)
+    {
+        const size_t bytes = frame.total() * frame.elemSize();
+        const int fd = driver.open();
+        drpai_data_t window{address, static_cast<uint32_t>(bytes)};
+        const bool ok = fd >= 0 && driver.ioctl(fd, DRPAI_ASSIGN, &window) == 0 &&
+                        driver.write(fd, frame.data, bytes) == static_cast<ssize_t>(bytes);
+        if (fd >= 0)
+        {
+            driver.close(fd);
+        }
+        return ok;
+    }
+
+    /// @brief What the bundle computes, by OpenCV: bilinear resize, BGR to RGB, (v - mean) / std
+    ///        and HWC to CHW
+    std::vector<float> openCvPatch(const cv::Mat &bgr, cv::Size size)
+    {
+        cv::Mat patch;
+        cv::resize(bgr, patch, size, 0, 0, cv::INTER_LINEAR);
+        const int plane = size.area();
+        std::vector<float> chw(3 * plane);
+        for (int y = 0; y < patch.rows; y++)
+        {
+            for (int x = 0; x < patch.cols; x++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    chw[c * plane + y * patch.cols + x] = (patch.ptr<uchar>(y)[3 * x + 2 - c] / 255.0f - MEAN[c]) / STD[c];
+                }
+            }
+        }
+        return chw;
+    }
+
+    s_preproc_param_t parameters(uint32_t input_address, cv::Size size)
+    {
+        s_preproc_param_t param;
+        param.pre_in_addr = input_address;
+        param.pre_in_shape_w = static_cast<uint16_t>(size.width);
+        param.pre_in_shape_h = static_cast<uint16_t>(size.height);
+        for (int c = 0; c < 3; c++)
+        {
+            param.cof_add[c] = -MEAN[c] * 255.0f;
+            param.cof_mul[c] = 1.0f / (STD[c] * 255.0f);
+        }
+        return param;
+    }
+
+    /// @brief Pre on the frame at input_address must yield the OpenCV patch of bgr
+    void checkPre(PreRuntime &runtime, uint32_t input_address, const cv::Mat &bgr)
+    {
+        s_preproc_param_t param = parameters(input_address, bgr.size());
+        void *output = nullptr;
+        uint32_t output_size = 0;
+        const std::vector<float> reference = openCvPatch(bgr, cv::Size(28, 28));
+        if (!EXPECT(PRE_SUCCESS == runtime.Pre(&param, &output, &output_size)) ||
+            !EXPECT(output_size == reference.size()))
+        {
+            std::cerr << "  Pre on " << bgr.cols << "x" << bgr.rows << ": " << output_size << " values" << std::endl;
+            return;
+        }
+        const float *values = static_cast<const float *>(output);
+        float max_difference = 0.0f;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            max_difference = std::max(max_difference, std::abs(values[i] - reference[i]));
+        }
+        if (!EXPECT(max_difference <= TOLERANCE))
+        {
+            std::cerr << "  Pre on " << bgr.cols << "x" << bgr.rows << ": max difference " << max_difference << std::endl;
+        }
+    }
+
+    /// @brief A driver failure during Pre is reported, and the next Pre succeeds again
+    void checkFaults(PreRuntime &runtime, MockDrpaiDriver &driver, uint32_t input_address)
+    {
+        const MockDrpaiDriver::Fault faults[] = {{Call::Start, EBUSY}, {Call::Wait, 0}, {Call::Read, EIO}};
+        s_preproc_param_t param = parameters(input_address, INPUT_SIZES[0]);
+        for (const auto &fault : faults)
+        {
+            void *output = nullptr;
+            uint32_t output_size = 0;
+            driver.set_faults({fault});
+            const bool reported = EXPECT(PRE_SUCCESS != runtime.Pre(&param, &output, &output_size));
+            driver.set_faults({});
+            if (!reported || !EXPECT(PRE_SUCCESS == runtime.Pre(&param, &output, &output_size)))
+            {
+                std::cerr << "  fault on " << to_string(fault.call) << std::endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (!EXPECT(argc == 2))
+    {
+        std::cerr << "  usage: PreRuntimeMockTest <PreRuntime objects directory>" << std::endl;
+        return test::result("PreRuntimeMockTest");
+    }
+    const std::string pre_dir = argv[1];
+
+    MockDrpaiDriver driver;
+    DrpaiMemoryPlanner planner(driver.area_address(), driver.area_size());
+    const auto footprint = DrpaiMemoryPlanner::preRuntimeFootprint(pre_dir);
+    const auto input_address = planner.reserve("input frame", driver.area_address() + driver.area_size() - INPUT_BYTES, INPUT_BYTES);
+    const auto objects = footprint ? planner.allocate("preprocess", *footprint) : std::nullopt;
+    PreRuntime runtime(driver);
+    if (!EXPECT(footprint.has_value()) || !EXPECT(input_address.has_value()) || !EXPECT(objects.has_value()) ||
+        !EXPECT(PRE_SUCCESS == runtime.Load(pre_dir, *objects)))
+    {
+        std::cerr << "  cannot load " << pre_dir << std::endl;
+        return test::result("PreRuntimeMockTest");
+    }
+
+    // The CPU interpreter as the mock's DRP-AI, so Pre's output is the op list's for real
+    const DrpOpInterpreter interpreter(runtime.GetOpList());
+    EXPECT(interpreter.IsSupported());
+    driver.set_job(interpreter.AsMockJob());
+
+    cv::RNG rng(2024);
+    for (const auto &size : INPUT_SIZES)
+    {
+        cv::Mat bgr(size, CV_8UC3);
+        rng.fill(bgr, cv::RNG::UNIFORM, 0, 256);
+        if (EXPECT(writeInput(driver, *input_address, bgr)))
+        {
+            checkPre(runtime, *input_address, bgr);
+        }
+    }
+    checkFaults(runtime, driver, *input_address);
+    return test::result("PreRuntimeMockTest");
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+
+/// @brief What the test executables share: EXPECT reports a failed condition with its location
+///        and counts it, and test::result() turns the count into the exit code ctest checks
+namespace test
+{
+    inline int &failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool expect(bool condition, const char *expression, const char *file, int line)
+    {
+        if (!condition)
+        {
+            failures()++;
+            std::cerr << file << ":" << line << ": EXPECT(" << expression << ") failed" << std::endl;
+        }
+        return condition;
+    }
+
+    /// @brief Prints name's verdict
+    /// @return process exit code, non-zero if any EXPECT failed
+    inline int result(const char *name)
+    {
+        if (failures() == 0)
+        {
+            std::cout << name << ": passed" << std::endl;
+            return 0;
+        }
+        std::cout << name << ": " << failures() << " checks FAILED" << std::endl;
+        return 1;
+    }
+}
+
+/// @brief Checks condition without stopping the test; true if it holds, so a caller can print
+///        the case that failed
+#define EXPECT(condition) test::expect((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,159 @@
+#include <stdexcept>
+
+#include "AsyncInference.h"
+
+std::ostream &operator<<(std::ostream &os, const InferenceQueueStats &stats)
+{
+    os << "{"
+       << "requests: " << stats.requests << ", "
+       << "items: " << stats.items << ", "
+       << "mean_depth: " << stats.mean_depth() << ", "
+       << "max_depth: " << stats.max_depth << ", "
+       << "submit_blocked: " << stats.submit_blocked << ", "
+       << "queue_wait: " << stats.queue_wait << ", "
+       << "run: " << stats.run_time
+       << "}";
+    return os;
+}
+
+AsyncInference::AsyncInference(MeraDrpRuntimeWrapper &runtime, size_t capacity)
+    : runtime(runtime),
+      input_type(runtime.GetInputDataType(0)),
+      model_batch(static_cast<size_t>(runtime.GetBatchSize())),
+      outputs_per_item(static_cast<size_t>(runtime.GetOutputSizePerItem())),
+      slots(std::max<size_t>(capacity, 1))
+{
+    worker = std::thread(&AsyncInference::inference_loop, this);
+}
+
+AsyncInference::~AsyncInference()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+std::future<InferenceResult> AsyncInference::submit(std::shared_ptr<const void> patches, size_t n)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]
+                 { return queue.size() + (running ? 1 : 0) < slots; });
+    const auto submitted = std::chrono::steady_clock::now();
+    totals.submit_blocked.record(submitted - start);
+
+    Request request{std::move(patches), n, submitted, {}};
+    std::future<InferenceResult> result = request.promise.get_future();
+    queue.push_back(std::move(request));
+    const size_t depth = queue.size() + (running ? 1 : 0);
+    totals.requests++;
+    totals.items += n;
+    totals.depth_total += depth;
+    totals.max_depth = std::max(totals.max_depth, depth);
+    changed.notify_all();
+    return result;
+}
+
+size_t AsyncInference::queue_depth() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + (running ? 1 : 0);
+}
+
+InferenceQueueStats AsyncInference::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
+}
+
+void AsyncInference::reset_stats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    totals = InferenceQueueStats();
+}
+
+void AsyncInference::inference_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        changed.wait(lock, [&]
+                     { return quit || !queue.empty(); });
+        if (queue.empty())
+        {
+            // quit, with every request answered
+            return;
+        }
+        Request request = std::move(queue.front());
+        queue.pop_front();
+        running = true;
+        lock.unlock();
+
+        InferenceResult result;
+        std::exception_ptr failure;
+        try
+        {
+            result = run(request);
+        }
+        catch (...)
+        {
+            failure = std::current_exception();
+        }
+
+        // The caller may refill the patches once it sees them released, so before the future
+        request.patches.reset();
+        lock.lock();
+        running = false;
+        if (!failure)
+        {
+            totals.queue_wait.record(result.queue_wait);
+            totals.run_time.record(result.run_time);
+        }
+        changed.notify_all();
+        lock.unlock();
+
+        // Outside the lock: whoever waits on the future may submit again right away
+        if (failure)
+        {
+            request.promise.set_exception(failure);
+        }
+        else
+        {
+            request.promise.set_value(std::move(result));
+        }
+        lock.lock();
+    }
+}
+
+InferenceResult AsyncInference::run(const Request &request)
+{
+    const auto start = std::chrono::steady_clock::now();
+    InferenceResult result;
+    result.outputs_per_item = outputs_per_item;
+    result.queue_wait = start - request.submitted;
+    result.logits.resize(request.items * outputs_per_item);
+
+    bool ran = false;
+    switch (input_type)
+    {
+    case InOutDataType::FLOAT16:
+        ran = runtime.RunBatch(static_cast<const unsigned short *>(request.patches.get()), request.items, result.logits.data());
+        break;
+    case InOutDataType::FLOAT32:
+        ran = runtime.RunBatch(static_cast<const float *>(request.patches.get()), request.items, result.logits.data());
+        break;
+    default:
+        break;
+    }
+    if (!ran)
+    {
+        throw std::runtime_error("AsyncInference: input or output data type not floating point");
+    }
+
+    result.finished = std::chrono::steady_clock::now();
+    result.run_time = result.finished - start;
+    return result;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MeraDrpRuntimeWrapper.h"
+#include "PipelineStats.h"
+
+/// @brief Outputs of one AsyncInference::submit
+struct InferenceResult
+{
+    // outputs_per_item floats per submitted patch, in order
+    std::vector<float> logits;
+    size_t outputs_per_item = 0;
+    // submit() returning to the inference thread picking the request up
+    std::chrono::steady_clock::duration queue_wait{0};
+    std::chrono::steady_clock::duration run_time{0};
+    std::chrono::steady_clock::time_point finished;
+};
+
+/// @brief Queue depth and waiting on both sides of an AsyncInference
+struct InferenceQueueStats
+{
+    uint64_t requests = 0;
+    uint64_t items = 0;
+    // submit() waiting for the queue to have room
+    LatencyStats submit_blocked;
+    LatencyStats queue_wait;
+    LatencyStats run_time;
+    // requests queued or running, counting the new one, as each submit() saw it
+    uint64_t depth_total = 0;
+    size_t max_depth = 0;
+
+    double mean_depth() const { return requests == 0 ? 0.0 : static_cast<double>(depth_total) / requests; }
+};
+
+std::ostream &operator<<(std::ostream &os, const InferenceQueueStats &stats);
+
+/// @brief Runs a MeraDrpRuntimeWrapper on a thread of its own, so the thread submitting patches
+///        can go on preprocessing and rendering while the DRP-AI works.
+///
+/// submit() queues patches the caller shares ownership of and returns a future of their logits.
+/// The runtime reads them in place through RunBatch, so they are not copied; the inference thread
+/// lets go of them before it sets the future, and the caller must not write them until then (see
+/// PatchBatch::share, whose tensors rotate per frame for this). At most capacity() requests are
+/// queued or running; submit() blocks while there are that many. Requests run in submission
+/// order. While an AsyncInference exists, its thread is the only one that may use the runtime.
+class AsyncInference
+{
+public:
+    explicit AsyncInference(MeraDrpRuntimeWrapper &runtime, size_t capacity = 2);
+    /// @brief Runs what is still queued, then stops the thread
+    ~AsyncInference();
+
+    AsyncInference(const AsyncInference &) = delete;
+    AsyncInference &operator=(const AsyncInference &) = delete;
+
+    /// @brief Queues n contiguous patches of the model's input type, held until their run is
+    ///        done. A failed run is reported through the future as an exception
+    std::future<InferenceResult> submit(std::shared_ptr<const void> patches, size_t n);
+
+    size_t capacity() const { return slots; }
+    /// @brief The model's compiled batch size; submitting multiples of it leaves no run short
+    size_t batch_size() const { return model_batch; }
+    /// @brief Requests queued or running
+    size_t queue_depth() const;
+
+    InferenceQueueStats stats() const;
+    void reset_stats();
+
+private:
+    struct Request
+    {
+        std::shared_ptr<const void> patches;
+        size_t items;
+        std::chrono::steady_clock::time_point submitted;
+        std::promise<InferenceResult> promise;
+    };
+
+    void inference_loop();
+    /// @brief Runs request on the runtime; called on the inference thread only
+    InferenceResult run(const Request &request);
+
+    MeraDrpRuntimeWrapper &runtime;
+    const InOutDataType input_type;
+    const size_t model_batch;
+    const size_t outputs_per_item;
+    const size_t slots;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    // Guarded by mutex
+    std::deque<Request> queue;
+    bool running = false;
+    bool quit = false;
+    InferenceQueueStats totals;
+
+    std::thread worker;
+};
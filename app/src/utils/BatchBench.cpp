@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "BatchBench.h"
+#include "BenchUtils.h"
+#include "HalfFloat.h"
+#include "MeraDrpRuntimeWrapper.h"
+
+namespace
+{
+    const size_t BATCH_SIZES[] = {1, 4, 8, 16};
+    const int WARMUP = 3;
+    const int ITERATIONS = 50;
+    // The DRP-AI computes in fp16 whichever batch it runs, so logits should match to its precision
+    const float TOLERANCE = 1e-2f;
+
+    /// @brief RunBatch on the input element type of the model; nchw holds raw elements of it
+    bool runBatch(MeraDrpRuntimeWrapper &runtime, const cv::Mat &nchw, size_t offset, size_t n, float *out)
+    {
+        if (runtime.GetInputDataType(0) == InOutDataType::FLOAT16)
+        {
+            return runtime.RunBatch(nchw.ptr<unsigned short>() + offset, n, out);
+        }
+        return runtime.RunBatch(nchw.ptr<float>() + offset, n, out);
+    }
+}
+
+int runBatchBench(MeraDrpRuntimeWrapper &runtime, std::ostream &os)
+{
+    const InOutDataType input_type = runtime.GetInputDataType(0);
+    if (input_type == InOutDataType::OTHER)
+    {
+        os << "batch bench: model input is neither fp32 nor fp16" << std::endl;
+        return 1;
+    }
+
+    const size_t model_batch = static_cast<size_t>(runtime.GetBatchSize());
+    const size_t item_elements = static_cast<size_t>(runtime.GetInputView(0).size) / model_batch;
+    const size_t item_outputs = static_cast<size_t>(runtime.GetOutputSizePerItem());
+    const size_t max_items = *std::max_element(std::begin(BATCH_SIZES), std::end(BATCH_SIZES));
+
+    // Patches in [0, 1] like ToTensor(); cv::Mat storage is aligned, so full batches may bind in place
+    cv::Mat values(1, static_cast<int>(max_items * item_elements), CV_32F);
+    cv::RNG(2024).fill(values, cv::RNG::UNIFORM, 0.0f, 1.0f);
+    cv::Mat patches = values;
+    if (input_type == InOutDataType::FLOAT16)
+    {
+        patches.create(values.size(), CV_16U);
+        half_float::fromFloat(values.ptr<float>(), patches.ptr<uint16_t>(), values.total());
+    }
+
+    // Reference: every patch on its own
+    std::vector<float> single(max_items * item_outputs);
+    for (size_t i = 0; i < max_items; i++)
+    {
+        if (!runBatch(runtime, patches, i * item_elements, 1, single.data() + i * item_outputs))
+        {
+            os << "batch bench: RunBatch failed" << std::endl;
+            return 1;
+        }
+    }
+
+    bool passed = true;
+    os << "batch bench: " << (input_type == InOutDataType::FLOAT16 ? "fp16" : "fp32") << " input, compiled batch "
+       << model_batch << ", " << item_outputs << " outputs per spot" << std::endl;
+    os << std::left << std::setw(6) << "n" << std::setw(8) << "runs" << std::setw(12) << "call_ms" << std::setw(14) << "per_spot_ms"
+       << std::setw(10) << "speedup" << "max_logit_diff" << std::endl;
+
+    double single_spot_ms = 0.0;
+    std::vector<float> logits(max_items * item_outputs);
+    for (const size_t n : BATCH_SIZES)
+    {
+        const double call_ms = bench::medianTime<std::milli>([&]
+                                                             { runBatch(runtime, patches, 0, n, logits.data()); },
+                                                             ITERATIONS, WARMUP);
+        const double per_spot_ms = call_ms / n;
+        if (n == 1)
+        {
+            single_spot_ms = per_spot_ms;
+        }
+
+        float max_difference = 0.0f;
+        for (size_t i = 0; i < n * item_outputs; i++)
+        {
+            max_difference = std::max(max_difference, std::fabs(logits[i] - single[i]));
+        }
+        passed = passed && max_difference <= TOLERANCE;
+
+        os << std::left << std::setw(6) << n << std::setw(8) << (n + model_batch - 1) / model_batch
+           << std::setw(12) << std::fixed << std::setprecision(3) << call_ms << std::setw(14) << per_spot_ms
+           << std::setw(10) << std::setprecision(2) << single_spot_ms / per_spot_ms << std::setprecision(5) << max_difference
+           << std::defaultfloat << std::endl;
+    }
+
+    os << (passed ? "batch bench: OK" : "batch bench: FAILED, batched logits differ from single runs") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <iostream>
+
+class MeraDrpRuntimeWrapper;
+
+/// @brief `spark --bench-batch`: runs N = 1, 4, 8 and 16 random patches through
+///        MeraDrpRuntimeWrapper::RunBatch on the loaded model and reports the cost per call and
+///        per spot, next to the model's compiled batch size.
+/// @return process exit code, non-zero if the model's input is not fp32 or fp16 or a batched
+///         run's logits differ from running its patches one at a time
+int runBatchBench(MeraDrpRuntimeWrapper &runtime, std::ostream &os);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "CapturedFrame.h"
+
+/// @brief Helpers the --bench-* modes share, so they time and feed their kernels the same way
+namespace bench
+{
+    /// @brief Median wall time of one call, in Period units, over iterations timed calls that
+    ///        follow warmup untimed ones
+    template <typename Period = std::micro>
+    double medianTime(const std::function<void()> &call, int iterations, int warmup = 0)
+    {
+        for (int i = 0; i < warmup; i++)
+        {
+            call();
+        }
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            call();
+            samples.push_back(std::chrono::duration<double, Period>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    /// @brief A capture format the benches synthesise frames in
+    struct FrameFormat
+    {
+        const char *name;
+        uint16_t format;
+        int type;
+        // Semi-planar 4:2:0 stores its chroma plane below the luma rows
+        bool chroma_rows;
+
+        int rows(cv::Size size) const { return chroma_rows ? size.height * 3 / 2 : size.height; }
+    };
+
+    const FrameFormat FRAME_FORMATS[] = {
+        {"BGR", FORMAT_BGR, CV_8UC3, false},
+        {"RGB", FORMAT_RGB, CV_8UC3, false},
+        {"GRAY", FORMAT_GRAY, CV_8UC1, false},
+        {"YUYV", FORMAT_YUYV_422, CV_8UC2, false},
+        {"UYVY", FORMAT_UYUV_422, CV_8UC2, false},
+        {"NV12", FORMAT_NV12_420, CV_8UC1, true},
+        {"NV21", FORMAT_NV21_420, CV_8UC1, true},
+    };
+
+    inline const FrameFormat &frameFormat(uint16_t format)
+    {
+        for (const auto &frame_format : FRAME_FORMATS)
+        {
+            if (frame_format.format == format)
+            {
+                return frame_format;
+            }
+        }
+        return FRAME_FORMATS[0];
+    }
+
+    /// @brief A size frame of uniform noise in frame_format, with byte values in [low, high). With
+    ///        detail > 1 the noise is drawn at 1 / detail of the resolution and upscaled, giving
+    ///        features a few pixels wide like a camera's rather than white noise no resize can represent
+    inline CapturedFrame syntheticFrame(const FrameFormat &frame_format, cv::Size size, cv::RNG &rng, int detail = 1, int low = 0, int high = 256)
+    {
+        CapturedFrame frame;
+        frame.format = frame_format.format;
+        const cv::Size image_size(size.width, frame_format.rows(size));
+        if (detail <= 1)
+        {
+            frame.image.create(image_size, frame_format.type);
+            rng.fill(frame.image, cv::RNG::UNIFORM, low, high);
+            return frame;
+        }
+        cv::Mat coarse(image_size.height / detail, image_size.width / detail, frame_format.type);
+        rng.fill(coarse, cv::RNG::UNIFORM, low, high);
+        cv::resize(coarse, frame.image, image_size, 0, 0, cv::INTER_LINEAR);
+        return frame;
+    }
+}
@@ -0,0 +1,63 @@
+#include "Camera.h"
+#include "RoiCropFrameSource.h"
+
+namespace
+{
+    /// @brief The camera's FrameSource, capturing at the lowest mode its ROIs allow and cropped to their union
+    std::unique_ptr<FrameSource> createSource(const std::string &input, const std::vector<ParkingSpot> &parking_spots, const PipelineConfig &config)
+    {
+        if (parking_spots.empty() || !config.roi_crop)
+        {
+            return FrameSource::create(input, config);
+        }
+
+        std::vector<cv::Rect> rois;
+        for (const auto &parking_spot : parking_spots)
+        {
+            rois.push_back(parking_spot.coords);
+        }
+
+        // ROIs are drawn on a full capture_size frame, so only cameras can switch to a lower mode
+        PipelineConfig capture_config = config;
+        cv::Size reference_size;
+        if (FrameSource::isCamera(input))
+        {
+            reference_size = config.capture_size;
+            if (config.adaptive_capture)
+            {
+                capture_config.capture_size = chooseCaptureSize(config.capture_size, rois, static_cast<int>(config.min_roi_pixels));
+                std::cout << "Capturing " << input << " at " << capture_config.capture_size.width << "x" << capture_config.capture_size.height << std::endl;
+            }
+        }
+        return std::make_unique<RoiCropFrameSource>(FrameSource::create(input, capture_config), rois, reference_size, config.capture_buffer_count());
+    }
+}
+
+Camera::Camera(size_t index, const std::string &input, std::vector<ParkingSpot> &parking_spots, const PipelineConfig &config)
+    : index(index),
+      input(input),
+      parking_spots(parking_spots),
+      source(createSource(input, parking_spots, config)),
+      frames(config.frame_ring_capacity, config.overflow_policy),
+      scheduler(config.inference_hz, config.inference_every_n),
+      change_detector(config.change_threshold, config.force_refresh) {}
+
+std::string Camera::window_name(const std::string &app_name) const
+{
+    return index == 0 ? app_name : app_name + " - camera " + std::to_string(index + 1);
+}
+
+void printCameraStats(std::ostream &os, const Camera &camera, std::chrono::steady_clock::duration total_drpai_time)
+{
+    const double drpai_ms = std::chrono::duration<double, std::milli>(camera.stats.drpai_time).count();
+    const double share = total_drpai_time.count() <= 0 ? 0.0 : 100.0 * camera.stats.drpai_time.count() / total_drpai_time.count();
+
+    os << "Camera " << camera.index + 1 << " (" << camera.input << "): "
+       << "{ingest: " << camera.ingest_stats << ", "
+       << "inferences: " << camera.scheduler.inferences_run() << "/" << camera.scheduler.frames_seen() << " frames, "
+       << "spots_classified: " << camera.stats.spots_classified << ", "
+       << "drpai_ms: " << drpai_ms << ", "
+       << "drpai_share: " << share << "%, "
+       << "change_detection: " << camera.change_detector
+       << "}";
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+#include "ChangeDetector.h"
+#include "FrameRing.h"
+#include "FrameSource.h"
+#include "InferenceScheduler.h"
+#include "ParkingSpot.h"
+#include "PipelineConfig.h"
+#include "PipelineStats.h"
+
+/// @brief Wakes the shared inference worker when any camera's reader has queued a frame.
+///
+/// The worker reads epoch() before polling the rings and waits against that value, so a frame
+/// pushed between the poll and the wait is not missed.
+class FrameArrivals
+{
+public:
+    uint64_t epoch() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return arrivals;
+    }
+
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            arrivals++;
+        }
+        arrived.notify_one();
+    }
+
+    /// @return false on timeout
+    template <typename Rep, typename Period>
+    bool wait_for(uint64_t seen_epoch, std::chrono::duration<Rep, Period> timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return arrived.wait_for(lock, timeout, [&]
+                                { return arrivals != seen_epoch; });
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable arrived;
+    uint64_t arrivals = 0;
+};
+
+/// @brief How much of the shared DRP-AI time one camera used
+struct CameraStats
+{
+    uint64_t spots_classified = 0;
+    std::chrono::steady_clock::duration drpai_time{0};
+};
+
+/// @brief One capture source of the lot with its own ROIs, frame ring and per-camera state.
+///
+/// Every camera has its own reader thread; all of them feed the single inference worker.
+class Camera
+{
+public:
+    /// @param parking_spots ROIs of this camera; owned by the caller so they outlive the session
+    Camera(size_t index, const std::string &input, std::vector<ParkingSpot> &parking_spots, const PipelineConfig &config);
+
+    Camera(const Camera &) = delete;
+    Camera &operator=(const Camera &) = delete;
+
+    /// @brief "SPARK" for the first camera, "SPARK - camera N" for the others
+    std::string window_name(const std::string &app_name) const;
+
+    const size_t index;
+    const std::string input;
+    std::vector<ParkingSpot> &parking_spots;
+
+    // Declared before the ring: queued frames are views into the source's buffers
+    std::unique_ptr<FrameSource> source;
+    FrameRing<CapturedFrame> frames;
+
+    InferenceScheduler scheduler;
+    ChangeDetector change_detector;
+    IngestStats ingest_stats;
+    CameraStats stats;
+
+    long long inference_duration = 0;
+    // Overlay target when the source delivers something other than BGR
+    cv::Mat bgr_frame;
+};
+
+/// @brief Per-camera line of the stats report; drpai_share is relative to total
+void printCameraStats(std::ostream &os, const Camera &camera, std::chrono::steady_clock::duration total_drpai_time);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+#include "PreRuntime.h"
+
+/// @brief A frame as it travels from the capture thread to the processing thread
+struct CapturedFrame
+{
+    using Clock = std::chrono::steady_clock;
+
+    // BGR/RGB: CV_8UC3, YUYV: CV_8UC2 h x w, NV12: CV_8UC1 (h * 3 / 2) x w.
+    // Usually a view into a buffer owned by the FrameSource; give it back with FrameSource::release
+    cv::Mat image;
+    // One of the FORMAT_* values from PreRuntime.h
+    uint16_t format = FORMAT_BGR;
+    // Backend buffer slot the view points into, -1 if the source doesn't track slots
+    int buffer_index = -1;
+    // Monotonic time at which the capture backend handed us the frame
+    Clock::time_point captured_at;
+    uint64_t sequence = 0;
+    // Where image sits in the coordinates the ROIs were drawn in: ROI point p is at p * scale - origin.
+    // Identity unless the capture was scaled down or cropped (RoiCropFrameSource)
+    cv::Point2d scale{1.0, 1.0};
+    cv::Point origin{0, 0};
+
+    Clock::duration age(Clock::time_point now = Clock::now()) const { return now - captured_at; }
+
+    /// @brief Size of the picture in pixels, independent of how the format packs its planes
+    cv::Size size() const
+    {
+        if (format == FORMAT_NV12_420 || format == FORMAT_NV21_420)
+        {
+            return cv::Size(image.cols, image.rows * 2 / 3);
+        }
+        return image.size();
+    }
+
+    /// @brief Maps a ROI into image coordinates
+    cv::Rect toImage(const cv::Rect &roi) const
+    {
+        const int x0 = static_cast<int>(std::lround(roi.x * scale.x)) - origin.x;
+        const int y0 = static_cast<int>(std::lround(roi.y * scale.y)) - origin.y;
+        const int x1 = static_cast<int>(std::lround((roi.x + roi.width) * scale.x)) - origin.x;
+        const int y1 = static_cast<int>(std::lround((roi.y + roi.height) * scale.y)) - origin.y;
+        return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+    }
+};
@@ -0,0 +1,117 @@
+#include <cstdlib>
+
+#include "ChangeDetector.h"
+#include "PatchSampler.h"
+
+namespace
+{
+    // Luma taps averaged per grid cell, per axis. 8x8 cells x 4x4 taps = 1024 reads per spot
+    const int TAPS_PER_CELL = 4;
+}
+
+ChangeDetector::ChangeDetector(double threshold, Clock::duration refresh_interval)
+    : threshold(threshold), refresh_interval(refresh_interval) {}
+
+ChangeDetector::SpotState &ChangeDetector::state_for(size_t spot_index)
+{
+    if (spot_index >= spots.size())
+    {
+        spots.resize(spot_index + 1);
+    }
+    return spots[spot_index];
+}
+
+void ChangeDetector::compute_signature(const CapturedFrame &frame, const cv::Rect &roi, Signature &signature)
+{
+    const int taps = GRID * TAPS_PER_CELL;
+    for (int gy = 0; gy < GRID; gy++)
+    {
+        for (int gx = 0; gx < GRID; gx++)
+        {
+            int sum = 0;
+            for (int ty = 0; ty < TAPS_PER_CELL; ty++)
+            {
+                const int y = roi.y + ((gy * TAPS_PER_CELL + ty) * 2 + 1) * roi.height / (2 * taps);
+                for (int tx = 0; tx < TAPS_PER_CELL; tx++)
+                {
+                    const int x = roi.x + ((gx * TAPS_PER_CELL + tx) * 2 + 1) * roi.width / (2 * taps);
+                    sum += patch_sampler::lumaAt(frame, x, y);
+                }
+            }
+            signature[gy * GRID + gx] = static_cast<uint8_t>(sum / (TAPS_PER_CELL * TAPS_PER_CELL));
+        }
+    }
+}
+
+bool ChangeDetector::needs_inference(size_t spot_index, const CapturedFrame &frame, const cv::Rect &roi, Clock::time_point now)
+{
+    SpotState &state = state_for(spot_index);
+    state.checked++;
+    if (threshold <= 0)
+    {
+        return true;
+    }
+
+    const cv::Rect clipped = roi & cv::Rect(cv::Point(0, 0), frame.size());
+    if (clipped.empty())
+    {
+        return true;
+    }
+    compute_signature(frame, clipped, state.pending);
+
+    if (!state.has_reference || now - state.classified_at >= refresh_interval)
+    {
+        return true;
+    }
+
+    int total_difference = 0;
+    for (size_t i = 0; i < state.pending.size(); i++)
+    {
+        total_difference += std::abs(static_cast<int>(state.pending[i]) - static_cast<int>(state.reference[i]));
+    }
+    if (static_cast<double>(total_difference) / state.pending.size() >= threshold)
+    {
+        return true;
+    }
+
+    state.skipped++;
+    return false;
+}
+
+void ChangeDetector::mark_classified(size_t spot_index, Clock::time_point now)
+{
+    SpotState &state = state_for(spot_index);
+    state.reference = state.pending;
+    state.has_reference = threshold > 0;
+    state.classified_at = now;
+}
+
+void ChangeDetector::reset_stats()
+{
+    for (auto &state : spots)
+    {
+        state.checked = 0;
+        state.skipped = 0;
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const ChangeDetector &detector)
+{
+    uint64_t checked = 0, skipped = 0;
+    for (const auto &state : detector.spots)
+    {
+        checked += state.checked;
+        skipped += state.skipped;
+    }
+
+    auto percent = [](uint64_t part, uint64_t whole)
+    { return whole == 0 ? 0.0 : 100.0 * part / whole; };
+
+    os << "{lot_skip_percent: " << percent(skipped, checked) << ", per_spot: [";
+    for (size_t i = 0; i < detector.spots.size(); i++)
+    {
+        os << (i == 0 ? "" : ", ") << i + 1 << ": " << percent(detector.spots[i].skipped, detector.spots[i].checked);
+    }
+    os << "]}";
+    return os;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+
+/// @brief Cheap per-spot test for "has anything changed since we last classified this spot".
+///
+/// Each ROI is reduced to an 8x8 grid of mean luma values. When the grid differs from the one
+/// taken at the spot's last classification by less than the threshold (mean absolute
+/// difference, in luma levels) the previous decision is reused. A spot is always reclassified
+/// once refresh_interval has passed, so slow drifts (lighting) cannot freeze a decision.
+class ChangeDetector
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int GRID = 8;
+
+    /// @param threshold 0 disables the detector: every spot is classified every time
+    ChangeDetector(double threshold, Clock::duration refresh_interval);
+
+    /// @brief Call before classifying spot_index in frame. Remembers the signature it computed.
+    /// @return false if the spot's last decision can be reused
+    bool needs_inference(size_t spot_index, const CapturedFrame &frame, const cv::Rect &roi, Clock::time_point now = Clock::now());
+    /// @brief Call after the spot was classified; its signature becomes the new reference
+    void mark_classified(size_t spot_index, Clock::time_point now = Clock::now());
+
+    void reset_stats();
+    friend std::ostream &operator<<(std::ostream &os, const ChangeDetector &detector);
+
+private:
+    using Signature = std::array<uint8_t, GRID * GRID>;
+
+    struct SpotState
+    {
+        Signature reference{};
+        Signature pending{};
+        bool has_reference = false;
+        Clock::time_point classified_at;
+        uint64_t checked = 0;
+        uint64_t skipped = 0;
+    };
+
+    SpotState &state_for(size_t spot_index);
+    static void compute_signature(const CapturedFrame &frame, const cv::Rect &roi, Signature &signature);
+
+    const double threshold;
+    const Clock::duration refresh_interval;
+    std::vector<SpotState> spots;
+};
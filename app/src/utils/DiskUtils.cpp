@@ -9,7 +9,8 @@ namespace
 {
     using namespace cv;
     using namespace std;
-    const std::string SPARK_ROIS_FILEPATH = "/opt/spark/data/rois.json";
+    const std::string SPARK_DATA_DIR = "/opt/spark/data";
+    const std::string SPARK_ROIS_FILEPATH = SPARK_DATA_DIR + "/rois.json";
 
     bool createDirectory(const std::string &path)
     {
@@ -24,7 +25,16 @@ namespace
 
 namespace disk_utils
 {
-    bool serializeROIs(const std::vector<ParkingSpot> &rois)
+    std::string roiFilePath(size_t camera_index)
+    {
+        if (camera_index == 0)
+        {
+            return SPARK_ROIS_FILEPATH;
+        }
+        return SPARK_DATA_DIR + "/rois_" + std::to_string(camera_index + 1) + ".json";
+    }
+
+    bool serializeROIs(const std::vector<ParkingSpot> &rois, const std::string &path)
     {
         try
         {
@@ -37,10 +47,10 @@ namespace disk_utils
             }
             // Overwrites if exists
             // filetype ending affects << operator
-            FileStorage file(SPARK_ROIS_FILEPATH, FileStorage::WRITE);
+            FileStorage file(path, FileStorage::WRITE);
             if (!file.isOpened())
             {
-                std::cerr << "Failed to open file: " << SPARK_ROIS_FILEPATH << std::endl;
+                std::cerr << "Failed to open file: " << path << std::endl;
                 return false;
             }
 
@@ -70,14 +80,14 @@ namespace disk_utils
         }
     }
 
-    vector<ParkingSpot> deserializeROIs()
+    vector<ParkingSpot> deserializeROIs(const std::string &path)
     {
         try
         {
-            FileStorage file(SPARK_ROIS_FILEPATH, FileStorage::READ);
+            FileStorage file(path, FileStorage::READ);
             if (!file.isOpened())
             {
-                std::cerr << "Failed to open file: " << SPARK_ROIS_FILEPATH << std::endl;
+                std::cerr << "Failed to open file: " << path << std::endl;
                 return {};
             }
 
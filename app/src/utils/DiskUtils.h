@@ -8,6 +8,9 @@
 
 namespace disk_utils
 {
-    bool serializeROIs(const std::vector<ParkingSpot> &rois);
-    std::vector<ParkingSpot> deserializeROIs();
+    /// @brief ROI file of a camera; the first camera keeps the original rois.json
+    std::string roiFilePath(size_t camera_index);
+
+    bool serializeROIs(const std::vector<ParkingSpot> &rois, const std::string &path = roiFilePath(0));
+    std::vector<ParkingSpot> deserializeROIs(const std::string &path = roiFilePath(0));
 }
@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Downscale.h"
+
+namespace
+{
+    using resample::AxisPlan;
+    using resample::Tap;
+
+    const int CHANNELS = 3;
+
+    // Stack capacity of the per-call row buffers
+    const int MAX_ROW = downscale::MAX_OUTPUT_SIDE * CHANNELS;
+    // Width of the summed source row area keeps on the stack; wider ROIs spill to the heap
+    const int MAX_SOURCE_ROW = 1024 * CHANNELS;
+
+    void hresizeLinear(const uchar *row, const AxisPlan &xs, int dst_width, int *out)
+    {
+        for (int dst = 0; dst < dst_width; dst++)
+        {
+            const Tap *tap = &xs.taps[xs.begin[dst]];
+            const uchar *p0 = row + tap[0].index * CHANNELS;
+            const uchar *p1 = row + tap[1].index * CHANNELS;
+            for (int c = 0; c < CHANNELS; c++)
+            {
+                out[dst * CHANNELS + c] = p0[c] * tap[0].fixed + p1[c] * tap[1].fixed;
+            }
+        }
+    }
+
+    void hresizeArea(const float *row, const AxisPlan &xs, int dst_width, float *out)
+    {
+        for (int dst = 0; dst < dst_width; dst++)
+        {
+            float sum[CHANNELS] = {0.0f, 0.0f, 0.0f};
+            for (int t = xs.begin[dst]; t < xs.begin[dst + 1]; t++)
+            {
+                const float *p = row + xs.taps[t].index * CHANNELS;
+                for (int c = 0; c < CHANNELS; c++)
+                {
+                    sum[c] += xs.taps[t].weight * p[c];
+                }
+            }
+            for (int c = 0; c < CHANNELS; c++)
+            {
+                out[dst * CHANNELS + c] = sum[c];
+            }
+        }
+    }
+
+    // Vertical bilinear blend of two horizontally resized rows. The arithmetic is that of OpenCV's
+    // VResizeLinearVec_32s8u: both rows drop 4 bits to fit int16, are scaled by the Q11 weights
+    // keeping the high half of the product, and the sum is rounded off by the remaining 2 bits.
+
+    inline int vlinearScalarOne(int s0, int s1, short b0, short b1)
+    {
+        const int t = static_cast<short>((b0 * static_cast<short>(s0 >> 4)) >> 16) + static_cast<short>((b1 * static_cast<short>(s1 >> 4)) >> 16);
+        return std::min(255, std::max(0, (t + 2) >> 2));
+    }
+
+    void vlinearScalar(const int *s0, const int *s1, short b0, short b1, uchar *dst, int n, int x = 0)
+    {
+        for (; x < n; x++)
+        {
+            dst[x] = static_cast<uchar>(vlinearScalarOne(s0[x], s1[x], b0, b1));
+        }
+    }
+
+    // Area works the other way round: the source rows of an output row are summed first (long,
+    // contiguous and vectorisable), then the one summed row is reduced horizontally.
+
+    void vareaAccumulateScalar(float *acc, const uchar *row, float weight, int n, int x = 0)
+    {
+        for (; x < n; x++)
+        {
+            acc[x] += weight * row[x];
+        }
+    }
+
+    void vareaStoreScalar(const float *acc, uchar *dst, int n, int x = 0)
+    {
+        for (; x < n; x++)
+        {
+            dst[x] = static_cast<uchar>(std::min(255L, std::max(0L, std::lrint(acc[x]))));
+        }
+    }
+
+#if defined(__ARM_NEON)
+    void vlinearSimd(const int *s0, const int *s1, short b0, short b1, uchar *dst, int n)
+    {
+        const int16x4_t w0 = vdup_n_s16(b0);
+        const int16x4_t w1 = vdup_n_s16(b1);
+        const int16x8_t two = vdupq_n_s16(2);
+        int x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            const int16x8_t r0 = vcombine_s16(vqmovn_s32(vshrq_n_s32(vld1q_s32(s0 + x), 4)), vqmovn_s32(vshrq_n_s32(vld1q_s32(s0 + x + 4), 4)));
+            const int16x8_t r1 = vcombine_s16(vqmovn_s32(vshrq_n_s32(vld1q_s32(s1 + x), 4)), vqmovn_s32(vshrq_n_s32(vld1q_s32(s1 + x + 4), 4)));
+            // (w * r) >> 16, i.e. the high half of the 16x16 product
+            const int16x8_t m0 = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(r0), w0), 16), vshrn_n_s32(vmull_s16(vget_high_s16(r0), w0), 16));
+            const int16x8_t m1 = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(r1), w1), 16), vshrn_n_s32(vmull_s16(vget_high_s16(r1), w1), 16));
+            const int16x8_t t = vshrq_n_s16(vqaddq_s16(vqaddq_s16(m0, m1), two), 2);
+            vst1_u8(dst + x, vqmovun_s16(t));
+        }
+        vlinearScalar(s0, s1, b0, b1, dst, n, x);
+    }
+
+    void vareaAccumulateSimd(float *acc, const uchar *row, float weight, int n)
+    {
+        const float32x4_t w = vdupq_n_f32(weight);
+        int x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            const uint16x8_t wide = vmovl_u8(vld1_u8(row + x));
+            vst1q_f32(acc + x, vmlaq_f32(vld1q_f32(acc + x), w, vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)))));
+            vst1q_f32(acc + x + 4, vmlaq_f32(vld1q_f32(acc + x + 4), w, vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide)))));
+        }
+        vareaAccumulateScalar(acc, row, weight, n, x);
+    }
+
+    void vareaStoreSimd(const float *acc, uchar *dst, int n)
+    {
+        int x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            // vcvtnq rounds to nearest even, like lrint
+            const int16x8_t v = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(acc + x))), vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(acc + x + 4))));
+            vst1_u8(dst + x, vqmovun_s16(v));
+        }
+        vareaStoreScalar(acc, dst, n, x);
+    }
+#elif defined(__AVX2__) || defined(__SSE2__)
+    inline __m128i vlinear8(const int *s0, const int *s1, __m128i w0, __m128i w1, __m128i two)
+    {
+        const __m128i r0 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s0)), 4), _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s0 + 4)), 4));
+        const __m128i r1 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s1)), 4), _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s1 + 4)), 4));
+        const __m128i t = _mm_adds_epi16(_mm_mulhi_epi16(r0, w0), _mm_mulhi_epi16(r1, w1));
+        return _mm_srai_epi16(_mm_adds_epi16(t, two), 2);
+    }
+
+    void vlinearSimd(const int *s0, const int *s1, short b0, short b1, uchar *dst, int n)
+    {
+        int x = 0;
+#if defined(__AVX2__)
+        {
+            const __m256i w0 = _mm256_set1_epi16(b0);
+            const __m256i w1 = _mm256_set1_epi16(b1);
+            const __m256i two = _mm256_set1_epi16(2);
+            for (; x + 16 <= n; x += 16)
+            {
+                // packs works per 128-bit lane; the permutes put the 16 values back in order
+                const __m256i r0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s0 + x)), 4), _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s0 + x + 8)), 4)), 0xD8);
+                const __m256i r1 = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s1 + x)), 4), _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s1 + x + 8)), 4)), 0xD8);
+                __m256i t = _mm256_adds_epi16(_mm256_mulhi_epi16(r0, w0), _mm256_mulhi_epi16(r1, w1));
+                t = _mm256_srai_epi16(_mm256_adds_epi16(t, two), 2);
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(t, t), 0xD8);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm256_castsi256_si128(packed));
+            }
+        }
+#endif
+        const __m128i w0 = _mm_set1_epi16(b0);
+        const __m128i w1 = _mm_set1_epi16(b1);
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 8 <= n; x += 8)
+        {
+            const __m128i t = vlinear8(s0 + x, s1 + x, w0, w1, two);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(t, t));
+        }
+        vlinearScalar(s0, s1, b0, b1, dst, n, x);
+    }
+
+    void vareaAccumulateSimd(float *acc, const uchar *row, float weight, int n)
+    {
+        int x = 0;
+#if defined(__AVX2__)
+        const __m256 w8 = _mm256_set1_ps(weight);
+        for (; x + 8 <= n; x += 8)
+        {
+            const __m256 pixels = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x))));
+            _mm256_storeu_ps(acc + x, _mm256_add_ps(_mm256_loadu_ps(acc + x), _mm256_mul_ps(w8, pixels)));
+        }
+#endif
+        const __m128 w = _mm_set1_ps(weight);
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 8 <= n; x += 8)
+        {
+            const __m128i wide = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x)), zero);
+            const __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(wide, zero));
+            const __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(wide, zero));
+            _mm_storeu_ps(acc + x, _mm_add_ps(_mm_loadu_ps(acc + x), _mm_mul_ps(w, lo)));
+            _mm_storeu_ps(acc + x + 4, _mm_add_ps(_mm_loadu_ps(acc + x + 4), _mm_mul_ps(w, hi)));
+        }
+        vareaAccumulateScalar(acc, row, weight, n, x);
+    }
+
+    void vareaStoreSimd(const float *acc, uchar *dst, int n)
+    {
+        int x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            // cvtps rounds to nearest even under the default MXCSR, like lrint
+            const __m128i v = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(acc + x)), _mm_cvtps_epi32(_mm_loadu_ps(acc + x + 4)));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(v, v));
+        }
+        vareaStoreScalar(acc, dst, n, x);
+    }
+#else
+    void vlinearSimd(const int *s0, const int *s1, short b0, short b1, uchar *dst, int n)
+    {
+        vlinearScalar(s0, s1, b0, b1, dst, n);
+    }
+
+    void vareaAccumulateSimd(float *acc, const uchar *row, float weight, int n)
+    {
+        vareaAccumulateScalar(acc, row, weight, n);
+    }
+
+    void vareaStoreSimd(const float *acc, uchar *dst, int n)
+    {
+        vareaStoreScalar(acc, dst, n);
+    }
+#endif
+
+    void resampleNearest(const cv::Mat &src, cv::Mat &dst, const resample::Plan &plan)
+    {
+        for (int y = 0; y < plan.size.height; y++)
+        {
+            const uchar *row = src.ptr<uchar>(plan.y.taps[y].index);
+            uchar *out = dst.ptr<uchar>(y);
+            for (int x = 0; x < plan.size.width; x++)
+            {
+                const uchar *pixel = row + plan.x.taps[x].index * CHANNELS;
+                out[x * CHANNELS + 0] = pixel[0];
+                out[x * CHANNELS + 1] = pixel[1];
+                out[x * CHANNELS + 2] = pixel[2];
+            }
+        }
+    }
+
+    void resampleBilinear(const cv::Mat &src, cv::Mat &dst, const resample::Plan &plan, downscale::Kernel kernel)
+    {
+        const int n = plan.size.width * CHANNELS;
+
+        // Horizontally resized source rows; consecutive output rows mostly share one of them
+        cv::AutoBuffer<int, 2 * MAX_ROW> rows(2 * n);
+        int *row[2] = {rows.data(), rows.data() + n};
+        int row_index[2] = {-1, -1};
+
+        for (int y = 0; y < plan.size.height; y++)
+        {
+            const Tap *tap = &plan.y.taps[plan.y.begin[y]];
+            if (row_index[0] != tap[0].index)
+            {
+                if (row_index[1] == tap[0].index)
+                {
+                    std::swap(row[0], row[1]);
+                    std::swap(row_index[0], row_index[1]);
+                }
+                else
+                {
+                    hresizeLinear(src.ptr<uchar>(tap[0].index), plan.x, plan.size.width, row[0]);
+                    row_index[0] = tap[0].index;
+                }
+            }
+            if (row_index[1] != tap[1].index)
+            {
+                hresizeLinear(src.ptr<uchar>(tap[1].index), plan.x, plan.size.width, row[1]);
+                row_index[1] = tap[1].index;
+            }
+
+            uchar *out = dst.ptr<uchar>(y);
+            if (kernel == downscale::Kernel::Simd)
+            {
+                vlinearSimd(row[0], row[1], tap[0].fixed, tap[1].fixed, out, n);
+            }
+            else
+            {
+                vlinearScalar(row[0], row[1], tap[0].fixed, tap[1].fixed, out, n);
+            }
+        }
+    }
+
+    void resampleArea(const cv::Mat &src, cv::Mat &dst, const resample::Plan &plan, downscale::Kernel kernel)
+    {
+        const int n = plan.size.width * CHANNELS;
+
+        // One summed source row, full ROI width
+        const int src_n = src.cols * CHANNELS;
+        cv::AutoBuffer<float, MAX_SOURCE_ROW> sums(src_n);
+        cv::AutoBuffer<float, MAX_ROW> out_row(n);
+
+        for (int y = 0; y < plan.size.height; y++)
+        {
+            float *acc = sums.data();
+            std::fill(acc, acc + src_n, 0.0f);
+            for (int t = plan.y.begin[y]; t < plan.y.begin[y + 1]; t++)
+            {
+                const Tap &tap = plan.y.taps[t];
+                if (kernel == downscale::Kernel::Simd)
+                {
+                    vareaAccumulateSimd(acc, src.ptr<uchar>(tap.index), tap.weight, src_n);
+                }
+                else
+                {
+                    vareaAccumulateScalar(acc, src.ptr<uchar>(tap.index), tap.weight, src_n);
+                }
+            }
+            hresizeArea(acc, plan.x, plan.size.width, out_row.data());
+
+            uchar *out = dst.ptr<uchar>(y);
+            if (kernel == downscale::Kernel::Simd)
+            {
+                vareaStoreSimd(out_row.data(), out, n);
+            }
+            else
+            {
+                vareaStoreScalar(out_row.data(), out, n);
+            }
+        }
+    }
+}
+
+namespace downscale
+{
+    const char *simdName()
+    {
+#if defined(__ARM_NEON)
+        return "neon";
+#elif defined(__AVX2__)
+        return "avx2";
+#elif defined(__SSE2__)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+
+    void resizeBilinear(const cv::Mat &src, cv::Mat &dst, cv::Size size, Kernel kernel)
+    {
+        CV_Assert(src.type() == CV_8UC3 && !src.empty());
+        thread_local resample::PlanPtr plan;
+        resize(src, dst, resample::cachedPlan(plan, cv::Rect(cv::Point(0, 0), src.size()), size, resample::Interpolation::Bilinear), kernel);
+    }
+
+    void resizeArea(const cv::Mat &src, cv::Mat &dst, cv::Size size, Kernel kernel)
+    {
+        CV_Assert(src.type() == CV_8UC3 && !src.empty());
+        thread_local resample::PlanPtr plan;
+        resize(src, dst, resample::cachedPlan(plan, cv::Rect(cv::Point(0, 0), src.size()), size, resample::Interpolation::Area), kernel);
+    }
+
+    void resize(const cv::Mat &src, cv::Mat &dst, const resample::Plan &plan, Kernel kernel)
+    {
+        CV_Assert(src.type() == CV_8UC3 && src.size() == plan.roi.size());
+        dst.create(plan.size, CV_8UC3);
+        switch (plan.interpolation)
+        {
+        case resample::Interpolation::Nearest:
+            resampleNearest(src, dst, plan);
+            break;
+        case resample::Interpolation::Area:
+            resampleArea(src, dst, plan, kernel);
+            break;
+        default:
+            resampleBilinear(src, dst, plan, kernel);
+            break;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include "ResamplePlan.h"
+
+/// @brief Resize kernels for shrinking 8-bit, 3-channel ROIs to small fixed patches (28x28).
+///
+/// cv::resize spends most of its time on setup at these output sizes: it sizes and allocates
+/// coefficient tables and row buffers for a generic cn/depth/interpolation combination on every
+/// call. These kernels only handle CV_8UC3, take their taps from a resample::Plan the caller
+/// keeps across frames and their row buffers from the stack for outputs up to MAX_OUTPUT_SIDE.
+/// The vertical pass, which is where the arithmetic is, has NEON (aarch64, the board), AVX2
+/// (x86 with SPARK_ENABLE_AVX2) and SSE2 (any x86-64) versions and a scalar reference they
+/// must agree with.
+namespace downscale
+{
+    // Larger outputs still work, they just allocate their row buffers
+    const int MAX_OUTPUT_SIDE = 64;
+
+    enum class Kernel
+    {
+        Scalar,
+        Simd // the best instruction set the build targets; Scalar if there is none
+    };
+
+    /// @brief Instruction set Kernel::Simd runs on: "neon", "avx2", "sse2" or "scalar"
+    const char *simdName();
+
+    /// @brief Resamples src, an image of plan.roi.size() such as the ROI view of a frame, to plan.size
+    ///        through the plan's taps. Per call this only gathers and blends pixels
+    void resize(const cv::Mat &src, cv::Mat &dst, const resample::Plan &plan, Kernel kernel = Kernel::Simd);
+
+    // One-off resizes; the plan is cached per thread, so repeating the same size is still cheap
+
+    /// @brief cv::resize(src, dst, size, 0, 0, cv::INTER_LINEAR) for CV_8UC3, within 1 of OpenCV.
+    ///        Uses OpenCV's Q11 fixed-point weights; Scalar and Simd results are bit-identical
+    void resizeBilinear(const cv::Mat &src, cv::Mat &dst, cv::Size size, Kernel kernel = Kernel::Simd);
+
+    /// @brief cv::resize(src, dst, size, 0, 0, cv::INTER_AREA) for CV_8UC3, within 1 of OpenCV.
+    ///        Falls back to resizeBilinear when either axis is enlarged
+    void resizeArea(const cv::Mat &src, cv::Mat &dst, cv::Size size, Kernel kernel = Kernel::Simd);
+}
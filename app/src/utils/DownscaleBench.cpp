@@ -0,0 +1,92 @@
+#include <iomanip>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "BenchUtils.h"
+#include "Downscale.h"
+#include "DownscaleBench.h"
+
+namespace
+{
+    // ROI sizes seen on the demo lot, from far spots to ones right in front of the camera
+    const cv::Size ROI_SIZES[] = {{32, 28}, {48, 36}, {64, 48}, {100, 80}, {160, 120}, {220, 150}, {300, 200}, {480, 320}};
+    const cv::Size PATCH_SIZE(28, 28);
+    const int ITERATIONS = 2000;
+    // cv::resize may round its vectorised and scalar tails differently
+    const int TOLERANCE = 1;
+
+    int maxDifference(const cv::Mat &a, const cv::Mat &b)
+    {
+        cv::Mat difference;
+        cv::absdiff(a, b, difference);
+        double max_value = 0;
+        cv::minMaxLoc(difference.reshape(1), nullptr, &max_value);
+        return static_cast<int>(max_value);
+    }
+}
+
+int runDownscaleBench(std::ostream &os)
+{
+    cv::RNG rng(2024);
+    bool passed = true;
+
+    os << "downscale kernels: " << downscale::simdName() << ", output " << PATCH_SIZE.width << "x" << PATCH_SIZE.height << std::endl;
+    os << std::left << std::setw(10) << "roi" << std::setw(10) << "mode"
+       << std::setw(12) << "cv_us" << std::setw(12) << "plan_us" << std::setw(12) << "scalar_us" << std::setw(12) << "simd_us" << std::setw(10) << "speedup"
+       << std::setw(14) << "max_diff_cv" << "max_diff_scalar" << std::endl;
+
+    for (const auto &roi_size : ROI_SIZES)
+    {
+        // Sample from inside a larger frame so row strides look like a real ROI view
+        cv::Mat frame(roi_size.height + 16, roi_size.width + 16, CV_8UC3);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+        const cv::Mat roi = frame(cv::Rect(cv::Point(8, 8), roi_size));
+
+        for (int mode = 0; mode < 2; mode++)
+        {
+            const bool area = mode == 1;
+            const int interpolation = area ? cv::INTER_AREA : cv::INTER_LINEAR;
+            const cv::Rect roi_rect(cv::Point(0, 0), roi_size);
+            const resample::Interpolation plan_interpolation = area ? resample::Interpolation::Area : resample::Interpolation::Bilinear;
+            // Built once like a parking spot's plan; plan_us is what rebuilding it every frame would cost
+            const resample::Plan plan = resample::buildPlan(roi_rect, PATCH_SIZE, plan_interpolation);
+            auto run = [&](downscale::Kernel kernel, cv::Mat &out)
+            {
+                downscale::resize(roi, out, plan, kernel);
+            };
+
+            cv::Mat reference, scalar, simd;
+            cv::resize(roi, reference, PATCH_SIZE, 0, 0, interpolation);
+            run(downscale::Kernel::Scalar, scalar);
+            run(downscale::Kernel::Simd, simd);
+
+            const int diff_cv = maxDifference(simd, reference);
+            const int diff_scalar = maxDifference(simd, scalar);
+            // Both bilinear paths share their integer arithmetic; area accumulates in float
+            const bool ok = diff_cv <= TOLERANCE && diff_scalar <= (area ? TOLERANCE : 0);
+            passed = passed && ok;
+
+            const double cv_us = bench::medianTime([&]
+                                                   { cv::resize(roi, reference, PATCH_SIZE, 0, 0, interpolation); },
+                                                   ITERATIONS);
+            const double plan_us = bench::medianTime([&]
+                                                     { resample::buildPlan(roi_rect, PATCH_SIZE, plan_interpolation); },
+                                                     ITERATIONS);
+            const double scalar_us = bench::medianTime([&]
+                                                       { run(downscale::Kernel::Scalar, scalar); },
+                                                       ITERATIONS);
+            const double simd_us = bench::medianTime([&]
+                                                     { run(downscale::Kernel::Simd, simd); },
+                                                     ITERATIONS);
+
+            os << std::left << std::setw(10) << (std::to_string(roi_size.width) + "x" + std::to_string(roi_size.height))
+               << std::setw(10) << (area ? "area" : "bilinear")
+               << std::setw(12) << cv_us << std::setw(12) << plan_us << std::setw(12) << scalar_us << std::setw(12) << simd_us
+               << std::setw(10) << (simd_us > 0 ? cv_us / simd_us : 0.0)
+               << std::setw(14) << diff_cv << diff_scalar << (ok ? "" : "  FAIL") << std::endl;
+        }
+    }
+
+    os << (passed ? "all kernels within tolerance" : "kernels OUT OF TOLERANCE") << std::endl;
+    return passed ? 0 : 1;
+}
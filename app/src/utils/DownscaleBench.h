@@ -0,0 +1,8 @@
+#pragma once
+
+#include <iostream>
+
+/// @brief `spark --bench-downscale`: checks the downscale kernels against cv::resize and times
+///        cv::resize, the scalar reference and the SIMD kernels per ROI size.
+/// @return process exit code, non-zero if any kernel is out of tolerance
+int runDownscaleBench(std::ostream &os);
@@ -0,0 +1,400 @@
+#include <stdexcept>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "DrpOpInterpreter.h"
+#include "HalfFloat.h"
+
+namespace
+{
+    struct OpError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    /// @brief One op's parameters, read from the param block, and its view of DRP-AI memory
+    class OpContext
+    {
+    public:
+        OpContext(const s_op_t &op, const uint8_t *params, uint32_t params_size, const DrpOpInterpreter::MemoryMap &memory)
+            : op(op), params(params), params_size(params_size), memory(memory)
+        {
+            raddr = param(P_RADDR);
+            waddr = param(P_WADDR);
+        }
+
+        bool has(const char *name) const { return find(name) != nullptr; }
+
+        uint32_t param(const char *name) const
+        {
+            const s_op_param_t *entry = find(name);
+            if (entry == nullptr)
+            {
+                throw OpError(std::string("missing parameter ") + name);
+            }
+            const uint32_t offset = op.offset + entry->offset;
+            if (entry->size > 4 || offset + entry->size > params_size)
+            {
+                throw OpError(std::string("parameter ") + name + " is outside drp_param.bin");
+            }
+            // Little endian, as PreRuntime::WriteValue stores it
+            uint32_t value = 0;
+            for (uint16_t i = 0; i < entry->size; i++)
+            {
+                value |= static_cast<uint32_t>(params[offset + i]) << (8 * i);
+            }
+            return value;
+        }
+
+        uint32_t param(const char *name, uint32_t fallback) const { return has(name) ? param(name) : fallback; }
+
+        // drp_param_info.txt spells the input width IMG_IWIDHT
+        cv::Size inputSize() const { return cv::Size(param(has(P_IMG_IWIDTH) ? P_IMG_IWIDTH : "IMG_IWIDHT"), param(P_IMG_IHEIGHT)); }
+        cv::Size outputSize() const { return cv::Size(param(P_IMG_OWIDTH), param(P_IMG_OHEIGHT)); }
+
+        uint8_t *at(uint32_t address, size_t bytes, const char *what) const
+        {
+            uint8_t *host = bytes > UINT32_MAX ? nullptr : memory(address, static_cast<uint32_t>(bytes));
+            if (host == nullptr)
+            {
+                throw OpError(std::string(what) + " is outside DRP-AI memory");
+            }
+            return host;
+        }
+        uint8_t *in(size_t bytes) const { return at(raddr, bytes, "input"); }
+        uint8_t *out(size_t bytes) const { return at(waddr, bytes, "output"); }
+
+        uint32_t raddr;
+        uint32_t waddr;
+
+    private:
+        const s_op_param_t *find(const char *name) const
+        {
+            for (const auto &entry : op.param_list)
+            {
+                if (entry.name == name)
+                {
+                    return &entry;
+                }
+            }
+            return nullptr;
+        }
+
+        const s_op_t &op;
+        const uint8_t *params;
+        const uint32_t params_size;
+        const DrpOpInterpreter::MemoryMap &memory;
+    };
+
+    /// @brief DATA_TYPE: 0 for uint8, 1 for fp16
+    int elementDepth(uint32_t data_type)
+    {
+        return data_type == 0 ? CV_8U : CV_16U;
+    }
+
+    /// @brief WORD_SIZE: 0, 1 or 2 for 1, 2 or 4 byte elements
+    int wordDepth(uint32_t word_size)
+    {
+        switch (word_size)
+        {
+        case 0:
+            return CV_8U;
+        case 1:
+            return CV_16U;
+        case 2:
+            return CV_32S;
+        default:
+            throw OpError("unsupported WORD_SIZE " + std::to_string(word_size));
+        }
+    }
+
+    cv::Mat image(const cv::Size &size, int depth, int channels, uint8_t *data)
+    {
+        if (size.area() <= 0 || channels <= 0)
+        {
+            throw OpError("empty image");
+        }
+        return cv::Mat(size, CV_MAKETYPE(depth, channels), data);
+    }
+
+    void convYuv2Rgb(const OpContext &ctx)
+    {
+        const cv::Size size = ctx.inputSize();
+        const uint32_t format = ctx.param(P_INPUT_YUV_FORMAT);
+        // DOUT_RGB_FORMAT is 0 for RGB and 1 for BGR, see PreRuntime::UpdateFormat
+        const bool bgr = ctx.param(P_DOUT_RGB_FORMAT, 0) == 1;
+        cv::Mat src;
+        int code;
+        switch (format)
+        {
+        case FORMAT_YUYV_422:
+        case FORMAT_YVYU_422:
+        case FORMAT_UYUV_422:
+            src = image(size, CV_8U, 2, ctx.in(static_cast<size_t>(size.area()) * 2));
+            code = format == FORMAT_YUYV_422 ? (bgr ? cv::COLOR_YUV2BGR_YUYV : cv::COLOR_YUV2RGB_YUYV)
+                   : format == FORMAT_YVYU_422 ? (bgr ? cv::COLOR_YUV2BGR_YVYU : cv::COLOR_YUV2RGB_YVYU)
+                                               : (bgr ? cv::COLOR_YUV2BGR_UYVY : cv::COLOR_YUV2RGB_UYVY);
+            break;
+        case FORMAT_NV12_420:
+        case FORMAT_NV21_420:
+            src = image(cv::Size(size.width, size.height * 3 / 2), CV_8U, 1, ctx.in(static_cast<size_t>(size.area()) * 3 / 2));
+            code = format == FORMAT_NV12_420 ? (bgr ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2RGB_NV12)
+                                             : (bgr ? cv::COLOR_YUV2BGR_NV21 : cv::COLOR_YUV2RGB_NV21);
+            break;
+        default:
+            throw OpError("unsupported INPUT_YUV_FORMAT " + std::to_string(format));
+        }
+        // dst already has the size and type cvtColor asks for, so it writes into DRP-AI memory
+        cv::Mat dst = image(size, CV_8U, 3, ctx.out(static_cast<size_t>(size.area()) * 3));
+        cv::cvtColor(src, dst, code);
+    }
+
+    void convX2Gray(const OpContext &ctx)
+    {
+        const cv::Size size = ctx.inputSize();
+        const uint32_t format = ctx.param(P_DIN_FORMAT);
+        cv::Mat dst = image(size, CV_8U, 1, ctx.out(size.area()));
+        switch (format)
+        {
+        case FORMAT_YUYV_422:
+        case FORMAT_YVYU_422:
+        case FORMAT_UYUV_422:
+            cv::extractChannel(image(size, CV_8U, 2, ctx.in(static_cast<size_t>(size.area()) * 2)), dst, format == FORMAT_UYUV_422 ? 1 : 0);
+            break;
+        case FORMAT_NV12_420:
+        case FORMAT_NV21_420:
+            image(size, CV_8U, 1, ctx.in(size.area())).copyTo(dst);
+            break;
+        case DIN_FORMAT_RGB:
+        case DIN_FORMAT_BGR:
+            cv::cvtColor(image(size, CV_8U, 3, ctx.in(static_cast<size_t>(size.area()) * 3)), dst,
+                         format == DIN_FORMAT_RGB ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY);
+            break;
+        default:
+            throw OpError("unsupported DIN_FORMAT " + std::to_string(format));
+        }
+    }
+
+    void resizeHwc(const OpContext &ctx)
+    {
+        const cv::Size in_size = ctx.inputSize();
+        const cv::Size out_size = ctx.outputSize();
+        const int channels = ctx.param(P_IMG_ICH);
+        const int interpolation = ctx.param(P_RESIZE_ALG) == ALG_NEAREST ? cv::INTER_NEAREST : cv::INTER_LINEAR;
+        const bool half = ctx.param(P_DATA_TYPE, 0) != 0;
+        const size_t element = half ? 2 : 1;
+        uint8_t *in = ctx.in(static_cast<size_t>(in_size.area()) * channels * element);
+        uint8_t *out = ctx.out(static_cast<size_t>(out_size.area()) * channels * element);
+
+        if (!half)
+        {
+            cv::Mat dst = image(out_size, CV_8U, channels, out);
+            cv::resize(image(in_size, CV_8U, channels, in), dst, out_size, 0, 0, interpolation);
+            return;
+        }
+        // cv::resize has no fp16 path; go through fp32 on the vectorised converters
+        thread_local cv::Mat src_float, dst_float;
+        src_float.create(in_size, CV_MAKETYPE(CV_32F, channels));
+        half_float::toFloat(reinterpret_cast<const uint16_t *>(in), src_float.ptr<float>(), src_float.total() * channels);
+        cv::resize(src_float, dst_float, out_size, 0, 0, interpolation);
+        half_float::fromFloat(dst_float.ptr<float>(), reinterpret_cast<uint16_t *>(out), dst_float.total() * channels);
+    }
+
+    void crop(const OpContext &ctx)
+    {
+        const cv::Size in_size = ctx.inputSize();
+        const cv::Size out_size = ctx.outputSize();
+        const int channels = ctx.param(P_IMG_ICH);
+        const int depth = elementDepth(ctx.param(P_DATA_TYPE, 0));
+        const size_t element = CV_ELEM_SIZE1(depth);
+        const cv::Rect rect(cv::Point(ctx.param(P_CROP_POS_X), ctx.param(P_CROP_POS_Y)), out_size);
+        if ((rect & cv::Rect(cv::Point(0, 0), in_size)) != rect)
+        {
+            throw OpError("crop window is outside the image");
+        }
+        const cv::Mat src = image(in_size, depth, channels, ctx.in(static_cast<size_t>(in_size.area()) * channels * element));
+        cv::Mat dst = image(out_size, depth, channels, ctx.out(static_cast<size_t>(out_size.area()) * channels * element));
+        src(rect).copyTo(dst);
+    }
+
+    void imageScaler(const OpContext &ctx)
+    {
+        const cv::Size size = ctx.inputSize();
+        const int channels = ctx.param(P_IMG_ICH);
+        if (channels <= 0 || channels > 4)
+        {
+            throw OpError("unsupported IMG_ICH " + std::to_string(channels));
+        }
+        // DIN_FORMAT is the input element type here: 0 for uint8, otherwise fp16
+        const bool half_in = ctx.param(P_DIN_FORMAT, 0) != 0;
+        // DOUT_RGB_ORDER 1 reverses the channels; the coefficients are in output order
+        const bool reverse = ctx.param(P_DOUT_RGB_ORDER, 0) == 1;
+        const size_t count = static_cast<size_t>(size.area()) * channels;
+
+        float add[4], mul[4];
+        half_float::toFloat(reinterpret_cast<const uint16_t *>(ctx.at(ctx.param(P_ADD_ADDR), channels * 2, "ADD_ADDR")), add, channels);
+        half_float::toFloat(reinterpret_cast<const uint16_t *>(ctx.at(ctx.param(P_MUL_ADDR), channels * 2, "MUL_ADDR")), mul, channels);
+
+        thread_local std::vector<float> scratch;
+        scratch.resize(count);
+        const uint8_t *in = ctx.in(count * (half_in ? 2 : 1));
+        if (half_in)
+        {
+            half_float::toFloat(reinterpret_cast<const uint16_t *>(in), scratch.data(), count);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                scratch[i] = in[i];
+            }
+        }
+
+        float *values = scratch.data();
+        for (size_t p = 0; p < count; p += channels)
+        {
+            float pixel[4];
+            for (int c = 0; c < channels; c++)
+            {
+                pixel[c] = values[p + (reverse ? channels - 1 - c : c)];
+            }
+            for (int c = 0; c < channels; c++)
+            {
+                values[p + c] = (pixel[c] + add[c]) * mul[c];
+            }
+        }
+        half_float::fromFloat(values, reinterpret_cast<uint16_t *>(ctx.out(count * 2)), count);
+    }
+
+    void transpose(const OpContext &ctx)
+    {
+        const cv::Size size = ctx.inputSize();
+        const int channels = ctx.param(P_IMG_ICH);
+        const int depth = wordDepth(ctx.param(P_WORD_SIZE));
+        const size_t plane_bytes = static_cast<size_t>(size.area()) * CV_ELEM_SIZE1(depth);
+        uint8_t *in = ctx.in(plane_bytes * channels);
+        uint8_t *out = ctx.out(plane_bytes * channels);
+
+        // The planar side as one Mat per channel; split and merge keep caller-sized buffers
+        const bool chw_to_hwc = ctx.param(P_IS_CHW2HWC, 0) != 0;
+        uint8_t *planar = chw_to_hwc ? in : out;
+        std::vector<cv::Mat> planes;
+        for (int c = 0; c < channels; c++)
+        {
+            planes.push_back(image(size, depth, 1, planar + c * plane_bytes));
+        }
+        if (chw_to_hwc)
+        {
+            cv::Mat dst = image(size, depth, channels, out);
+            cv::merge(planes.data(), planes.size(), dst);
+        }
+        else
+        {
+            cv::split(image(size, depth, channels, in), planes.data());
+        }
+    }
+
+    void castFp16Fp32(const OpContext &ctx)
+    {
+        const size_t count = static_cast<size_t>(ctx.inputSize().area()) * ctx.param(P_IMG_ICH);
+        // CAST_MODE 0 widens fp16 to fp32, 1 narrows back
+        if (ctx.param(P_CAST_MODE, 0) == 0)
+        {
+            const auto *in = reinterpret_cast<const uint16_t *>(ctx.in(count * 2));
+            half_float::toFloat(in, reinterpret_cast<float *>(ctx.out(count * 4)), count);
+        }
+        else
+        {
+            const auto *in = reinterpret_cast<const float *>(ctx.in(count * 4));
+            half_float::fromFloat(in, reinterpret_cast<uint16_t *>(ctx.out(count * 2)), count);
+        }
+    }
+
+    using Kernel = void (*)(const OpContext &ctx);
+
+    const struct
+    {
+        const char *lib;
+        Kernel kernel;
+    } KERNELS[] = {
+        {LIB_CONVYUV2RGB, convYuv2Rgb},
+        {LIB_CONVX2GRAY, convX2Gray},
+        {LIB_RESIZE_HWC, resizeHwc},
+        {LIB_CROP, crop},
+        {LIB_IMAGESCALER, imageScaler},
+        {LIB_TRANSPOSE, transpose},
+        {LIB_CASTFP16_FP32, castFp16Fp32},
+    };
+
+    Kernel findKernel(const std::string &lib)
+    {
+        for (const auto &entry : KERNELS)
+        {
+            if (lib == entry.lib)
+            {
+                return entry.kernel;
+            }
+        }
+        return nullptr;
+    }
+}
+
+DrpOpInterpreter::DrpOpInterpreter(const std::vector<s_op_t> &ops) : ops(ops) {}
+
+bool DrpOpInterpreter::IsSupported() const
+{
+    for (const auto &op : ops)
+    {
+        if (findKernel(op.lib) == nullptr)
+        {
+            return false;
+        }
+    }
+    return !ops.empty();
+}
+
+uint8_t DrpOpInterpreter::Run(const drpai_data_t *proc, const MemoryMap &memory) const
+{
+    const drpai_data_t &param_block = proc[DRPAI_INDEX_DRP_PARAM];
+    const uint8_t *params = memory(param_block.address, param_block.size);
+    if (params == nullptr)
+    {
+        std::cerr << "[ERROR] drp_param.bin is outside DRP-AI memory." << std::endl;
+        return PRE_ERROR;
+    }
+
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+        const s_op_t &op = ops[i];
+        const Kernel kernel = findKernel(op.lib);
+        if (kernel == nullptr)
+        {
+            std::cerr << "[ERROR] No CPU implementation of " << op.lib << " (" << op.name << ")." << std::endl;
+            return PRE_ERROR;
+        }
+        try
+        {
+            OpContext ctx(op, params, param_block.size, memory);
+            if (0 == i)
+            {
+                ctx.raddr = proc[DRPAI_INDEX_INPUT].address;
+            }
+            kernel(ctx);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[ERROR] " << op.name << " (" << op.lib << "): " << e.what() << std::endl;
+            return PRE_ERROR;
+        }
+    }
+    return PRE_SUCCESS;
+}
+
+MockDrpaiDriver::Job DrpOpInterpreter::AsMockJob() const
+{
+    return [interpreter = *this](MockDrpaiDriver &driver, const drpai_data_t *proc)
+    {
+        return PRE_SUCCESS == interpreter.Run(proc, [&driver](uint32_t address, uint32_t size)
+                                              { return driver.memory(address, size); });
+    };
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "DrpaiDriver.h"
+#include "PreRuntime.h"
+
+/// @brief Runs PreRuntime's DRP op list on the CPU.
+///
+/// The interpreter keeps only the layout of the op list, i.e. which library each op is and where
+/// its parameters sit in drp_param.bin. Values are read at run time from the param block the
+/// DRP-AI would read, so shape, format and coefficient updates made by PreRuntime::Pre apply as
+/// they do on the device. As on the device, the first op reads the input from the address given
+/// to DRPAI_START instead of its raddr.
+///
+/// Supported: conv_yuv2rgb (YUYV, YVYU, UYVY, NV12, NV21), conv_x2gray, resize_hwc (nearest,
+/// bilinear), crop, imagescaler, transpose and cast_fp16_fp32, each on OpenCV's or half_float's
+/// vectorised kernels. Rounding follows OpenCV's, so outputs may differ from the DRP's by an LSB.
+class DrpOpInterpreter
+{
+public:
+    /// @brief Host view of [address, address + size) of DRP-AI memory, nullptr if unmapped
+    using MemoryMap = std::function<uint8_t *(uint32_t address, uint32_t size)>;
+
+    /// @brief ops as parsed by PreRuntime, see PreRuntime::GetOpList
+    explicit DrpOpInterpreter(const std::vector<s_op_t> &ops);
+
+    /// @brief Every lib the op list uses has a CPU implementation
+    bool IsSupported() const;
+
+    /// @brief Runs the op list; proc is what DRPAI_START is given
+    /// @return PRE_SUCCESS, or PRE_ERROR after printing what failed
+    uint8_t Run(const drpai_data_t *proc, const MemoryMap &memory) const;
+
+    /// @brief Run as a MockDrpaiDriver job, so a PreRuntime on the mock produces real output
+    MockDrpaiDriver::Job AsMockJob() const;
+
+private:
+    std::vector<s_op_t> ops;
+};
@@ -0,0 +1,466 @@
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "DrpaiDriver.h"
+
+namespace
+{
+    class SystemDrpaiDriver : public DrpaiDriver
+    {
+    public:
+        int open() override { return ::open("/dev/drpai0", O_RDWR); }
+        int close(int fd) override { return ::close(fd); }
+        int ioctl(int fd, unsigned long request, void *arg) override { return ::ioctl(fd, request, arg); }
+        ssize_t read(int fd, void *buffer, size_t count) override { return ::read(fd, buffer, count); }
+        ssize_t write(int fd, const void *buffer, size_t count) override { return ::write(fd, buffer, count); }
+
+        int wait(int fd, const timespec &timeout, const sigset_t *sigmask) override
+        {
+            fd_set rfds;
+            FD_ZERO(&rfds);
+            FD_SET(fd, &rfds);
+            return pselect(fd + 1, &rfds, NULL, NULL, &timeout, sigmask);
+        }
+    };
+
+    const struct
+    {
+        const char *name;
+        int value;
+    } ERRNO_NAMES[] = {{"EIO", EIO}, {"EINVAL", EINVAL}, {"EBUSY", EBUSY}, {"EFAULT", EFAULT}, {"ENOMEM", ENOMEM}, {"EACCES", EACCES}, {"ENOENT", ENOENT}, {"EINTR", EINTR}, {"EBADF", EBADF}, {"ETIMEDOUT", ETIMEDOUT}};
+
+    int parseErrno(const std::string &text)
+    {
+        for (const auto &entry : ERRNO_NAMES)
+        {
+            if (text == entry.name)
+            {
+                return entry.value;
+            }
+        }
+        return std::stoi(text);
+    }
+
+    MockDrpaiDriver::Call parseCall(const std::string &text)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(MockDrpaiDriver::Call::Count); i++)
+        {
+            const auto call = static_cast<MockDrpaiDriver::Call>(i);
+            if (text == to_string(call))
+            {
+                return call;
+            }
+        }
+        throw std::invalid_argument(text);
+    }
+}
+
+DrpaiDriver &DrpaiDriver::system()
+{
+    static SystemDrpaiDriver driver;
+    return driver;
+}
+
+const char *to_string(MockDrpaiDriver::Call call)
+{
+    switch (call)
+    {
+    case MockDrpaiDriver::Call::Open:
+        return "open";
+    case MockDrpaiDriver::Call::Close:
+        return "close";
+    case MockDrpaiDriver::Call::Read:
+        return "read";
+    case MockDrpaiDriver::Call::Write:
+        return "write";
+    case MockDrpaiDriver::Call::Wait:
+        return "wait";
+    case MockDrpaiDriver::Call::Assign:
+        return "assign";
+    case MockDrpaiDriver::Call::AssignDynamic:
+        return "assign_dynamic";
+    case MockDrpaiDriver::Call::AssignParam:
+        return "assign_param";
+    case MockDrpaiDriver::Call::Start:
+        return "start";
+    case MockDrpaiDriver::Call::GetStatus:
+        return "get_status";
+    case MockDrpaiDriver::Call::GetArea:
+        return "get_area";
+    default:
+        return "unknown";
+    }
+}
+
+MockDrpaiDriver::Config MockDrpaiDriver::Config::fromEnvironment()
+{
+    Config config;
+    const char *latency = std::getenv("SPARK_DRPAI_MOCK_LATENCY_US");
+    if (latency != nullptr && *latency != '\0')
+    {
+        try
+        {
+            config.latency = std::chrono::microseconds(std::stoul(latency));
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Ignoring invalid SPARK_DRPAI_MOCK_LATENCY_US=" << latency << std::endl;
+        }
+    }
+
+    const char *faults = std::getenv("SPARK_DRPAI_MOCK_FAULTS");
+    std::istringstream list(faults == nullptr ? "" : faults);
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        std::istringstream fields(item);
+        std::string call, error, skip, count;
+        std::getline(fields, call, ':');
+        std::getline(fields, error, ':');
+        std::getline(fields, skip, ':');
+        std::getline(fields, count, ':');
+        try
+        {
+            Fault fault{parseCall(call)};
+            if (!error.empty())
+            {
+                fault.error = parseErrno(error);
+            }
+            if (!skip.empty())
+            {
+                fault.skip = std::stoull(skip);
+            }
+            if (!count.empty())
+            {
+                fault.count = std::stoull(count);
+            }
+            config.faults.push_back(fault);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Ignoring invalid SPARK_DRPAI_MOCK_FAULTS entry " << item << std::endl;
+        }
+    }
+    return config;
+}
+
+MockDrpaiDriver::MockDrpaiDriver() : MockDrpaiDriver(Config()) {}
+
+MockDrpaiDriver::MockDrpaiDriver(const Config &config) : config(config), fault_calls(config.faults.size(), 0)
+{
+    // Anonymous pages read as zero and cost nothing until touched, like an untouched area after boot
+    void *pages = mmap(nullptr, config.area_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map " + std::to_string(config.area_size) + " bytes for the mock DRP-AI area");
+    }
+    area = static_cast<uint8_t *>(pages);
+}
+
+MockDrpaiDriver::~MockDrpaiDriver()
+{
+    munmap(area, config.area_size);
+}
+
+void MockDrpaiDriver::set_job(Job job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->job = std::move(job);
+}
+
+void MockDrpaiDriver::set_faults(const std::vector<Fault> &faults)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    config.faults = faults;
+    fault_calls.assign(faults.size(), 0);
+}
+
+void MockDrpaiDriver::set_latency(std::chrono::microseconds latency)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    config.latency = latency;
+}
+
+uint8_t *MockDrpaiDriver::memory(uint32_t address, uint32_t size)
+{
+    if (address < config.area_address || size > config.area_size || address - config.area_address > config.area_size - size)
+    {
+        return nullptr;
+    }
+    return area + (address - config.area_address);
+}
+
+uint64_t MockDrpaiDriver::calls(Call call) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return call_counts[static_cast<size_t>(call)];
+}
+
+uint64_t MockDrpaiDriver::bytes_written() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+uint64_t MockDrpaiDriver::bytes_read() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return read_bytes;
+}
+
+std::string MockDrpaiDriver::param_info() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return param_text;
+}
+
+bool MockDrpaiDriver::fail(Call call)
+{
+    call_counts[static_cast<size_t>(call)]++;
+    for (size_t i = 0; i < config.faults.size(); i++)
+    {
+        const Fault &fault = config.faults[i];
+        if (fault.call != call)
+        {
+            continue;
+        }
+        const uint64_t n = fault_calls[i]++;
+        if (n >= fault.skip && (fault.count == 0 || n < fault.skip + fault.count))
+        {
+            errno = fault.error;
+            return true;
+        }
+    }
+    return false;
+}
+
+int MockDrpaiDriver::fail_with(int error)
+{
+    errno = error;
+    return -1;
+}
+
+int MockDrpaiDriver::open()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fail(Call::Open))
+    {
+        return -1;
+    }
+    open_count++;
+    return FD;
+}
+
+int MockDrpaiDriver::close(int fd)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fail(Call::Close))
+    {
+        return -1;
+    }
+    if (fd != FD || open_count == 0)
+    {
+        return fail_with(EBADF);
+    }
+    open_count--;
+    return 0;
+}
+
+int MockDrpaiDriver::ioctl(int fd, unsigned long request, void *arg)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd != FD || open_count == 0)
+    {
+        return fail_with(EBADF);
+    }
+
+    switch (request)
+    {
+    case DRPAI_GET_DRPAI_AREA:
+    {
+        if (fail(Call::GetArea))
+        {
+            return -1;
+        }
+        auto *data = static_cast<drpai_data_t *>(arg);
+        data->address = config.area_address;
+        data->size = config.area_size;
+        return 0;
+    }
+    case DRPAI_ASSIGN:
+    case DRPAI_ASSIGN_DYNAMIC:
+    {
+        uint32_t address, size;
+        if (request == DRPAI_ASSIGN)
+        {
+            if (fail(Call::Assign))
+            {
+                return -1;
+            }
+            const auto *data = static_cast<const drpai_data_t *>(arg);
+            address = data->address;
+            size = data->size;
+        }
+        else
+        {
+            if (fail(Call::AssignDynamic))
+            {
+                return -1;
+            }
+            const auto *data = static_cast<const drpai_data_dynamic_t *>(arg);
+            address = data->start_address + data->offset;
+            size = data->size;
+        }
+        if (memory(address, size) == nullptr)
+        {
+            return fail_with(EINVAL);
+        }
+        window = Window::Memory;
+        window_address = address;
+        window_remaining = size;
+        return 0;
+    }
+    case DRPAI_ASSIGN_PARAM:
+    {
+        if (fail(Call::AssignParam))
+        {
+            return -1;
+        }
+        const auto *param = static_cast<const drpai_assign_param_t *>(arg);
+        if (memory(param->obj.address, param->obj.size) == nullptr)
+        {
+            return fail_with(EINVAL);
+        }
+        window = Window::ParamInfo;
+        window_remaining = param->info_size;
+        param_text.clear();
+        return 0;
+    }
+    case DRPAI_START:
+    {
+        if (fail(Call::Start))
+        {
+            return -1;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (running && now < done_at)
+        {
+            return fail_with(EBUSY);
+        }
+        running = true;
+        done_at = now + config.latency;
+        window = Window::None;
+        // The job reads and writes the area through memory(), so it runs unlocked
+        Job current = job;
+        lock.unlock();
+        const bool ok = !current || current(*this, static_cast<const drpai_data_t *>(arg));
+        lock.lock();
+        job_failed = !ok;
+        return 0;
+    }
+    case DRPAI_GET_STATUS:
+    {
+        if (fail(Call::GetStatus))
+        {
+            return -1;
+        }
+        // All zero: no error bits, and the caller only asks once wait() reported completion
+        std::memset(arg, 0, sizeof(drpai_status_t));
+        if (running && std::chrono::steady_clock::now() >= done_at)
+        {
+            running = false;
+        }
+        if (job_failed)
+        {
+            job_failed = false;
+            return fail_with(EIO);
+        }
+        return 0;
+    }
+    default:
+        return fail_with(EINVAL);
+    }
+}
+
+ssize_t MockDrpaiDriver::read(int fd, void *buffer, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fail(Call::Read))
+    {
+        return -1;
+    }
+    if (fd != FD || open_count == 0)
+    {
+        return fail_with(EBADF);
+    }
+    if (window != Window::Memory || count > window_remaining)
+    {
+        return fail_with(EINVAL);
+    }
+    std::memcpy(buffer, area + (window_address - config.area_address), count);
+    window_address += count;
+    window_remaining -= count;
+    read_bytes += count;
+    return count;
+}
+
+ssize_t MockDrpaiDriver::write(int fd, const void *buffer, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fail(Call::Write))
+    {
+        return -1;
+    }
+    if (fd != FD || open_count == 0)
+    {
+        return fail_with(EBADF);
+    }
+    if (window == Window::None || count > window_remaining)
+    {
+        return fail_with(EINVAL);
+    }
+    if (window == Window::Memory)
+    {
+        std::memcpy(area + (window_address - config.area_address), buffer, count);
+        window_address += count;
+    }
+    else
+    {
+        param_text.append(static_cast<const char *>(buffer), count);
+    }
+    window_remaining -= count;
+    written += count;
+    return count;
+}
+
+int MockDrpaiDriver::wait(int fd, const timespec &timeout, const sigset_t * /*sigmask*/)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fail(Call::Wait))
+    {
+        return errno == 0 ? 0 : -1;
+    }
+    if (fd != FD || open_count == 0)
+    {
+        return fail_with(EBADF);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto deadline = now + std::chrono::seconds(timeout.tv_sec) + std::chrono::nanoseconds(timeout.tv_nsec);
+    // Nothing started never becomes readable, so that waits out the whole timeout as on the device
+    const auto ready_at = running ? done_at : std::chrono::steady_clock::time_point::max();
+    lock.unlock();
+
+    std::this_thread::sleep_until(std::min(ready_at, deadline));
+    return ready_at <= deadline ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <linux/drpai.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// @brief The calls PreRuntime and get_drpai_area make on /dev/drpai0.
+///
+/// Every call keeps the contract of the system call it stands for, -1 and errno on failure, so
+/// callers swap `ioctl(fd, ...)` for `driver.ioctl(fd, ...)` and keep their error handling.
+/// DrpaiDriver::system() is the device itself; MockDrpaiDriver runs the same code off the board.
+class DrpaiDriver
+{
+public:
+    virtual ~DrpaiDriver() = default;
+
+    /// @brief open("/dev/drpai0", O_RDWR)
+    virtual int open() = 0;
+    virtual int close(int fd) = 0;
+    virtual int ioctl(int fd, unsigned long request, void *arg) = 0;
+    virtual ssize_t read(int fd, void *buffer, size_t count) = 0;
+    virtual ssize_t write(int fd, const void *buffer, size_t count) = 0;
+    /// @brief pselect() on fd becoming readable, i.e. the job of DRPAI_START finishing.
+    /// @return 1 once it has, 0 on timeout, -1 and errno on failure
+    virtual int wait(int fd, const timespec &timeout, const sigset_t *sigmask) = 0;
+
+    /// @brief The real driver, shared by every caller that is not handed another one
+    static DrpaiDriver &system();
+};
+
+/// @brief DrpaiDriver that emulates the DRP-AI memory area in host RAM.
+///
+/// DRPAI_ASSIGN and DRPAI_ASSIGN_DYNAMIC open a window on the area that write() and read() then
+/// stream through, as on the device; object files are stored as written, without the driver's
+/// relocation. DRPAI_ASSIGN_PARAM collects the param info text. DRPAI_START completes after
+/// Config::latency and runs the Job, if one is set, on the emulated memory (DrpOpInterpreter
+/// provides one); without one the output area keeps whatever was last written there. Faults make chosen calls fail with an errno,
+/// or make wait() time out, so callers' error paths can be driven deliberately.
+class MockDrpaiDriver : public DrpaiDriver
+{
+public:
+    enum class Call
+    {
+        Open,
+        Close,
+        Read,
+        Write,
+        Wait,
+        Assign,
+        AssignDynamic,
+        AssignParam,
+        Start,
+        GetStatus,
+        GetArea,
+        Count
+    };
+
+    struct Fault
+    {
+        Call call;
+        // errno of the failing call. 0 on Call::Wait times out instead; the timeout is reported
+        // at once rather than waited out, so fault runs stay fast
+        int error = EIO;
+        // calls that succeed before the first failure
+        uint64_t skip = 0;
+        // failures in a row from then on, 0 for every later call
+        uint64_t count = 1;
+    };
+
+    struct Config
+    {
+        // What DRPAI_GET_DRPAI_AREA reports. Host pages are only committed once written
+        uint32_t area_address = 0x80000000;
+        uint32_t area_size = 0x4000000;
+        // DRPAI_START to the job finishing
+        std::chrono::microseconds latency{0};
+        std::vector<Fault> faults;
+
+        /// @brief SPARK_DRPAI_MOCK_LATENCY_US and SPARK_DRPAI_MOCK_FAULTS, a comma separated list
+        ///        of call[:errno[:skip[:count]]] such as "start:EBUSY:10:1,wait:0"
+        static Config fromEnvironment();
+    };
+
+    /// @brief Stands in for the DRP-AI at DRPAI_START; proc is the ioctl's argument. Returning
+    ///        false is a DRP-AI error, which DRPAI_GET_STATUS then reports as EIO
+    using Job = std::function<bool(MockDrpaiDriver &driver, const drpai_data_t *proc)>;
+
+    MockDrpaiDriver();
+    explicit MockDrpaiDriver(const Config &config);
+    ~MockDrpaiDriver() override;
+
+    MockDrpaiDriver(const MockDrpaiDriver &) = delete;
+    MockDrpaiDriver &operator=(const MockDrpaiDriver &) = delete;
+
+    int open() override;
+    int close(int fd) override;
+    int ioctl(int fd, unsigned long request, void *arg) override;
+    ssize_t read(int fd, void *buffer, size_t count) override;
+    ssize_t write(int fd, const void *buffer, size_t count) override;
+    int wait(int fd, const timespec &timeout, const sigset_t *sigmask) override;
+
+    void set_job(Job job);
+    /// @brief Replaces the configured faults and restarts their call counts
+    void set_faults(const std::vector<Fault> &faults);
+    void set_latency(std::chrono::microseconds latency);
+
+    /// @brief Host view of [address, address + size) of the area, nullptr if it is not inside
+    uint8_t *memory(uint32_t address, uint32_t size);
+    uint32_t area_address() const { return config.area_address; }
+    uint32_t area_size() const { return config.area_size; }
+
+    /// @brief Calls made, faulted ones included
+    uint64_t calls(Call call) const;
+    uint64_t bytes_written() const;
+    uint64_t bytes_read() const;
+    /// @brief Text written after the last DRPAI_ASSIGN_PARAM
+    std::string param_info() const;
+
+private:
+    enum class Window
+    {
+        None,
+        Memory,
+        ParamInfo
+    };
+
+    static const int FD = 100;
+
+    /// @brief Counts the call and applies a matching fault; true with errno set if it must fail
+    bool fail(Call call);
+    int fail_with(int error);
+
+    Config config;
+    uint8_t *area = nullptr;
+    Job job;
+
+    mutable std::mutex mutex;
+    int open_count = 0;
+    Window window = Window::None;
+    uint32_t window_address = 0;
+    uint32_t window_remaining = 0;
+    std::string param_text;
+    bool running = false;
+    bool job_failed = false;
+    std::chrono::steady_clock::time_point done_at;
+    std::array<uint64_t, static_cast<size_t>(Call::Count)> call_counts{};
+    std::vector<uint64_t> fault_calls;
+    uint64_t written = 0;
+    uint64_t read_bytes = 0;
+};
+
+const char *to_string(MockDrpaiDriver::Call call);
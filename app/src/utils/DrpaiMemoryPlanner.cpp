@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "DrpaiMemoryPlanner.h"
+
+namespace
+{
+    uint64_t alignUp(uint64_t value, uint32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    std::string hex(uint64_t value)
+    {
+        std::ostringstream os;
+        os << "0x" << std::hex << std::setw(8) << std::setfill('0') << value;
+        return os.str();
+    }
+
+    bool exists(const std::string &path)
+    {
+        struct stat info;
+        return 0 == stat(path.c_str(), &info);
+    }
+
+    bool endsWith(const std::string &str, const std::string &suffix)
+    {
+        return str.size() >= suffix.size() && 0 == str.compare(str.size() - suffix.size(), suffix.size(), suffix);
+    }
+}
+
+DrpaiMemoryPlanner::DrpaiMemoryPlanner(uint32_t area_address, uint32_t area_size)
+    : area_begin(area_address), area_end(static_cast<uint64_t>(area_address) + area_size) {}
+
+std::optional<uint32_t> DrpaiMemoryPlanner::allocate(const std::string &name, uint32_t bytes, uint32_t alignment)
+{
+    alignment = std::max<uint32_t>(alignment, 1);
+    // Gaps are the space before each region, by address, and after the last one
+    uint64_t gap_begin = area_begin;
+    for (size_t i = 0; i <= planned.size(); i++)
+    {
+        const uint64_t gap_end = i < planned.size() ? planned[i].address : area_end;
+        const uint64_t address = alignUp(gap_begin, alignment);
+        if (address + bytes <= gap_end)
+        {
+            planned.insert(planned.begin() + i, {name, static_cast<uint32_t>(address), bytes});
+            return static_cast<uint32_t>(address);
+        }
+        if (i < planned.size())
+        {
+            gap_begin = static_cast<uint64_t>(planned[i].address) + planned[i].size;
+        }
+    }
+
+    failure = name + " needs " + hex(bytes) + " bytes, the largest free gap is " + hex(largest_free());
+    return std::nullopt;
+}
+
+std::optional<uint32_t> DrpaiMemoryPlanner::reserve(const std::string &name, uint32_t address, uint32_t bytes)
+{
+    const uint64_t end = static_cast<uint64_t>(address) + bytes;
+    if (address < area_begin || end > area_end)
+    {
+        failure = name + " at [" + hex(address) + ", " + hex(end) + ") is outside the area";
+        return std::nullopt;
+    }
+    const auto next = std::find_if(planned.begin(), planned.end(), [&](const Region &region)
+                                   { return region.address >= address; });
+    if (next != planned.end() && next->address < end)
+    {
+        failure = name + " at [" + hex(address) + ", " + hex(end) + ") overlaps " + next->name;
+        return std::nullopt;
+    }
+    if (next != planned.begin() && static_cast<uint64_t>(std::prev(next)->address) + std::prev(next)->size > address)
+    {
+        failure = name + " at [" + hex(address) + ", " + hex(end) + ") overlaps " + std::prev(next)->name;
+        return std::nullopt;
+    }
+    planned.insert(next, {name, address, bytes});
+    return address;
+}
+
+uint32_t DrpaiMemoryPlanner::free_bytes() const
+{
+    uint64_t used = 0;
+    for (const Region &region : planned)
+    {
+        used += region.size;
+    }
+    return static_cast<uint32_t>(area_end - area_begin - used);
+}
+
+uint32_t DrpaiMemoryPlanner::largest_free() const
+{
+    uint64_t largest = 0;
+    uint64_t gap_begin = area_begin;
+    for (const Region &region : planned)
+    {
+        largest = std::max<uint64_t>(largest, region.address - gap_begin);
+        gap_begin = static_cast<uint64_t>(region.address) + region.size;
+    }
+    return static_cast<uint32_t>(std::max(largest, area_end - gap_begin));
+}
+
+void DrpaiMemoryPlanner::report(std::ostream &os) const
+{
+    os << "DRP-AI memory area [" << hex(area_begin) << ", " << hex(area_end) << "), "
+       << hex(free_bytes()) << " bytes free:" << std::endl;
+    uint64_t gap_begin = area_begin;
+    auto printGap = [&](uint64_t gap_end)
+    {
+        if (gap_end > gap_begin)
+        {
+            os << "  [" << hex(gap_begin) << ", " << hex(gap_end) << ") free, " << hex(gap_end - gap_begin) << " bytes" << std::endl;
+        }
+    };
+    for (const Region &region : planned)
+    {
+        printGap(region.address);
+        os << "  [" << hex(region.address) << ", " << hex(static_cast<uint64_t>(region.address) + region.size) << ") "
+           << region.name << ", " << hex(region.size) << " bytes" << std::endl;
+        gap_begin = static_cast<uint64_t>(region.address) + region.size;
+    }
+    printGap(area_end);
+    if (!failure.empty())
+    {
+        os << "  failed: " << failure << std::endl;
+    }
+}
+
+std::optional<uint32_t> DrpaiMemoryPlanner::addressMapFootprint(const std::string &addrmap_file)
+{
+    std::ifstream ifs(addrmap_file);
+    if (ifs.fail())
+    {
+        return std::nullopt;
+    }
+    // Lines of "<element> <address> <size>" in hex, by address, like PreRuntime::ReadAddrmapTxt
+    std::string line;
+    std::optional<uint64_t> end;
+    while (std::getline(ifs, line))
+    {
+        std::istringstream iss(line);
+        std::string element, address, size;
+        if (!(iss >> element >> address >> size))
+        {
+            continue;
+        }
+        const uint64_t entry_address = std::strtoull(address.c_str(), nullptr, 16);
+        if (!end && entry_address != 0)
+        {
+            // Not built for dynamic allocation, so it cannot be placed anywhere
+            return std::nullopt;
+        }
+        end = entry_address + std::strtoull(size.c_str(), nullptr, 16);
+    }
+    if (!end)
+    {
+        return std::nullopt;
+    }
+    return static_cast<uint32_t>(*end);
+}
+
+std::optional<uint32_t> DrpaiMemoryPlanner::preRuntimeFootprint(const std::string &pre_dir)
+{
+    std::string dir = pre_dir;
+    if (endsWith(dir, "/"))
+    {
+        dir.erase(dir.size() - 1);
+    }
+    // The prefix PreRuntime::Load picks: the directory's name for PreRuntime Compile output
+    const std::string named = dir + "/" + dir + "_addrmap_intm.txt";
+    return addressMapFootprint(exists(named) ? named : dir + "/pp_addrmap_intm.txt");
+}
+
+std::optional<uint32_t> DrpaiMemoryPlanner::modelFootprint(const std::string &model_dir)
+{
+    DIR *dir = opendir(model_dir.c_str());
+    if (dir == nullptr)
+    {
+        return std::nullopt;
+    }
+    std::vector<std::string> maps;
+    while (dirent *entry = readdir(dir))
+    {
+        const std::string name(entry->d_name);
+        if (name == "." || name == ".." || name == "preprocess")
+        {
+            continue;
+        }
+        const std::string subdir = model_dir + "/" + name;
+        if (DIR *sub = opendir(subdir.c_str()))
+        {
+            while (dirent *file = readdir(sub))
+            {
+                if (endsWith(file->d_name, "addrmap_intm.txt"))
+                {
+                    maps.push_back(subdir + "/" + file->d_name);
+                }
+            }
+            closedir(sub);
+        }
+    }
+    closedir(dir);
+
+    if (maps.empty())
+    {
+        return std::nullopt;
+    }
+    uint64_t total = 0;
+    for (const std::string &map : maps)
+    {
+        const auto footprint = addressMapFootprint(map);
+        if (!footprint)
+        {
+            return std::nullopt;
+        }
+        total = alignUp(total, ALIGNMENT) + *footprint;
+    }
+    return static_cast<uint32_t>(std::min<uint64_t>(total, UINT32_MAX));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// @brief Hands out non-overlapping regions of the DRP-AI memory area (DRPAI_GET_DRPAI_AREA) to
+///        the models and PreRuntime bundles loaded into it.
+///
+/// Every MeraDrpRuntimeWrapper and PreRuntime places its objects at a start address and uses the
+/// bytes its address map ends at from there; nothing else keeps two of them apart. Plan each one
+/// here before loading it and pass the address it gets as its start address. allocate() places
+/// regions first-fit from the start of the area, reserve() at a fixed address. Either fails,
+/// without changing the plan, when the region does not fit; report() then says what is where.
+class DrpaiMemoryPlanner
+{
+public:
+    /// @brief Alignment PreRuntime::Load and the DRP-AI require of a start address
+    static const uint32_t ALIGNMENT = 64;
+
+    struct Region
+    {
+        std::string name;
+        uint32_t address;
+        uint32_t size;
+    };
+
+    DrpaiMemoryPlanner(uint32_t area_address, uint32_t area_size);
+
+    /// @brief The lowest free, aligned region of bytes
+    /// @return its address, nullopt if no gap is large enough
+    std::optional<uint32_t> allocate(const std::string &name, uint32_t bytes, uint32_t alignment = ALIGNMENT);
+    /// @brief [address, address + bytes), which must lie inside the area and overlap no region
+    /// @return address, nullopt if it does not fit
+    std::optional<uint32_t> reserve(const std::string &name, uint32_t address, uint32_t bytes);
+
+    /// @brief By address
+    const std::vector<Region> &regions() const { return planned; }
+    uint32_t free_bytes() const;
+    uint32_t largest_free() const;
+    /// @brief Why the last allocate() or reserve() failed; empty if none has
+    const std::string &error() const { return failure; }
+
+    /// @brief The area, every region and gap by address, and the last failure
+    void report(std::ostream &os) const;
+
+    /// @brief Bytes of DRP-AI memory a PreRuntime object directory needs, as PreRuntime::Load
+    ///        reads them from its *_addrmap_intm.txt
+    /// @return nullopt if there is no address map or it is not relocatable
+    static std::optional<uint32_t> preRuntimeFootprint(const std::string &pre_dir);
+    /// @brief Bytes of DRP-AI memory a compiled model needs: the address maps of its DRP-AI
+    ///        subgraphs, the directories of model_dir other than preprocess, one after the other
+    /// @return nullopt if model_dir has none
+    static std::optional<uint32_t> modelFootprint(const std::string &model_dir);
+
+private:
+    /// @brief End of the last entry of an address map, whose first must start at 0
+    static std::optional<uint32_t> addressMapFootprint(const std::string &addrmap_file);
+
+    const uint64_t area_begin;
+    const uint64_t area_end;
+    std::vector<Region> planned;
+    std::string failure;
+};
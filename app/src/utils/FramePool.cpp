@@ -0,0 +1,92 @@
+#include "FramePool.h"
+
+FramePool::FramePool(size_t capacity) : capacity(capacity)
+{
+    free_frames.reserve(capacity);
+}
+
+void FramePool::preallocate(cv::Size size, int type)
+{
+    if (size.width <= 0 || size.height <= 0)
+    {
+        // Backend can't tell us its geometry up front; note_capture() will learn it
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    frame_size = size;
+    frame_type = type;
+    free_frames.clear();
+    while (free_frames.size() < capacity)
+    {
+        free_frames.emplace_back(frame_size, frame_type);
+        counters.preallocated++;
+    }
+}
+
+cv::Mat FramePool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!free_frames.empty())
+    {
+        cv::Mat frame = std::move(free_frames.back());
+        free_frames.pop_back();
+        counters.reuses++;
+        return frame;
+    }
+
+    counters.allocations++;
+    if (frame_type < 0)
+    {
+        // Not sized yet; let the capture backend allocate on first read
+        return cv::Mat();
+    }
+    return cv::Mat(frame_size, frame_type);
+}
+
+void FramePool::release(cv::Mat &&frame)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // Buffers of a stale geometry, or surplus ones, are simply let go
+    if (frame.empty() || frame.size() != frame_size || frame.type() != frame_type || free_frames.size() >= capacity)
+    {
+        frame.release();
+        return;
+    }
+    free_frames.push_back(std::move(frame));
+}
+
+void FramePool::note_capture(const uchar *buffer_before, const cv::Mat &frame)
+{
+    if (frame.data == buffer_before)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.capture_reallocations++;
+    // The camera delivers a different geometry than we sized for; follow it
+    if (frame.size() != frame_size || frame.type() != frame_type)
+    {
+        frame_size = frame.size();
+        frame_type = frame.type();
+        free_frames.clear();
+    }
+}
+
+FramePoolStats FramePool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+std::ostream &operator<<(std::ostream &os, const FramePoolStats &stats)
+{
+    os << "{"
+       << "preallocated: " << stats.preallocated << ", "
+       << "allocations: " << stats.allocations << ", "
+       << "reuses: " << stats.reuses << ", "
+       << "capture_reallocations: " << stats.capture_reallocations
+       << "}";
+    return os;
+}
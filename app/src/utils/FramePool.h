@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+
+struct FramePoolStats
+{
+    // buffers created up front by preallocate()
+    uint64_t preallocated = 0;
+    // buffers created because the pool ran dry; should stay flat once capture is running
+    uint64_t allocations = 0;
+    // acquire() calls served from a recycled buffer
+    uint64_t reuses = 0;
+    // reads where the capture backend swapped our buffer for one of its own
+    uint64_t capture_reallocations = 0;
+};
+
+std::ostream &operator<<(std::ostream &os, const FramePoolStats &stats);
+
+/// @brief Fixed set of frame buffers shared by the capture and processing threads.
+///
+/// The reader acquire()s a buffer and decodes into it; whoever ends up with the frame
+/// (the processor after display, or the reader for a frame the ring evicted) release()s it.
+/// The free list is reserved up front, so recycling never touches the heap.
+class FramePool
+{
+public:
+    explicit FramePool(size_t capacity);
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    /// @brief Allocates capacity buffers of the given geometry, replacing any of another shape
+    void preallocate(cv::Size frame_size, int type);
+
+    cv::Mat acquire();
+    void release(cv::Mat &&frame);
+
+    /// @brief Records whether a capture read kept the buffer it was given
+    void note_capture(const uchar *buffer_before, const cv::Mat &frame);
+
+    FramePoolStats stats() const;
+
+private:
+    const size_t capacity;
+    cv::Size frame_size;
+    int frame_type = -1;
+
+    mutable std::mutex mutex;
+    std::vector<cv::Mat> free_frames;
+    FramePoolStats counters;
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/// @brief What FrameRing::push does when the ring is full
+enum class OverflowPolicy
+{
+    Block,      // producer waits until the consumer frees a slot
+    DropOldest, // oldest queued frame is evicted to make room
+    DropNewest  // incoming frame is rejected
+};
+
+inline const char *to_string(OverflowPolicy policy)
+{
+    switch (policy)
+    {
+    case OverflowPolicy::Block:
+        return "block";
+    case OverflowPolicy::DropOldest:
+        return "drop-oldest";
+    case OverflowPolicy::DropNewest:
+        return "drop-newest";
+    }
+    return "unknown";
+}
+
+struct FrameRingStats
+{
+    uint64_t enqueued = 0;
+    uint64_t dropped = 0;
+    size_t high_water_mark = 0;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const FrameRingStats &stats)
+{
+    os << "{"
+       << "enqueued: " << stats.enqueued << ", "
+       << "dropped: " << stats.dropped << ", "
+       << "high_water_mark: " << stats.high_water_mark
+       << "}";
+    return os;
+}
+
+/// @brief Fixed-capacity single-producer/single-consumer ring of frame slots.
+///
+/// head/tail are monotonically increasing counters; a slot index is counter % slots.size().
+/// The consumer claims a frame by CAS-ing head forward, which is also how the producer evicts
+/// under OverflowPolicy::DropOldest, so both sides agree on who owns the oldest slot.
+/// One spare slot plus reading_slot keep the producer from overwriting a frame the consumer
+/// is still moving out of its slot.
+/// The indices stay lock-free; the mutex/condition variables only exist so that an idle side
+/// can sleep (pop_wait, OverflowPolicy::Block) instead of spinning.
+template <typename T>
+class FrameRing
+{
+public:
+    FrameRing(size_t capacity, OverflowPolicy policy)
+        : slots(capacity + 1), ring_capacity(capacity), policy(policy) {}
+
+    FrameRing(const FrameRing &) = delete;
+    FrameRing &operator=(const FrameRing &) = delete;
+
+    /// @brief Producer side. Enqueues item according to the overflow policy.
+    /// @return The frame that did not make it into the ring (the evicted oldest one, or item
+    ///         itself when rejected or after shutdown), so the caller can recycle it.
+    std::optional<T> push(T &&item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t slot = t % slots.size();
+        std::optional<T> evicted;
+
+        while (true)
+        {
+            if (stopped.load(std::memory_order_acquire))
+            {
+                return std::optional<T>(std::move(item));
+            }
+
+            size_t h = head.load();
+            const bool slot_in_use = reading_slot.load() == slot;
+            if (!slot_in_use && t - h < ring_capacity)
+            {
+                break;
+            }
+
+            if (policy == OverflowPolicy::Block)
+            {
+                std::unique_lock<std::mutex> lock(wait_mutex);
+                not_full.wait_for(lock, BLOCK_WAIT_TIMEOUT, [&]
+                                  { return is_shutdown() || (reading_slot.load() != slot && t - head.load() < ring_capacity); });
+            }
+            else if (policy == OverflowPolicy::DropNewest || slot_in_use)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return std::optional<T>(std::move(item));
+            }
+            else if (head.compare_exchange_strong(h, h + 1))
+            {
+                // We won the oldest slot from the consumer; it is ours to hand back.
+                // Only the producer advances tail, so the ring now has room for item: stop here
+                // rather than go round again and risk evicting a second frame over this one
+                evicted = std::move(slots[h % slots.size()]);
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        slots[slot] = std::move(item);
+        last_push.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        tail.store(t + 1, std::memory_order_release);
+        enqueued.fetch_add(1, std::memory_order_relaxed);
+        {
+            // Taking the lock orders this push against a consumer about to sleep in pop_wait
+            std::lock_guard<std::mutex> lock(wait_mutex);
+        }
+        not_empty.notify_one();
+
+        const size_t depth = t + 1 - head.load(std::memory_order_relaxed);
+        if (depth > high_water.load(std::memory_order_relaxed))
+        {
+            high_water.store(depth, std::memory_order_relaxed);
+        }
+        return evicted;
+    }
+
+    /// @brief Consumer side. Moves the oldest frame into out.
+    /// @return false if the ring is empty
+    bool pop(T &out)
+    {
+        size_t h = head.load();
+        while (true)
+        {
+            if (h == tail.load(std::memory_order_acquire))
+            {
+                // A lost CAS may have left an older claim behind
+                reading_slot.store(NO_SLOT);
+                return false;
+            }
+            // Publish the slot before claiming it so a producer that sees the new head also sees this
+            reading_slot.store(h % slots.size());
+            if (head.compare_exchange_weak(h, h + 1))
+            {
+                break;
+            }
+        }
+
+        out = std::move(slots[h % slots.size()]);
+        reading_slot.store(NO_SLOT);
+        if (policy == OverflowPolicy::Block)
+        {
+            {
+                std::lock_guard<std::mutex> lock(wait_mutex);
+            }
+            not_full.notify_one();
+        }
+        return true;
+    }
+
+    /// @brief Consumer side. Like pop(), but sleeps up to timeout for a frame to arrive.
+    /// @return false on timeout or shutdown with nothing queued
+    template <typename Rep, typename Period>
+    bool pop_wait(T &out, std::chrono::duration<Rep, Period> timeout)
+    {
+        if (pop(out))
+        {
+            return true;
+        }
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            not_empty.wait_for(lock, timeout, [this]
+                               { return size() > 0 || is_shutdown(); });
+        }
+        return pop(out);
+    }
+
+    /// @brief When the producer last published a frame, for wakeup latency measurements
+    std::chrono::steady_clock::time_point last_push_time() const
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_push.load(std::memory_order_relaxed)));
+    }
+
+    /// @brief Wakes up both sides for good; subsequent pushes are rejected
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            stopped.store(true, std::memory_order_release);
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+    bool is_shutdown() const { return stopped.load(std::memory_order_acquire); }
+
+    size_t size() const
+    {
+        // head first: it never passes tail, so this can't underflow
+        const size_t h = head.load();
+        return tail.load() - h;
+    }
+    size_t capacity() const { return ring_capacity; }
+
+    FrameRingStats stats() const
+    {
+        FrameRingStats s;
+        s.enqueued = enqueued.load(std::memory_order_relaxed);
+        s.dropped = dropped.load(std::memory_order_relaxed);
+        s.high_water_mark = high_water.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static constexpr size_t NO_SLOT = SIZE_MAX;
+    // Upper bound on a blocked producer's sleep, should a notification ever be missed
+    static constexpr auto BLOCK_WAIT_TIMEOUT = std::chrono::milliseconds(100);
+
+    std::vector<T> slots;
+    const size_t ring_capacity;
+    const OverflowPolicy policy;
+
+    // Counters are kept on separate cache lines so the two threads don't false-share
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> reading_slot{NO_SLOT};
+    std::atomic<bool> stopped{false};
+    std::atomic<std::chrono::steady_clock::rep> last_push{0};
+
+    std::mutex wait_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<size_t> high_water{0};
+};
@@ -0,0 +1,73 @@
+#include <opencv2/imgproc.hpp>
+
+#include "FrameSource.h"
+#include "OpenCvFrameSource.h"
+#include "RawFileFrameSource.h"
+#include "V4l2FrameSource.h"
+
+namespace
+{
+    const std::string CAMERA_SOURCE = "0";
+    const std::string CAMERA_DEVICE = "/dev/video0";
+    const std::string CAMERA_DEVICE_PREFIX = "/dev/video";
+
+    bool endsWith(const std::string &str, const std::string &suffix)
+    {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+std::unique_ptr<FrameSource> FrameSource::create(const std::string &name, const PipelineConfig &config)
+{
+    const size_t buffers = config.capture_buffer_count();
+
+    if (isCamera(name) && config.capture_backend == CaptureBackend::V4l2)
+    {
+        return std::make_unique<V4l2FrameSource>(name == CAMERA_SOURCE ? CAMERA_DEVICE : name, config.capture_size, config.capture_format, buffers);
+    }
+    if (endsWith(name, ".yuyv"))
+    {
+        return std::make_unique<RawFileFrameSource>(name, config.capture_size, FORMAT_YUYV_422, buffers, config.raw_fps);
+    }
+    if (endsWith(name, ".nv12"))
+    {
+        return std::make_unique<RawFileFrameSource>(name, config.capture_size, FORMAT_NV12_420, buffers, config.raw_fps);
+    }
+    return std::make_unique<OpenCvFrameSource>(name, config.capture_size, buffers);
+}
+
+bool FrameSource::isCamera(const std::string &name)
+{
+    return name == CAMERA_SOURCE || name.compare(0, CAMERA_DEVICE_PREFIX.size(), CAMERA_DEVICE_PREFIX) == 0;
+}
+
+void convertToBgr(const CapturedFrame &frame, cv::Mat &bgr)
+{
+    switch (frame.format)
+    {
+    case FORMAT_YUYV_422:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_YUV2BGR_YUYV);
+        break;
+    case FORMAT_YVYU_422:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_YUV2BGR_YVYU);
+        break;
+    case FORMAT_UYUV_422:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_YUV2BGR_UYVY);
+        break;
+    case FORMAT_NV12_420:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_YUV2BGR_NV12);
+        break;
+    case FORMAT_NV21_420:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_YUV2BGR_NV21);
+        break;
+    case FORMAT_RGB:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_RGB2BGR);
+        break;
+    case FORMAT_GRAY:
+        cv::cvtColor(frame.image, bgr, cv::COLOR_GRAY2BGR);
+        break;
+    default:
+        frame.image.copyTo(bgr);
+        break;
+    }
+}
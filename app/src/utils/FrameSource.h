@@ -0,0 +1,46 @@
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+#include "PipelineConfig.h"
+
+/// @brief Where frames come from. Implementations own the frame buffers and hand out views into them.
+///
+/// Contract: read() fills frame.image with a view into one of the source's buffers (no copy for the
+/// V4L2 and raw-file backends). The buffer stays valid until release() is called with that frame,
+/// which may happen on another thread. A source has a bounded number of buffers; read() blocks
+/// while all of them are out.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool open() = 0;
+    virtual bool read(CapturedFrame &frame) = 0;
+    virtual void release(CapturedFrame &&frame) = 0;
+
+    /// @brief Geometry and FORMAT_* of the frames read() produces, valid once open() succeeded
+    virtual cv::Size frame_size() const = 0;
+    virtual uint16_t pixel_format() const = 0;
+
+    virtual void print_stats(std::ostream &os) const = 0;
+
+    /// @brief Picks a backend for name: "0" or /dev/videoN is a camera (OpenCV or V4L2 per config),
+    ///        *.yuyv / *.nv12 are raw dumps, anything else goes to OpenCV
+    static std::unique_ptr<FrameSource> create(const std::string &name, const PipelineConfig &config);
+    /// @brief True if name selects a camera, whose capture mode can be chosen
+    static bool isCamera(const std::string &name);
+};
+
+inline std::ostream &operator<<(std::ostream &os, const FrameSource &source)
+{
+    source.print_stats(os);
+    return os;
+}
+
+/// @brief Converts a frame of any supported format to BGR, e.g. for display
+void convertToBgr(const CapturedFrame &frame, cv::Mat &bgr);
@@ -0,0 +1,80 @@
+#include <builtin_fp16.h>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#include "HalfFloat.h"
+
+namespace
+{
+    void fromFloatScalar(const float *src, uint16_t *dst, size_t count, size_t i = 0)
+    {
+        for (; i < count; i++)
+        {
+            dst[i] = __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(src[i]);
+        }
+    }
+
+    void toFloatScalar(const uint16_t *src, float *dst, size_t count, size_t i = 0)
+    {
+        for (; i < count; i++)
+        {
+            dst[i] = __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(src[i]);
+        }
+    }
+}
+
+namespace half_float
+{
+    void fromFloat(const float *src, uint16_t *dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        for (; i + 8 <= count; i += 8)
+        {
+            const float16x8_t half = vcombine_f16(vcvt_f16_f32(vld1q_f32(src + i)), vcvt_f16_f32(vld1q_f32(src + i + 4)));
+            vst1q_u16(dst + i, vreinterpretq_u16_f16(half));
+        }
+#elif defined(__F16C__)
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), half);
+        }
+#endif
+        fromFloatScalar(src, dst, count, i);
+    }
+
+    void toFloat(const uint16_t *src, float *dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        for (; i + 8 <= count; i += 8)
+        {
+            const float16x8_t half = vreinterpretq_f16_u16(vld1q_u16(src + i));
+            vst1q_f32(dst + i, vcvt_f32_f16(vget_low_f16(half)));
+            vst1q_f32(dst + i + 4, vcvt_high_f32_f16(half));
+        }
+#elif defined(__F16C__)
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i))));
+        }
+#endif
+        toFloatScalar(src, dst, count, i);
+    }
+
+    const char *instructionSet()
+    {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        return "neon";
+#elif defined(__F16C__)
+        return "f16c";
+#else
+        return "scalar";
+#endif
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__) && !defined(__aarch64__)
+#include <immintrin.h>
+#endif
+
+/// @brief IEEE half precision conversion of whole buffers, for fp16 model inputs and outputs.
+///
+/// Rounds to nearest even like the scalar __truncXfYf2__ from builtin_fp16.h, so the vector
+/// paths (NEON on aarch64, F16C on x86 builds with SPARK_ENABLE_AVX2) produce the same bits.
+namespace half_float
+{
+    void fromFloat(const float *src, uint16_t *dst, size_t count);
+    void toFloat(const uint16_t *src, float *dst, size_t count);
+
+    /// @brief One value, rounded like fromFloat, for kernels that narrow as they store
+    inline uint16_t narrow(float value)
+    {
+        uint16_t bits;
+#if defined(__aarch64__)
+        // A single fcvt; FPCR rounds to nearest even like vcvt_f16_f32
+        const __fp16 half = value;
+        std::memcpy(&bits, &half, sizeof(bits));
+#elif defined(__F16C__)
+        bits = static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#else
+        fromFloat(&value, &bits, 1);
+#endif
+        return bits;
+    }
+
+    /// @brief "neon", "f16c" or "scalar"
+    const char *instructionSet();
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+#include "ImagePyramid.h"
+
+namespace
+{
+    /// @brief 2x2 box of a packed 4:2:2 frame into YUV 4:4:4. One output pixel is one macropixel
+    ///        of two rows; offsets are those of PatchPipeline's PackedYuvSource
+    template <int YOffset, int UOffset, int VOffset>
+    void halvePackedYuv(const cv::Mat &image, const cv::Rect &region, cv::Mat &dst)
+    {
+        cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                          {
+                              for (int y = range.start; y < range.end; y++)
+                              {
+                                  const uchar *row0 = image.ptr<uchar>(region.y + 2 * y) + region.x * 2;
+                                  const uchar *row1 = image.ptr<uchar>(region.y + 2 * y + 1) + region.x * 2;
+                                  uchar *out = dst.ptr<uchar>(y);
+                                  for (int x = 0; x < dst.cols; x++, row0 += 4, row1 += 4, out += 3)
+                                  {
+                                      out[0] = static_cast<uchar>((row0[YOffset] + row0[YOffset + 2] + row1[YOffset] + row1[YOffset + 2] + 2) >> 2);
+                                      out[1] = static_cast<uchar>((row0[UOffset] + row1[UOffset] + 1) >> 1);
+                                      out[2] = static_cast<uchar>((row0[VOffset] + row1[VOffset] + 1) >> 1);
+                                  }
+                              } });
+    }
+
+    /// @brief 2x2 box of a semi-planar 4:2:0 frame into YUV 4:4:4. Each 2x2 luma block has
+    ///        exactly one chroma pair, so chroma is copied rather than averaged
+    template <int UOffset, int VOffset>
+    void halveSemiPlanarYuv(const cv::Mat &image, int height, const cv::Rect &region, cv::Mat &dst)
+    {
+        cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                          {
+                              for (int y = range.start; y < range.end; y++)
+                              {
+                                  const uchar *row0 = image.ptr<uchar>(region.y + 2 * y) + region.x;
+                                  const uchar *row1 = image.ptr<uchar>(region.y + 2 * y + 1) + region.x;
+                                  const uchar *uv = image.ptr<uchar>(height + region.y / 2 + y) + region.x;
+                                  uchar *out = dst.ptr<uchar>(y);
+                                  for (int x = 0; x < dst.cols; x++, row0 += 2, row1 += 2, uv += 2, out += 3)
+                                  {
+                                      out[0] = static_cast<uchar>((row0[0] + row0[1] + row1[0] + row1[1] + 2) >> 2);
+                                      out[1] = uv[UOffset];
+                                      out[2] = uv[VOffset];
+                                  }
+                              } });
+    }
+}
+
+ImagePyramid::ImagePyramid(int max_levels) : deepest(std::max(max_levels, 0)), images(deepest) {}
+
+int ImagePyramid::level_for(cv::Size roi, cv::Size target) const
+{
+    int level = 0;
+    while (level < deepest && (roi.width >> (level + 1)) >= target.width && (roi.height >> (level + 1)) >= target.height)
+    {
+        level++;
+    }
+    return level;
+}
+
+void ImagePyramid::build(const CapturedFrame &frame, const std::vector<cv::Rect> &rois, cv::Size target)
+{
+    built_levels = 0;
+    if (deepest == 0)
+    {
+        return;
+    }
+
+    switch (frame.format)
+    {
+    case FORMAT_BGR:
+    case FORMAT_GRAY:
+        level_color = Color::Bgr;
+        break;
+    case FORMAT_RGB:
+        level_color = Color::Rgb;
+        break;
+    default:
+        level_color = Color::Yuv;
+        break;
+    }
+    // Allocated once for the frame size; every level pixel has a fixed home
+    const cv::Size size = frame.size();
+    for (int level = 1; level <= deepest; level++)
+    {
+        images[level - 1].create(cv::Size(size.width >> level, size.height >> level), CV_8UC3);
+    }
+
+    const cv::Rect bounds(cv::Point(0, 0), size);
+    for (const cv::Rect &roi : rois)
+    {
+        const cv::Rect clipped = roi & bounds;
+        const int level = level_for(clipped.size(), target);
+        const cv::Rect tile = to_level(clipped, level);
+        if (tile.empty())
+        {
+            continue;
+        }
+        // Top-down, each level's tile is exactly the pixels the next one halves
+        for (int k = 1; k <= level; k++)
+        {
+            const int shift = level - k;
+            build_tile(frame, cv::Rect(tile.x << shift, tile.y << shift, tile.width << shift, tile.height << shift), k);
+        }
+        built_levels = std::max(built_levels, level);
+    }
+}
+
+void ImagePyramid::build_tile(const CapturedFrame &frame, const cv::Rect &tile, int level)
+{
+    cv::Mat dst = images[level - 1](tile);
+    const cv::Rect src(tile.x * 2, tile.y * 2, tile.width * 2, tile.height * 2);
+    if (level > 1)
+    {
+        // OpenCV has a dedicated fast path for INTER_AREA at exactly 2x
+        cv::resize(images[level - 2](src), dst, tile.size(), 0, 0, cv::INTER_AREA);
+        return;
+    }
+
+    switch (frame.format)
+    {
+    case FORMAT_BGR:
+    case FORMAT_RGB:
+        cv::resize(frame.image(src), dst, tile.size(), 0, 0, cv::INTER_AREA);
+        break;
+    case FORMAT_GRAY:
+    {
+        thread_local cv::Mat gray;
+        cv::resize(frame.image(src), gray, tile.size(), 0, 0, cv::INTER_AREA);
+        cv::cvtColor(gray, dst, cv::COLOR_GRAY2BGR);
+        break;
+    }
+    case FORMAT_YUYV_422:
+        halvePackedYuv<0, 1, 3>(frame.image, src, dst);
+        break;
+    case FORMAT_YVYU_422:
+        halvePackedYuv<0, 3, 1>(frame.image, src, dst);
+        break;
+    case FORMAT_UYUV_422:
+        halvePackedYuv<1, 0, 2>(frame.image, src, dst);
+        break;
+    case FORMAT_NV12_420:
+        halveSemiPlanarYuv<0, 1>(frame.image, frame.size().height, src, dst);
+        break;
+    case FORMAT_NV21_420:
+        halveSemiPlanarYuv<1, 0>(frame.image, frame.size().height, src, dst);
+        break;
+    default:
+        CV_Assert(false && "ImagePyramid: unsupported frame format");
+    }
+}
+
+cv::Rect ImagePyramid::to_level(const cv::Rect &roi, int level) const
+{
+    if (level < 1 || level > deepest || roi.empty())
+    {
+        return cv::Rect();
+    }
+    const int round_up = (1 << level) - 1;
+    const int x0 = roi.x >> level;
+    const int y0 = roi.y >> level;
+    const int x1 = (roi.x + roi.width + round_up) >> level;
+    const int y1 = (roi.y + roi.height + round_up) >> level;
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect(cv::Point(0, 0), images[level - 1].size());
+}
+
+cv::Rect2d ImagePyramid::window(const cv::Rect &roi, int level) const
+{
+    const cv::Rect covered = to_level(roi, level);
+    const double scale = 1.0 / (1 << level);
+    // Only differs from the exact mapping where an odd frame edge was dropped
+    const double x0 = std::max<double>(roi.x * scale, covered.x);
+    const double y0 = std::max<double>(roi.y * scale, covered.y);
+    const double x1 = std::min<double>((roi.x + roi.width) * scale, covered.x + covered.width);
+    const double y1 = std::min<double>((roi.y + roi.height) * scale, covered.y + covered.height);
+    return cv::Rect2d(x0, y0, x1 - x0, y1 - y0);
+}
+
+cv::Mat ImagePyramid::view(const cv::Rect &level_rect, int level) const
+{
+    return images[level - 1](level_rect);
+}
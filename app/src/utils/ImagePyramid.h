@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+
+/// @brief Successive halvings of the parts of a frame the large ROIs cover, built once per frame.
+///
+/// A ROI many times the patch size costs an area resize in proportion to its pixels, and a
+/// bilinear one reads only two source pixels per output pixel and so aliases. Sampling such a
+/// ROI from the level whose scale is within 2x of the patch's makes both cheap and the cost per
+/// patch about the same for every ROI size. Level k is a 2^-k box filter of the frame, stored as
+/// CV_8UC3 in color() order: packed and semi-planar YUV frames become YUV 4:4:4, gray frames BGR.
+///
+/// Level k pixel (x, y) covers image pixels [x * 2^k, (x + 1) * 2^k) along each axis. Levels are
+/// allocated for the whole frame once, but build() only computes the tiles its ROIs are read
+/// from, so the work per frame is limited to the union of the ROIs, not their bounding box.
+class ImagePyramid
+{
+public:
+    /// @brief Channel order of the levels
+    enum class Color
+    {
+        Bgr,
+        Rgb,
+        Yuv
+    };
+
+    explicit ImagePyramid(int max_levels = 4);
+
+    /// @brief The deepest level, up to max_levels(), at which roi is still at least target on both
+    ///        axes; target is the patch size or a multiple of it, see PatchPipeline::pyramid_target
+    int level_for(cv::Size roi, cv::Size target) const;
+
+    /// @brief Builds, for each of rois (image coordinates) that level_for puts above level 0,
+    ///        the tiles of levels 1..level_for that it is sampled from.
+    ///        frame must be a format PatchPipeline supports
+    void build(const CapturedFrame &frame, const std::vector<cv::Rect> &rois, cv::Size target);
+    /// @brief Forgets what was built, keeping the buffers
+    void clear() { built_levels = 0; }
+
+    int max_levels() const { return deepest; }
+    /// @brief Deepest level the last build() computed tiles for; 0 if none
+    int levels() const { return built_levels; }
+    Color color() const { return level_color; }
+
+    /// @brief Smallest rect of level pixels that covers roi, clipped to the level
+    cv::Rect to_level(const cv::Rect &roi, int level) const;
+    /// @brief roi in level coordinates, sub-pixel, clipped to to_level(roi, level)
+    cv::Rect2d window(const cv::Rect &roi, int level) const;
+    /// @brief The pixels of a rect returned by to_level; valid for the ROIs build() was given
+    cv::Mat view(const cv::Rect &level_rect, int level) const;
+
+private:
+    /// @brief Computes tile of level from the matching pixels of the level above it
+    void build_tile(const CapturedFrame &frame, const cv::Rect &tile, int level);
+
+    int deepest;
+    int built_levels = 0;
+    Color level_color = Color::Bgr;
+    // images[k - 1] is level k, sized for the frame
+    std::vector<cv::Mat> images;
+};
@@ -0,0 +1,31 @@
+#include <algorithm>
+
+#include "InferenceScheduler.h"
+
+InferenceScheduler::InferenceScheduler(double rate_hz, uint32_t every_n_frames)
+    : period(rate_hz > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate_hz)) : Clock::duration::zero()),
+      every_n_frames(std::max<uint32_t>(every_n_frames, 1)) {}
+
+bool InferenceScheduler::should_run(Clock::time_point now)
+{
+    frames++;
+    frames_since_run++;
+    if (!has_run)
+    {
+        // Spots start out unknown, so classify the very first frame
+        return true;
+    }
+    if (period > Clock::duration::zero())
+    {
+        return now - last_run >= period;
+    }
+    return frames_since_run >= every_n_frames;
+}
+
+void InferenceScheduler::mark_run(Clock::time_point now)
+{
+    runs++;
+    frames_since_run = 0;
+    has_run = true;
+    last_run = now;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/// @brief Decides which frames get occupancy inference.
+///
+/// Parking occupancy changes over seconds, so there is no need to classify every frame; the
+/// frames in between are still displayed, using each spot's last known state.
+/// With rate_hz > 0 inference runs at most that often, otherwise on every Nth frame.
+class InferenceScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    InferenceScheduler(double rate_hz, uint32_t every_n_frames);
+
+    /// @brief Call once per displayed frame
+    bool should_run(Clock::time_point now = Clock::now());
+    /// @brief Call when inference actually ran for the current frame
+    void mark_run(Clock::time_point now = Clock::now());
+
+    uint64_t frames_seen() const { return frames; }
+    uint64_t inferences_run() const { return runs; }
+
+private:
+    const Clock::duration period;
+    const uint32_t every_n_frames;
+
+    uint64_t frames = 0;
+    uint64_t runs = 0;
+    uint64_t frames_since_run = 0;
+    bool has_run = false;
+    Clock::time_point last_run;
+};
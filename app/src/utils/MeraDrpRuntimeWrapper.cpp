@@ -25,11 +25,14 @@
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/profiling.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <regex>
 #include <dirent.h>
 #include "MeraDrpRuntimeWrapper.h"
+#include "HalfFloat.h"
 
 template <typename T>
 static std::vector<T> LoadBinary(const std::string &bin_file)
@@ -59,6 +62,88 @@ static std::vector<T> LoadBinary(const std::string &bin_file)
     return std::vector<T>(ptr, ptr + num_elements);
 }
 
+// Alignment SetInputZeroCopy requires of caller memory, tvm::runtime::kAllocAlignment
+static const uintptr_t ZERO_COPY_ALIGNMENT = 64;
+
+static InOutDataType ToInOutDataType(const tvm::runtime::DataType &type)
+{
+    if (type.is_float() && type.bits() == 32)
+    {
+        return InOutDataType::FLOAT32;
+    }
+    if (type.is_float() && type.bits() == 16)
+    {
+        return InOutDataType::FLOAT16;
+    }
+    return InOutDataType::OTHER;
+}
+
+MeraDrpRuntimeWrapper::Binding MeraDrpRuntimeWrapper::MakeBinding(const tvm::runtime::NDArray &array)
+{
+    Binding binding;
+    binding.array = array;
+    binding.data_type = ToInOutDataType(array.DataType());
+    binding.size = 1;
+    for (size_t i = 0; i < array.Shape().size(); ++i)
+    {
+        binding.size *= array.Shape()[i];
+    }
+    binding.bytes = static_cast<size_t>(binding.size) * ((array.DataType().bits() * array.DataType().lanes() + 7) / 8);
+    return binding;
+}
+
+int64_t MeraDrpRuntimeWrapper::LeadingDim(const Binding &binding)
+{
+    return binding.array.Shape().size() > 1 ? std::max<int64_t>(binding.array.Shape()[0], 1) : 1;
+}
+
+static tvm::runtime::Module CreateExecutor(const std::string &json_data, tvm::runtime::Module &mod_syslib, int device_type, int device_id, bool debug)
+{
+    const char *name = debug ? "tvm.graph_executor_debug.create" : "tvm.graph_executor.create";
+    return (*tvm::runtime::Registry::Get(name))(json_data, mod_syslib, device_type, device_id);
+}
+
+double ProfileStats::drp_us() const
+{
+    double total = 0.0;
+    for (const OpTiming &op : ops)
+    {
+        total += op.drp ? op.total_us : 0.0;
+    }
+    return profiled_runs == 0 ? 0.0 : total / profiled_runs;
+}
+
+double ProfileStats::cpu_us() const
+{
+    double total = 0.0;
+    for (const OpTiming &op : ops)
+    {
+        total += op.drp ? 0.0 : op.total_us;
+    }
+    return profiled_runs == 0 ? 0.0 : total / profiled_runs;
+}
+
+std::ostream &operator<<(std::ostream &os, const ProfileStats &stats)
+{
+    os << "{"
+       << "runs: " << stats.runs << ", "
+       << "profiled_runs: " << stats.profiled_runs << ", "
+       << "drp_us: " << stats.drp_us() << ", "
+       << "cpu_us: " << stats.cpu_us() << ", "
+       << "ops: [";
+    for (size_t i = 0; i < stats.ops.size(); ++i)
+    {
+        const OpTiming &op = stats.ops[i];
+        os << (i == 0 ? "" : ", ") << op.name << (op.drp ? " (drp)" : " (cpu)") << ": {"
+           << "mean_us: " << op.mean_us() << ", "
+           << "min_us: " << op.min_us << ", "
+           << "max_us: " << op.max_us << ", "
+           << "last_us: " << op.last_us << "}";
+    }
+    os << "]}";
+    return os;
+}
+
 MeraDrpRuntimeWrapper::MeraDrpRuntimeWrapper()
 {
     device_type = kDLCPU;
@@ -82,8 +167,18 @@ bool MeraDrpRuntimeWrapper::LoadModel(const std::string &model_dir, uint32_t sta
 
     LOG(INFO) << "Loading runtime module...";
     tvm::runtime::Module mod_syslib = tvm::runtime::Module::LoadFromFile(model_dir + "/deploy.so");
-    mod = (*tvm::runtime::Registry::Get("tvm.graph_executor_debug.create"))(
-        json_data, mod_syslib, device_type, device_id);
+    // The debug executor keeps per-op bookkeeping on every run, so it is only used to profile
+    mod = CreateExecutor(json_data, mod_syslib, device_type, device_id, profile_interval > 0);
+    if (profile_interval == 0 && start_address != 0 && mod.GetFunction("set_start_address") == nullptr)
+    {
+        LOG(WARNING) << "graph executor can't place the model at its start address, using the debug executor";
+        mod = CreateExecutor(json_data, mod_syslib, device_type, device_id, true);
+    }
+    profile = mod.GetFunction("profile");
+    if (profile_interval > 0 && profile == nullptr)
+    {
+        LOG(WARNING) << "executor has no profile(), runs are not profiled";
+    }
 
     LOG(INFO) << "Loading parameters...";
     tvm::runtime::PackedFunc load_params = mod.GetFunction("load_params");
@@ -97,42 +192,163 @@ bool MeraDrpRuntimeWrapper::LoadModel(const std::string &model_dir, uint32_t sta
     {
         set_start_address(start_address);
     }
-    return true;
-}
 
-template <typename T>
-void MeraDrpRuntimeWrapper::SetInput(int input_index, const T *data_ptr)
-{
+    LOG(INFO) << "Binding inputs and outputs...";
+    run = mod.GetFunction("run");
+    set_input_zero_copy = mod.GetFunction("set_input_zero_copy");
+    tvm::runtime::PackedFunc set_output_zero_copy = mod.GetFunction("set_output_zero_copy");
     tvm::runtime::PackedFunc get_input = mod.GetFunction("get_input");
-    tvm::runtime::NDArray xx = get_input(0);
-    auto in_shape = xx.Shape();
-    int64_t in_size = 1;
-    for (int i = 0; i < in_shape.size(); ++i)
-    {
-        in_size *= in_shape[i];
-    }
+    tvm::runtime::PackedFunc get_output = mod.GetFunction("get_output");
+    tvm::runtime::PackedFunc get_num_inputs = mod.GetFunction("get_num_inputs");
+    const int num_inputs = get_num_inputs != nullptr ? static_cast<int>(get_num_inputs()) : 1;
+    const int num_outputs = mod.GetFunction("get_num_outputs")();
 
     DLDevice ctx;
     ctx.device_id = device_id;
     ctx.device_type = DLDeviceType(device_type);
 
-    auto input_array = tvm::runtime::NDArray::Empty(in_shape, xx.DataType(), ctx);
-    auto input_data = (T *)(input_array->data);
-    std::memcpy(input_data, data_ptr, sizeof(T) * in_size);
-    tvm::runtime::PackedFunc set_input = mod.GetFunction("set_input");
-    set_input(input_index, input_array);
+    // Older executors, or graphs where an output aliases another entry, refuse zero-copy; their
+    // own entries are just as persistent, only not ours
+    inputs.clear();
+    for (int i = 0; i < num_inputs; ++i)
+    {
+        tvm::runtime::NDArray entry = get_input(i);
+        inputs.push_back(MakeBinding(entry));
+        if (set_input_zero_copy == nullptr)
+        {
+            continue;
+        }
+        tvm::runtime::NDArray array = tvm::runtime::NDArray::Empty(entry.Shape(), entry.DataType(), ctx);
+        try
+        {
+            set_input_zero_copy(i, array);
+            inputs.back().array = array;
+        }
+        catch (const std::exception &e)
+        {
+            LOG(WARNING) << "input " << i << " not bound zero-copy: " << e.what();
+        }
+    }
+    outputs.clear();
+    for (int i = 0; i < num_outputs; ++i)
+    {
+        tvm::runtime::NDArray entry = get_output(i);
+        outputs.push_back(MakeBinding(entry));
+        if (set_output_zero_copy == nullptr)
+        {
+            continue;
+        }
+        tvm::runtime::NDArray array = tvm::runtime::NDArray::Empty(entry.Shape(), entry.DataType(), ctx);
+        try
+        {
+            set_output_zero_copy(i, array);
+            outputs.back().array = array;
+        }
+        catch (const std::exception &e)
+        {
+            LOG(WARNING) << "output " << i << " not bound zero-copy: " << e.what();
+        }
+    }
+    LOG(INFO) << "Compiled batch size: " << GetBatchSize();
+    return true;
+}
+
+template <typename T>
+void MeraDrpRuntimeWrapper::SetInput(int input_index, const T *data_ptr)
+{
+    const TensorView<void *> input = GetInputView(input_index);
+    std::memcpy(input.data, data_ptr, std::min(sizeof(T) * input.size, input.bytes));
 }
 template void MeraDrpRuntimeWrapper::SetInput<float>(int input_index, const float *);
 template void MeraDrpRuntimeWrapper::SetInput<unsigned short>(int input_index, const unsigned short *);
 
 void MeraDrpRuntimeWrapper::Run()
 {
-    mod.GetFunction("run")();
+    Execute();
+}
+
+void MeraDrpRuntimeWrapper::Execute()
+{
+    const uint64_t runs = ++run_count;
+    if (profile == nullptr || profile_interval == 0 || runs % profile_interval != 0)
+    {
+        run();
+        return;
+    }
+    tvm::runtime::Array<tvm::runtime::profiling::MetricCollector> collectors;
+    RecordProfile(profile(collectors));
+}
+
+void MeraDrpRuntimeWrapper::SetProfileInterval(uint32_t every_n)
+{
+    profile_interval = every_n;
+}
+
+ProfileStats MeraDrpRuntimeWrapper::GetProfileStats() const
+{
+    ProfileStats stats;
+    stats.runs = run_count;
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    stats.profiled_runs = profiled_runs;
+    for (const auto &entry : op_timings)
+    {
+        stats.ops.push_back(entry.second);
+    }
+    std::sort(stats.ops.begin(), stats.ops.end(), [](const OpTiming &a, const OpTiming &b)
+              { return a.total_us > b.total_us; });
+    return stats;
+}
+
+void MeraDrpRuntimeWrapper::ResetProfileStats()
+{
+    run_count = 0;
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    profiled_runs = 0;
+    op_timings.clear();
+}
+
+void MeraDrpRuntimeWrapper::RecordProfile(const tvm::runtime::profiling::Report &report)
+{
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    profiled_runs++;
+    for (size_t i = 0; i < report->calls.size(); ++i)
+    {
+        const auto call = report->calls[i];
+        if (call.count("Name") == 0 || call.count("Duration (us)") == 0)
+        {
+            continue;
+        }
+        const auto *duration = call.at("Duration (us)").as<tvm::runtime::profiling::DurationNode>();
+        if (duration == nullptr)
+        {
+            continue;
+        }
+        const std::string name = tvm::runtime::Downcast<tvm::runtime::String>(call.at("Name"));
+        const double us = duration->microseconds;
+
+        OpTiming &timing = op_timings[name];
+        if (timing.samples == 0)
+        {
+            // MERA names its DRP-AI subgraphs *_mera_drp_*; everything else runs on the CPU
+            timing.name = name;
+            timing.drp = name.find("drp") != std::string::npos;
+            timing.min_us = us;
+        }
+        timing.samples++;
+        timing.total_us += us;
+        timing.min_us = std::min(timing.min_us, us);
+        timing.max_us = std::max(timing.max_us, us);
+        timing.last_us = us;
+    }
 }
 
 void MeraDrpRuntimeWrapper::ProfileRun(const std::string &profile_table, const std::string &profile_csv)
 {
-    tvm::runtime::PackedFunc profile = mod.GetFunction("profile");
+    if (profile == nullptr)
+    {
+        LOG(WARNING) << "ProfileRun needs the debug executor, see SetProfileInterval";
+        return;
+    }
     tvm::runtime::Array<tvm::runtime::profiling::MetricCollector> collectors;
     tvm::runtime::profiling::Report report = profile(collectors);
 
@@ -177,43 +393,107 @@ int MeraDrpRuntimeWrapper::GetNumInput(std::string model_dir)
 
 InOutDataType MeraDrpRuntimeWrapper::GetInputDataType(int index)
 {
-    tvm::runtime::PackedFunc get_input = mod.GetFunction("get_input");
-    tvm::runtime::NDArray input_info = get_input(index);
-    InOutDataType data_type = InOutDataType::OTHER;
-    if (input_info.DataType().is_float() && input_info.DataType().bits() == 32)
+    return inputs[index].data_type;
+}
+
+TensorView<void *> MeraDrpRuntimeWrapper::GetInputView(int index)
+{
+    Binding &input = inputs[index];
+    if (input.external)
     {
-        data_type = InOutDataType::FLOAT32;
+        set_input_zero_copy(index, input.array);
+        input.external = false;
     }
-    else if (input_info.DataType().is_float() && input_info.DataType().bits() == 16)
+    return {input.data_type, input.array->data, input.size, input.bytes};
+}
+
+bool MeraDrpRuntimeWrapper::BindInput(int index, const void *data, size_t bytes)
+{
+    Binding &input = inputs[index];
+    if (set_input_zero_copy == nullptr || bytes != input.bytes || reinterpret_cast<uintptr_t>(data) % ZERO_COPY_ALIGNMENT != 0)
+    {
+        return false;
+    }
+
+    // Same shape and type as the bound tensor; only the data pointer is the caller's
+    DLTensor tensor = *input.array.operator->();
+    tensor.data = const_cast<void *>(data);
+    try
     {
-        data_type = InOutDataType::FLOAT16;
+        set_input_zero_copy(index, &tensor);
     }
-    return data_type;
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    input.external = true;
+    return true;
 }
 
 int MeraDrpRuntimeWrapper::GetNumOutput()
 {
-    return mod.GetFunction("get_num_outputs")();
+    return static_cast<int>(outputs.size());
+}
+
+TensorView<const void *> MeraDrpRuntimeWrapper::GetOutputView(int index) const
+{
+    const Binding &output = outputs[index];
+    return {output.data_type, output.array->data, output.size, output.bytes};
 }
 
 std::tuple<InOutDataType, void *, int64_t> MeraDrpRuntimeWrapper::GetOutput(int index)
 {
-    tvm::runtime::PackedFunc get_output = mod.GetFunction("get_output");
-    tvm::runtime::NDArray out = get_output(index);
-    int64_t out_size = 1;
-    for (int i = 0; i < out.Shape().size(); ++i)
-    {
-        out_size *= out.Shape()[i];
-    }
+    const TensorView<const void *> output = GetOutputView(index);
+    return std::make_tuple(output.data_type, const_cast<void *>(output.data), output.size);
+}
+
+int64_t MeraDrpRuntimeWrapper::GetBatchSize() const
+{
+    return inputs.empty() ? 1 : LeadingDim(inputs[0]);
+}
+
+int64_t MeraDrpRuntimeWrapper::GetOutputSizePerItem() const
+{
+    return outputs.empty() ? 0 : outputs[0].size / LeadingDim(outputs[0]);
+}
 
-    InOutDataType data_type = InOutDataType::OTHER;
-    if (out.DataType().is_float() && out.DataType().bits() == 32)
+template <typename T>
+bool MeraDrpRuntimeWrapper::RunBatch(const T *nchw, size_t n, float *out)
+{
+    if (inputs.empty() || outputs.empty() || inputs[0].bytes != sizeof(T) * inputs[0].size ||
+        outputs[0].data_type == InOutDataType::OTHER)
     {
-        data_type = InOutDataType::FLOAT32;
+        return false;
     }
-    else if (out.DataType().is_float() && out.DataType().bits() == 16)
+
+    const size_t batch = static_cast<size_t>(GetBatchSize());
+    const size_t item_bytes = inputs[0].bytes / batch;
+    const size_t item_outputs = static_cast<size_t>(GetOutputSizePerItem());
+    const uint8_t *items = reinterpret_cast<const uint8_t *>(nchw);
+    for (size_t begin = 0; begin < n; begin += batch)
     {
-        data_type = InOutDataType::FLOAT16;
+        const size_t count = std::min(batch, n - begin);
+        const uint8_t *chunk = items + begin * item_bytes;
+        // A full batch is read in place where the executor allows it. A short last batch is
+        // copied; the items after it still hold the previous run's and their outputs are dropped
+        if (count < batch || !BindInput(0, chunk, inputs[0].bytes))
+        {
+            std::memcpy(GetInputView(0).data, chunk, count * item_bytes);
+        }
+        Execute();
+
+        const TensorView<const void *> output = GetOutputView(0);
+        float *logits = out + begin * item_outputs;
+        if (output.data_type == InOutDataType::FLOAT16)
+        {
+            half_float::toFloat(static_cast<const uint16_t *>(output.data), logits, count * item_outputs);
+        }
+        else
+        {
+            std::memcpy(logits, output.data, count * item_outputs * sizeof(float));
+        }
     }
-    return std::make_tuple(data_type, reinterpret_cast<void *>(out->data), out_size);
+    return true;
 }
+template bool MeraDrpRuntimeWrapper::RunBatch<float>(const float *, size_t, float *);
+template bool MeraDrpRuntimeWrapper::RunBatch<unsigned short>(const unsigned short *, size_t, float *);
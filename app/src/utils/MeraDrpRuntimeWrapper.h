@@ -20,7 +20,19 @@
  * under the License.
  *
 */
+#pragma once
+
 #include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/profiling.h>
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
 enum class InOutDataType {
   FLOAT32,
@@ -28,24 +40,121 @@ enum class InOutDataType {
   OTHER
 };
 
+// A model input or output as bound to the executor at LoadModel
+template <typename Data>
+struct TensorView {
+  InOutDataType data_type;
+  Data data;
+  // elements
+  int64_t size;
+  size_t bytes;
+};
+
+// Timings of one operator of the graph over the runs Run() profiled
+struct OpTiming {
+  std::string name;
+  // A DRP-AI subgraph, as opposed to an op the CPU runs
+  bool drp = false;
+  uint64_t samples = 0;
+  double total_us = 0.0;
+  double min_us = 0.0;
+  double max_us = 0.0;
+  double last_us = 0.0;
+
+  double mean_us() const { return samples == 0 ? 0.0 : total_us / samples; }
+};
+
+// What the sampled profiling of Run() has seen since the last ResetProfileStats()
+struct ProfileStats {
+  uint64_t runs = 0;
+  uint64_t profiled_runs = 0;
+  // Longest total time first
+  std::vector<OpTiming> ops;
+
+  // Mean time per profiled run spent in DRP-AI subgraphs and in CPU ops
+  double drp_us() const;
+  double cpu_us() const;
+};
+
+std::ostream& operator<<(std::ostream& os, const ProfileStats& stats);
+
 class MeraDrpRuntimeWrapper {
  public:
   MeraDrpRuntimeWrapper();
   ~MeraDrpRuntimeWrapper();
 
+  // Also looks up every PackedFunc used per run and binds one persistent tensor per input and
+  // output, so Run() and the accessors below neither look up functions nor allocate
   bool LoadModel(const std::string& model_dir, uint32_t start_address);
+  // 0, the default, loads the plain graph executor. N > 0 loads the debug executor instead and
+  // runs every Nth Run() through its profile(), which executes the graph op by op and so also
+  // produces the outputs; the per-op timings go to GetProfileStats(). Applies from the next LoadModel
+  void SetProfileInterval(uint32_t every_n);
+  // Safe to call from any thread, also while another one is in Run()
+  ProfileStats GetProfileStats() const;
+  void ResetProfileStats();
+  // Copies one input's worth of T into the bound input tensor
   template <typename T>
   void SetInput(int input_index, const T* data_ptr);
   void Run();
   void ProfileRun(const std::string& profile_table, const std::string& profile_csv);
   int GetNumInput(std::string model_dir);
   InOutDataType GetInputDataType(int index);
+  // The bound input tensor, writable: data written here is what the next Run() consumes
+  TensorView<void*> GetInputView(int index);
+  // Runs the next Run() on data itself, which must stay valid until then. False if the executor
+  // can't bind it (no set_input_zero_copy, not 64-byte aligned or not the input's size); write
+  // into GetInputView instead, which switches back to the bound tensor
+  bool BindInput(int index, const void* data, size_t bytes);
   int GetNumOutput();
 
+  // Items one Run() takes: the leading dimension of input 0, 1 for models compiled at batch 1
+  int64_t GetBatchSize() const;
+  // Elements of output 0 per item, e.g. the logits of one patch
+  int64_t GetOutputSizePerItem() const;
+  // Runs n items of input 0, contiguous NCHW, GetBatchSize() at a time (one Run() per item for
+  // batch-1 models) and writes GetOutputSizePerItem() floats per item to out. T is the input's
+  // element type: float for fp32 models, unsigned short (raw fp16) for fp16 ones. False if it
+  // isn't or output 0 is not floating point
+  template <typename T>
+  bool RunBatch(const T* nchw, size_t n, float* out);
+
+  // The bound output tensor, read-only: what the last Run() produced, valid until the next one
+  TensorView<const void*> GetOutputView(int index) const;
   std::tuple<InOutDataType, void*, int64_t> GetOutput(int index);
 
  private:
+  struct Binding {
+    tvm::runtime::NDArray array;
+    InOutDataType data_type;
+    int64_t size;
+    size_t bytes;
+    // Input only: the executor reads from caller memory given to BindInput, not from array
+    bool external = false;
+  };
+
+  // array is owned by us and bound zero-copy where the executor allows, its own entry otherwise
+  static Binding MakeBinding(const tvm::runtime::NDArray& array);
+  static int64_t LeadingDim(const Binding& binding);
+  // One run of the graph, through profile() on every profile_interval-th call; what Run() and
+  // RunBatch() both execute
+  void Execute();
+  void RecordProfile(const tvm::runtime::profiling::Report& report);
+
   int device_type;
   int device_id;
   tvm::runtime::Module mod;
+  tvm::runtime::PackedFunc run;
+  tvm::runtime::PackedFunc set_input_zero_copy;
+  std::vector<Binding> inputs;
+  std::vector<Binding> outputs;
+
+  uint32_t profile_interval = 0;
+  // Only the debug executor has it
+  tvm::runtime::PackedFunc profile;
+  std::atomic<uint64_t> run_count{0};
+  mutable std::mutex profile_mutex;
+  // Guarded by profile_mutex
+  uint64_t profiled_runs = 0;
+  std::map<std::string, OpTiming> op_timings;
 };
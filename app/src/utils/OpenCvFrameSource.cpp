@@ -0,0 +1,63 @@
+#include <opencv2/videoio.hpp>
+
+#include "OpenCvFrameSource.h"
+
+OpenCvFrameSource::OpenCvFrameSource(const std::string &name, cv::Size requested_size, size_t buffer_count)
+    : name(name), requested_size(requested_size), pool(buffer_count) {}
+
+bool OpenCvFrameSource::open()
+{
+    if (name == "0")
+    {
+        cap.open(0);
+        cap.set(cv::CAP_PROP_FRAME_WIDTH, requested_size.width);
+        cap.set(cv::CAP_PROP_FRAME_HEIGHT, requested_size.height);
+    }
+    else if (name.compare(0, 10, "/dev/video") == 0)
+    {
+        // Additional cameras of a multi-camera lot
+        cap.open(name);
+        cap.set(cv::CAP_PROP_FRAME_WIDTH, requested_size.width);
+        cap.set(cv::CAP_PROP_FRAME_HEIGHT, requested_size.height);
+    }
+    else
+    {
+        cap.open(name);
+    }
+
+    if (!cap.isOpened())
+    {
+        return false;
+    }
+
+    size = cv::Size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    pool.preallocate(size, CV_8UC3);
+    return true;
+}
+
+bool OpenCvFrameSource::read(CapturedFrame &frame)
+{
+    // Decode into a recycled buffer; the previous one may still be queued or on screen
+    frame.image = pool.acquire();
+    const uchar *buffer = frame.image.data;
+    if (!cap.read(frame.image) || frame.image.empty())
+    {
+        return false;
+    }
+    pool.note_capture(buffer, frame.image);
+
+    frame.format = FORMAT_BGR;
+    frame.buffer_index = -1;
+    frame.captured_at = CapturedFrame::Clock::now();
+    return true;
+}
+
+void OpenCvFrameSource::release(CapturedFrame &&frame)
+{
+    pool.release(std::move(frame.image));
+}
+
+void OpenCvFrameSource::print_stats(std::ostream &os) const
+{
+    os << "{backend: opencv, pool: " << pool.stats() << "}";
+}
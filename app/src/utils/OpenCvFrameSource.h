@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "FramePool.h"
+#include "FrameSource.h"
+
+/// @brief cv::VideoCapture backend. Decodes to BGR into recycled FramePool buffers.
+class OpenCvFrameSource : public FrameSource
+{
+public:
+    OpenCvFrameSource(const std::string &name, cv::Size requested_size, size_t buffer_count);
+
+    bool open() override;
+    bool read(CapturedFrame &frame) override;
+    void release(CapturedFrame &&frame) override;
+
+    cv::Size frame_size() const override { return size; }
+    uint16_t pixel_format() const override { return FORMAT_BGR; }
+
+    void print_stats(std::ostream &os) const override;
+
+private:
+    const std::string name;
+    const cv::Size requested_size;
+    cv::Size size;
+    cv::VideoCapture cap;
+    FramePool pool;
+};
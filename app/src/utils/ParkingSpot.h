@@ -5,6 +5,8 @@
 #include <iostream>
 #include <opencv2/core.hpp>
 
+#include "ResamplePlan.h"
+
 class ParkingSpot
 {
     using TimePoint = std::chrono::system_clock::time_point;
@@ -24,6 +26,9 @@ public:
     bool is_online;
     bool is_occupied;
     size_t slot_id;
+    // Taps for sampling coords into the model's input patch. Built on the first frame after the spot
+    // is created (drawn or deserialized) and kept while the frame geometry and input spec stay the same
+    resample::PlanPtr resample_plan;
 
 private:
     // a parking space is online if DRP-AI is running inference for it
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include "PatchBatch.h"
+
+PatchBatch::PatchBatch(const patch_sampler::PatchPipeline &pipeline, int pyramid_levels)
+    : pipeline(pipeline), bytes(pipeline.patch_bytes()), pyramid(pyramid_levels), tensors{std::make_shared<cv::Mat>()} {}
+
+void PatchBatch::clear()
+{
+    entries.clear();
+    for (size_t k = 1; k <= tensors.size(); k++)
+    {
+        const size_t i = (current + k) % tensors.size();
+        if (tensors[i].use_count() == 1)
+        {
+            // Pairs with the release of the last share(): whoever read the tensor is done with it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            current = i;
+            return;
+        }
+    }
+    tensors.push_back(std::make_shared<cv::Mat>());
+    current = tensors.size() - 1;
+}
+
+std::shared_ptr<const void> PatchBatch::share(size_t i) const
+{
+    return std::shared_ptr<const void>(tensors[current], tensors[current]->data + i * bytes);
+}
+
+void PatchBatch::add(size_t spot_index, const cv::Rect &roi, resample::PlanPtr &plan)
+{
+    entries.push_back({spot_index, roi, &plan});
+    cv::Mat &tensor = this->tensor();
+    if (tensor.total() < entries.size() * bytes)
+    {
+        // Nothing is sampled before fill(), so reallocating drops nothing; doubling keeps the
+        // number of reallocations logarithmic in the largest batch
+        const size_t patches = std::max(entries.size(), 2 * tensor.total() / bytes);
+        tensor.create(1, static_cast<int>(patches * bytes), CV_8U);
+    }
+}
+
+void PatchBatch::build_pyramid(const CapturedFrame &frame)
+{
+    pyramid.clear();
+    if (pyramid.max_levels() == 0 || entries.empty())
+    {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    rois.clear();
+    for (const Entry &entry : entries)
+    {
+        rois.push_back(entry.roi);
+    }
+    pyramid.build(frame, rois, pipeline.pyramid_target());
+    if (pyramid.levels() > 0)
+    {
+        batch_stats.pyramid_time.record(std::chrono::steady_clock::now() - start);
+    }
+}
+
+void PatchBatch::fill(const CapturedFrame &frame, size_t begin, size_t end)
+{
+    end = std::min(end, entries.size());
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Patches are independent: each task reads the shared frame and writes its own slice and plan
+    cv::parallel_for_(cv::Range(static_cast<int>(begin), static_cast<int>(end)), [&](const cv::Range &range)
+                      {
+                          for (int i = range.start; i < range.end; i++)
+                          {
+                              const Entry &entry = entries[i];
+                              pipeline.sample(frame, pyramid, entry.roi, *entry.plan, tensor().data + i * bytes);
+                          } });
+
+    batch_stats.fill_time.record(std::chrono::steady_clock::now() - start);
+    batch_stats.patches += end - begin;
+    if (pyramid.levels() > 0)
+    {
+        const cv::Rect bounds(cv::Point(0, 0), frame.size());
+        for (size_t i = begin; i < end; i++)
+        {
+            batch_stats.pyramid_patches += pyramid.level_for((entries[i].roi & bounds).size(), pipeline.pyramid_target()) > 0;
+        }
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const BatchStats &stats)
+{
+    const uint64_t batches = stats.fill_time.samples();
+    os << "{"
+       << "batches: " << batches << ", "
+       << "mean_patches: " << (batches == 0 ? 0.0 : static_cast<double>(stats.patches) / batches) << ", "
+       << "fill: " << stats.fill_time << ", "
+       << "pyramid_patches: " << stats.pyramid_patches << ", "
+       << "pyramid: " << stats.pyramid_time
+       << "}";
+    return os;
+}
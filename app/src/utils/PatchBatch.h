@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+#include "ImagePyramid.h"
+#include "PatchPipeline.h"
+#include "PipelineStats.h"
+#include "ResamplePlan.h"
+
+/// @brief Time spent filling batches and how many patches they held
+struct BatchStats
+{
+    LatencyStats fill_time;
+    LatencyStats pyramid_time;
+    uint64_t patches = 0;
+    // patches read from a pyramid level rather than the frame
+    uint64_t pyramid_patches = 0;
+};
+
+std::ostream &operator<<(std::ostream &os, const BatchStats &stats);
+
+/// @brief Model input for every spot of a frame that needs inference, as one contiguous
+///        N x 3 x H x W tensor of the pipeline's output type.
+///
+/// Spots are queued with add() and sampled together by fill(), which spreads the patches over
+/// OpenCV's worker threads. Patch i is the tensor of spot_index(i). Each clear() moves on to a
+/// tensor no share() holds any more, so a frame still queued for inference is never refilled;
+/// tensors keep their capacity, so once there is one per frame in flight nothing is allocated.
+///
+/// With pyramid levels enabled, build_pyramid() halves the frame under the queued ROIs large
+/// enough to be read from a level (PatchPipeline::pyramid_target) and fill() samples those from
+/// the level closest to their scale.
+class PatchBatch
+{
+public:
+    /// @param pyramid_levels Deepest ImagePyramid level; 0 samples every ROI from the frame
+    explicit PatchBatch(const patch_sampler::PatchPipeline &pipeline, int pyramid_levels = 0);
+
+    void clear();
+    /// @brief Queues a patch of roi for spot_index; plan is the spot's resample cache and must
+    ///        stay valid until fill() returns
+    void add(size_t spot_index, const cv::Rect &roi, resample::PlanPtr &plan);
+    /// @brief Builds the pyramid, then samples every queued patch from frame, in parallel
+    void fill(const CapturedFrame &frame)
+    {
+        build_pyramid(frame);
+        fill(frame, 0, entries.size());
+    }
+    /// @brief Builds the pyramid tiles the queued ROIs are sampled from.
+    ///        Call once all spots are queued and before fill()ing ranges
+    void build_pyramid(const CapturedFrame &frame);
+    /// @brief Samples patches [begin, end) only. Storage is sized by add(), so patches outside
+    ///        the range may be read while it is filled
+    void fill(const CapturedFrame &frame, size_t begin, size_t end);
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    size_t spot_index(size_t i) const { return entries[i].spot_index; }
+
+    /// @brief Bytes of one 3 x H x W patch
+    size_t patch_bytes() const { return bytes; }
+    /// @brief Patch i; 64-byte aligned whenever patch_bytes() is a multiple of 64, so the
+    ///        runtime can read it in place, see MeraDrpRuntimeWrapper::BindInput
+    const void *patch(size_t i) const { return tensor().data + i * bytes; }
+    /// @brief The whole [size(), 3, H, W] tensor
+    const void *data() const { return tensor().data; }
+    /// @brief patch(i) onwards, holding this frame's tensor out of the rotation until released,
+    ///        e.g. by AsyncInference once the patches have run
+    std::shared_ptr<const void> share(size_t i) const;
+
+    const BatchStats &stats() const { return batch_stats; }
+    void reset_stats() { batch_stats = BatchStats(); }
+
+private:
+    struct Entry
+    {
+        size_t spot_index;
+        cv::Rect roi;
+        resample::PlanPtr *plan;
+    };
+
+    const patch_sampler::PatchPipeline &pipeline;
+    const size_t bytes;
+    ImagePyramid pyramid;
+    std::vector<cv::Rect> rois;
+    std::vector<Entry> entries;
+    cv::Mat &tensor() const { return *tensors[current]; }
+
+    // Element type is the pipeline's; cv::Mat storage is 64-byte aligned, as zero-copy needs.
+    // tensors[current] is this frame's
+    std::vector<std::shared_ptr<cv::Mat>> tensors;
+    size_t current = 0;
+    BatchStats batch_stats;
+};
@@ -0,0 +1,475 @@
+#include <algorithm>
+
+#include "Downscale.h"
+#include "HalfFloat.h"
+#include "PatchPipeline.h"
+
+namespace
+{
+    using patch_sampler::OutputType;
+    using Kernel = patch_sampler::PatchPipeline::Kernel;
+    using Normalization = patch_sampler::PatchPipeline::Normalization;
+
+    // The classifier's input; other sizes get kernels that read the size from the plan
+    const int MODEL_SIDE = 28;
+
+    /// @brief How a normalised channel value is stored in the tensor
+    template <OutputType Out>
+    struct Writer;
+
+    template <>
+    struct Writer<OutputType::Float32>
+    {
+        using type = float;
+        static type store(float rgb, float scale, float bias) { return rgb * scale + bias; }
+    };
+
+    template <>
+    struct Writer<OutputType::Float16>
+    {
+        using type = uint16_t;
+        // Narrowed as it is stored, so fp16 patches take no fp32 round trip through memory
+        static type store(float rgb, float scale, float bias) { return half_float::narrow(rgb * scale + bias); }
+    };
+
+    template <>
+    struct Writer<OutputType::Uint8>
+    {
+        using type = uint8_t;
+        // rgb is already within 0..255
+        static type store(float rgb, float, float) { return static_cast<type>(rgb + 0.5f); }
+    };
+
+    // Sources accumulate weighted pixels in the frame's own colour space and convert the blended
+    // result to RGB once per output pixel. The byte layout is a template argument, so accumulate()
+    // compiles to fixed offsets.
+
+    inline void yuvToRgb(const float acc[3], float rgb[3])
+    {
+        // BT.601 limited range, the conversion cvtColor applies to camera YUV
+        const float luma = 1.164f * std::max(acc[0] - 16.0f, 0.0f);
+        const float u = acc[1] - 128.0f;
+        const float v = acc[2] - 128.0f;
+        rgb[0] = std::min(255.0f, std::max(0.0f, luma + 1.596f * v));
+        rgb[1] = std::min(255.0f, std::max(0.0f, luma - 0.813f * v - 0.391f * u));
+        rgb[2] = std::min(255.0f, std::max(0.0f, luma + 2.018f * u));
+    }
+
+    template <bool Bgr>
+    struct ColorSource
+    {
+        const uchar *data;
+        const size_t step;
+
+        explicit ColorSource(const CapturedFrame &frame) : data(frame.image.data), step(frame.image.step[0]) {}
+
+        void accumulate(int x, int y, float weight, float acc[3]) const
+        {
+            const uchar *pixel = data + y * step + 3 * x;
+            acc[0] += weight * pixel[0];
+            acc[1] += weight * pixel[1];
+            acc[2] += weight * pixel[2];
+        }
+
+        static void toRgb(const float acc[3], float rgb[3])
+        {
+            rgb[0] = acc[Bgr ? 2 : 0];
+            rgb[1] = acc[1];
+            rgb[2] = acc[Bgr ? 0 : 2];
+        }
+    };
+
+    struct GraySource
+    {
+        const uchar *data;
+        const size_t step;
+
+        explicit GraySource(const CapturedFrame &frame) : data(frame.image.data), step(frame.image.step[0]) {}
+
+        void accumulate(int x, int y, float weight, float acc[3]) const
+        {
+            acc[0] += weight * data[y * step + x];
+        }
+
+        static void toRgb(const float acc[3], float rgb[3])
+        {
+            rgb[0] = rgb[1] = rgb[2] = acc[0];
+        }
+    };
+
+    /// @brief Packed 4:2:2; offsets of Y (of the even pixel), U and V inside the 4-byte macropixel
+    template <int YOffset, int UOffset, int VOffset>
+    struct PackedYuvSource
+    {
+        const uchar *data;
+        const size_t step;
+
+        explicit PackedYuvSource(const CapturedFrame &frame) : data(frame.image.data), step(frame.image.step[0]) {}
+
+        void accumulate(int x, int y, float weight, float acc[3]) const
+        {
+            const uchar *macropixel = data + y * step + (x & ~1) * 2;
+            acc[0] += weight * macropixel[YOffset + (x & 1) * 2];
+            acc[1] += weight * macropixel[UOffset];
+            acc[2] += weight * macropixel[VOffset];
+        }
+
+        static void toRgb(const float acc[3], float rgb[3]) { yuvToRgb(acc, rgb); }
+    };
+
+    /// @brief Semi-planar 4:2:0; offsets of U and V inside the interleaved chroma pair
+    template <int UOffset, int VOffset>
+    struct SemiPlanarYuvSource
+    {
+        const uchar *data;
+        const size_t step;
+        const uchar *chroma;
+
+        explicit SemiPlanarYuvSource(const CapturedFrame &frame)
+            : data(frame.image.data), step(frame.image.step[0]), chroma(frame.image.data + frame.size().height * frame.image.step[0]) {}
+
+        void accumulate(int x, int y, float weight, float acc[3]) const
+        {
+            const uchar *uv = chroma + (y / 2) * step + (x & ~1);
+            acc[0] += weight * data[y * step + x];
+            acc[1] += weight * uv[UOffset];
+            acc[2] += weight * uv[VOffset];
+        }
+
+        static void toRgb(const float acc[3], float rgb[3]) { yuvToRgb(acc, rgb); }
+    };
+
+    /// @brief Gathers and blends the plan's taps straight from the frame. W and H are the patch
+    ///        size, or 0 to take it from the plan; Taps is the number of taps per output along each
+    ///        axis (1 nearest, 2 bilinear), or 0 for area plans, whose count varies
+    template <typename Source, OutputType Out, int W, int H, int Taps>
+    void gather(const CapturedFrame &frame, const resample::Plan &plan, const Normalization &norm, void *out)
+    {
+        using T = typename Writer<Out>::type;
+        const int width = W > 0 ? W : plan.size.width;
+        const int height = H > 0 ? H : plan.size.height;
+        const int plane = width * height;
+        const Source source(frame);
+        const resample::AxisPlan &xs = plan.x;
+        const resample::AxisPlan &ys = plan.y;
+        T *dst = static_cast<T *>(out);
+
+        for (int oy = 0; oy < height; oy++)
+        {
+            const int y_begin = Taps > 0 ? oy * Taps : ys.begin[oy];
+            const int y_end = Taps > 0 ? y_begin + Taps : ys.begin[oy + 1];
+            for (int ox = 0; ox < width; ox++)
+            {
+                const int x_begin = Taps > 0 ? ox * Taps : xs.begin[ox];
+                const int x_end = Taps > 0 ? x_begin + Taps : xs.begin[ox + 1];
+                float acc[3] = {0.0f, 0.0f, 0.0f};
+                for (int ty = y_begin; ty < y_end; ty++)
+                {
+                    const int y = plan.roi.y + ys.taps[ty].index;
+                    const float wy = ys.taps[ty].weight;
+                    for (int tx = x_begin; tx < x_end; tx++)
+                    {
+                        source.accumulate(plan.roi.x + xs.taps[tx].index, y, wy * xs.taps[tx].weight, acc);
+                    }
+                }
+
+                float rgb[3];
+                Source::toRgb(acc, rgb);
+                const int offset = oy * width + ox;
+                dst[offset] = Writer<Out>::store(rgb[0], norm.scale[0], norm.bias[0]);
+                dst[plane + offset] = Writer<Out>::store(rgb[1], norm.scale[1], norm.bias[1]);
+                dst[2 * plane + offset] = Writer<Out>::store(rgb[2], norm.scale[2], norm.bias[2]);
+            }
+        }
+    }
+
+    template <typename Source, OutputType Out, int W, int H>
+    void gatherKernel(const CapturedFrame &frame, const resample::Plan &plan, const Normalization &norm, void *out)
+    {
+        // What the plan implements can differ per ROI (area enlarging is bilinear), so this is decided per patch
+        switch (plan.interpolation)
+        {
+        case resample::Interpolation::Nearest:
+            gather<Source, Out, W, H, 1>(frame, plan, norm, out);
+            break;
+        case resample::Interpolation::Bilinear:
+            gather<Source, Out, W, H, 2>(frame, plan, norm, out);
+            break;
+        default:
+            gather<Source, Out, W, H, 0>(frame, plan, norm, out);
+            break;
+        }
+    }
+
+    /// @brief BGR/RGB: the SIMD downscale kernels, then one planar pass over the small patch
+    template <bool Bgr, OutputType Out, int W, int H>
+    void colorKernel(const CapturedFrame &frame, const resample::Plan &plan, const Normalization &norm, void *out)
+    {
+        if (plan.interpolation == resample::Interpolation::Nearest)
+        {
+            gather<ColorSource<Bgr>, Out, W, H, 1>(frame, plan, norm, out);
+            return;
+        }
+
+        thread_local cv::Mat patch;
+        downscale::resize(frame.image(plan.roi), patch, plan);
+
+        using T = typename Writer<Out>::type;
+        const int width = W > 0 ? W : plan.size.width;
+        const int height = H > 0 ? H : plan.size.height;
+        const int plane = width * height;
+        T *dst = static_cast<T *>(out);
+        for (int c = 0; c < 3; c++)
+        {
+            const int src_channel = Bgr ? 2 - c : c;
+            const float scale = norm.scale[c];
+            const float bias = norm.bias[c];
+            T *channel = dst + c * plane;
+            for (int y = 0; y < height; y++)
+            {
+                const uchar *row = patch.ptr<uchar>(y);
+                for (int x = 0; x < width; x++)
+                {
+                    *channel++ = Writer<Out>::store(row[3 * x + src_channel], scale, bias);
+                }
+            }
+        }
+    }
+
+    /// @brief Planar pass over a patch resampled from a pyramid level of the given colour order
+    template <ImagePyramid::Color Color, OutputType Out>
+    void storeLevelPatch(const cv::Mat &patch, const Normalization &norm, void *out)
+    {
+        using T = typename Writer<Out>::type;
+        const int plane = patch.rows * patch.cols;
+        T *dst = static_cast<T *>(out);
+        for (int y = 0; y < patch.rows; y++)
+        {
+            const uchar *row = patch.ptr<uchar>(y);
+            for (int x = 0; x < patch.cols; x++, row += 3)
+            {
+                float rgb[3];
+                if (Color == ImagePyramid::Color::Yuv)
+                {
+                    const float yuv[3] = {static_cast<float>(row[0]), static_cast<float>(row[1]), static_cast<float>(row[2])};
+                    yuvToRgb(yuv, rgb);
+                }
+                else
+                {
+                    rgb[0] = row[Color == ImagePyramid::Color::Bgr ? 2 : 0];
+                    rgb[1] = row[1];
+                    rgb[2] = row[Color == ImagePyramid::Color::Bgr ? 0 : 2];
+                }
+                const int offset = y * patch.cols + x;
+                dst[offset] = Writer<Out>::store(rgb[0], norm.scale[0], norm.bias[0]);
+                dst[plane + offset] = Writer<Out>::store(rgb[1], norm.scale[1], norm.bias[1]);
+                dst[2 * plane + offset] = Writer<Out>::store(rgb[2], norm.scale[2], norm.bias[2]);
+            }
+        }
+    }
+
+    template <OutputType Out>
+    void storeLevelPatch(ImagePyramid::Color color, const cv::Mat &patch, const Normalization &norm, void *out)
+    {
+        switch (color)
+        {
+        case ImagePyramid::Color::Bgr:
+            storeLevelPatch<ImagePyramid::Color::Bgr, Out>(patch, norm, out);
+            break;
+        case ImagePyramid::Color::Rgb:
+            storeLevelPatch<ImagePyramid::Color::Rgb, Out>(patch, norm, out);
+            break;
+        case ImagePyramid::Color::Yuv:
+            storeLevelPatch<ImagePyramid::Color::Yuv, Out>(patch, norm, out);
+            break;
+        }
+    }
+
+    template <OutputType Out>
+    void fillBlack(const Normalization &norm, int plane, void *out)
+    {
+        using T = typename Writer<Out>::type;
+        T *dst = static_cast<T *>(out);
+        for (int c = 0; c < 3; c++)
+        {
+            std::fill(dst + c * plane, dst + (c + 1) * plane, Writer<Out>::store(0.0f, norm.scale[c], norm.bias[c]));
+        }
+    }
+
+    void fillBlack(OutputType output, const Normalization &norm, int plane, void *out)
+    {
+        switch (output)
+        {
+        case OutputType::Float16:
+            fillBlack<OutputType::Float16>(norm, plane, out);
+            break;
+        case OutputType::Uint8:
+            fillBlack<OutputType::Uint8>(norm, plane, out);
+            break;
+        default:
+            fillBlack<OutputType::Float32>(norm, plane, out);
+            break;
+        }
+    }
+
+    void storeLevelPatch(OutputType output, ImagePyramid::Color color, const cv::Mat &patch, const Normalization &norm, void *out)
+    {
+        switch (output)
+        {
+        case OutputType::Float16:
+            storeLevelPatch<OutputType::Float16>(color, patch, norm, out);
+            break;
+        case OutputType::Uint8:
+            storeLevelPatch<OutputType::Uint8>(color, patch, norm, out);
+            break;
+        default:
+            storeLevelPatch<OutputType::Float32>(color, patch, norm, out);
+            break;
+        }
+    }
+
+    /// @brief Kernel slot of a FORMAT_*, -1 if there is none
+    int formatSlot(uint16_t format)
+    {
+        switch (format)
+        {
+        case FORMAT_BGR:
+            return 0;
+        case FORMAT_RGB:
+            return 1;
+        case FORMAT_GRAY:
+            return 2;
+        case FORMAT_YUYV_422:
+            return 3;
+        case FORMAT_YVYU_422:
+            return 4;
+        case FORMAT_UYUV_422:
+            return 5;
+        case FORMAT_NV12_420:
+            return 6;
+        case FORMAT_NV21_420:
+            return 7;
+        default:
+            return -1;
+        }
+    }
+
+    template <OutputType Out, int W, int H>
+    std::array<Kernel, patch_sampler::PatchPipeline::FORMAT_SLOTS> kernelTable()
+    {
+        // Same order as formatSlot
+        return {{&colorKernel<true, Out, W, H>,
+                 &colorKernel<false, Out, W, H>,
+                 &gatherKernel<GraySource, Out, W, H>,
+                 &gatherKernel<PackedYuvSource<0, 1, 3>, Out, W, H>,
+                 &gatherKernel<PackedYuvSource<0, 3, 1>, Out, W, H>,
+                 &gatherKernel<PackedYuvSource<1, 0, 2>, Out, W, H>,
+                 &gatherKernel<SemiPlanarYuvSource<0, 1>, Out, W, H>,
+                 &gatherKernel<SemiPlanarYuvSource<1, 0>, Out, W, H>}};
+    }
+
+    template <OutputType Out>
+    std::array<Kernel, patch_sampler::PatchPipeline::FORMAT_SLOTS> kernelTable(cv::Size size, bool &specialized_size)
+    {
+        specialized_size = size == cv::Size(MODEL_SIDE, MODEL_SIDE);
+        return specialized_size ? kernelTable<Out, MODEL_SIDE, MODEL_SIDE>() : kernelTable<Out, 0, 0>();
+    }
+}
+
+namespace patch_sampler
+{
+    const char *to_string(OutputType type)
+    {
+        switch (type)
+        {
+        case OutputType::Float32:
+            return "fp32";
+        case OutputType::Float16:
+            return "fp16";
+        case OutputType::Uint8:
+            return "uint8";
+        }
+        return "unknown";
+    }
+
+    size_t elementSize(OutputType type)
+    {
+        switch (type)
+        {
+        case OutputType::Float16:
+            return sizeof(uint16_t);
+        case OutputType::Uint8:
+            return sizeof(uint8_t);
+        default:
+            return sizeof(float);
+        }
+    }
+
+    PatchPipeline::PatchPipeline(const TensorSpec &spec, OutputType output) : spec(spec), output(output)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            norm.scale[c] = 1.0f / (255.0f * spec.std[c]);
+            norm.bias[c] = -spec.mean[c] / spec.std[c];
+        }
+
+        switch (output)
+        {
+        case OutputType::Float16:
+            kernels = kernelTable<OutputType::Float16>(spec.size, specialized_size);
+            break;
+        case OutputType::Uint8:
+            kernels = kernelTable<OutputType::Uint8>(spec.size, specialized_size);
+            break;
+        default:
+            kernels = kernelTable<OutputType::Float32>(spec.size, specialized_size);
+            break;
+        }
+    }
+
+    cv::Size PatchPipeline::pyramid_target() const
+    {
+        return spec.interpolation == resample::Interpolation::Area ? cv::Size(spec.size.width * 2, spec.size.height * 2) : spec.size;
+    }
+
+    bool PatchPipeline::supports(uint16_t format)
+    {
+        return formatSlot(format) >= 0;
+    }
+
+    void PatchPipeline::sample(const CapturedFrame &frame, cv::Rect roi, resample::PlanPtr &plan, void *out) const
+    {
+        sampleInto(frame, nullptr, roi, plan, out);
+    }
+
+    void PatchPipeline::sample(const CapturedFrame &frame, const ImagePyramid &pyramid, cv::Rect roi, resample::PlanPtr &plan, void *out) const
+    {
+        sampleInto(frame, &pyramid, roi, plan, out);
+    }
+
+    void PatchPipeline::sampleInto(const CapturedFrame &frame, const ImagePyramid *pyramid, cv::Rect roi, resample::PlanPtr &plan, void *out) const
+    {
+        const int slot = formatSlot(frame.format);
+        CV_Assert(slot >= 0);
+
+        roi &= cv::Rect(cv::Point(0, 0), frame.size());
+        const int level = (pyramid == nullptr || roi.empty()) ? 0 : std::min(pyramid->levels(), pyramid->level_for(roi.size(), pyramid_target()));
+        const cv::Rect level_roi = level > 0 ? pyramid->to_level(roi, level) : cv::Rect();
+        if (roi.empty())
+        {
+            fillBlack(output, norm, spec.size.area(), out);
+        }
+        else if (!level_roi.empty())
+        {
+            // The level is within 2x of the patch, so this costs about the same for any ROI size
+            thread_local cv::Mat level_patch;
+            const resample::Plan &level_plan = resample::cachedPlan(plan, level_roi, pyramid->window(roi, level), spec.size, spec.interpolation);
+            downscale::resize(pyramid->view(level_roi, level), level_patch, level_plan);
+            storeLevelPatch(output, pyramid->color(), level_patch, norm, out);
+        }
+        else
+        {
+            kernels[slot](frame, resample::cachedPlan(plan, roi, spec.size, spec.interpolation), norm, out);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+#include "ImagePyramid.h"
+#include "PatchSampler.h"
+#include "ResamplePlan.h"
+
+namespace patch_sampler
+{
+    /// @brief Element type of the model's input tensor
+    enum class OutputType
+    {
+        Float32,
+        Float16, // IEEE half, as uint16_t
+        Uint8    // 0..255 RGB; mean/std are not applied
+    };
+
+    const char *to_string(OutputType type);
+    size_t elementSize(OutputType type);
+
+    /// @brief Fused crop, resize, colour conversion, HWC to CHW and normalisation of a ROI into the
+    ///        model's input tensor, compiled for each source format, output type and patch size.
+    ///
+    /// The ROI is read straight from the frame in its native layout (YUV is blended as YUV and
+    /// converted once per output pixel), without full-frame conversions or temporary images beyond
+    /// the small patch the SIMD downscale kernels produce for BGR/RGB. A PatchPipeline is built
+    /// once, when the model's input is known, and picks from a dispatch table one kernel per
+    /// source format in which the pixel layout, the output conversion and, for the model's 28x28,
+    /// the patch size are template parameters. The per-pixel loops carry no branches; what is left
+    /// per patch is one table lookup on the frame format. fp16 kernels narrow each value as they store it, so an fp16
+    /// patch is written once, at half the bytes of an fp32 one.
+    class PatchPipeline
+    {
+    public:
+        PatchPipeline(const TensorSpec &spec, OutputType output);
+
+        /// @brief True if frames of this FORMAT_* have a kernel: BGR, RGB, GRAY, YUYV, YVYU, UYVY, NV12 and NV21
+        static bool supports(uint16_t format);
+
+        /// @brief Writes the patch of roi, clipped to the frame, as output_type() elements to out; an
+        ///        empty ROI yields the normalised value of black. plan caches the taps of the clipped
+        ///        ROI and is only rebuilt when that changes, so a caller that keeps one per ROI pays
+        ///        for the tap computation once
+        void sample(const CapturedFrame &frame, cv::Rect roi, resample::PlanPtr &plan, void *out) const;
+        /// @brief As above, but a ROI at least twice pyramid_target() is read from the level of
+        ///        pyramid, built from frame for this ROI, closest to the patch's scale. plan then
+        ///        caches the taps within that level
+        void sample(const CapturedFrame &frame, const ImagePyramid &pyramid, cv::Rect roi, resample::PlanPtr &plan, void *out) const;
+
+        const TensorSpec &tensor_spec() const { return spec; }
+        OutputType output_type() const { return output; }
+        size_t patch_bytes() const { return 3 * static_cast<size_t>(spec.size.area()) * elementSize(output); }
+        /// @brief Smallest ROI, at its pyramid level, the pipeline samples from: the patch size for
+        ///        bilinear and nearest, which alias beyond 2x, and twice it for area, whose taps
+        ///        blur less than a coarser level would. See ImagePyramid::level_for
+        cv::Size pyramid_target() const;
+        /// @brief True if the patch size is compiled into the kernels rather than read from the plan
+        bool size_specialized() const { return specialized_size; }
+
+        /// @brief Per-channel out = rgb * scale + bias, folded from TensorSpec::mean and std
+        struct Normalization
+        {
+            float scale[3];
+            float bias[3];
+        };
+        using Kernel = void (*)(const CapturedFrame &frame, const resample::Plan &plan, const Normalization &norm, void *out);
+
+        // One kernel per supported format, in the order of the FORMAT_* list above
+        static const int FORMAT_SLOTS = 8;
+
+    private:
+        void sampleInto(const CapturedFrame &frame, const ImagePyramid *pyramid, cv::Rect roi, resample::PlanPtr &plan, void *out) const;
+
+        TensorSpec spec;
+        OutputType output;
+        Normalization norm;
+        bool specialized_size;
+        std::array<Kernel, FORMAT_SLOTS> kernels;
+    };
+}
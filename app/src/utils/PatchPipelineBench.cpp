@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "BenchUtils.h"
+#include "FrameSource.h"
+#include "HalfFloat.h"
+#include "PatchPipeline.h"
+#include "PatchPipelineBench.h"
+#include "ResamplePlan.h"
+
+namespace
+{
+    using patch_sampler::OutputType;
+
+    const cv::Size FRAME_SIZE(640, 480);
+    // A lot's worth of spots, from far away to close up
+    const cv::Rect ROIS[] = {{12, 20, 40, 30}, {70, 24, 44, 34}, {130, 30, 52, 38}, {200, 36, 60, 44}, {280, 40, 66, 50}, {370, 44, 74, 54}, {470, 50, 84, 60}, {20, 120, 96, 70}, {140, 130, 104, 78}, {270, 140, 114, 84}, {410, 150, 124, 92}, {10, 260, 140, 104}, {170, 270, 156, 116}, {350, 280, 172, 128}, {20, 380, 190, 96}, {240, 372, 200, 104}};
+    const int ITERATIONS = 200;
+    // Mean absolute difference to the OpenCV chain, in 0..255. It rounds to 8 bits after the
+    // resize and converts YUV before blending rather than after
+    const double OPENCV_TOLERANCE = 0.5;
+    // Byte values of the synthetic frames. Full-range YUV noise mostly converts to colours outside
+    // RGB, where clipping before or after blending differs by far more than any kernel error
+    const int VALUE_LOW = 64;
+    const int VALUE_HIGH = 192;
+    // Half has 11 significant bits; the tensor values are within 0..1
+    const float FP16_TOLERANCE = 1e-3f;
+
+    /// @brief Median microseconds per patch, each call sampling every ROI once
+    double timePerPatch(const std::function<void()> &call)
+    {
+        return bench::medianTime(call, ITERATIONS) / (sizeof(ROIS) / sizeof(ROIS[0]));
+    }
+
+    /// @brief The worker's original preprocessing of a BGR frame: crop, cv::resize, BGR to RGB,
+    ///        scale to 0..1 and HWC to CHW
+    void openCvPatch(const cv::Mat &bgr, const cv::Rect &roi, const patch_sampler::TensorSpec &spec, float *chw)
+    {
+        cv::Mat patch, rgb;
+        cv::resize(bgr(roi), patch, spec.size, 0, 0, spec.interpolation == resample::Interpolation::Area ? cv::INTER_AREA : cv::INTER_LINEAR);
+        cv::cvtColor(patch, rgb, cv::COLOR_BGR2RGB);
+        const int plane = spec.size.area();
+        for (int y = 0; y < rgb.rows; y++)
+        {
+            const uchar *row = rgb.ptr<uchar>(y);
+            for (int x = 0; x < rgb.cols; x++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    chw[c * plane + y * rgb.cols + x] = (row[3 * x + c] / 255.0f - spec.mean[c]) / spec.std[c];
+                }
+            }
+        }
+    }
+}
+
+int runPipelineBench(std::ostream &os)
+{
+    const size_t roi_count = sizeof(ROIS) / sizeof(ROIS[0]);
+    cv::RNG rng(2024);
+    bool passed = true;
+
+    os << "patch pipelines: " << roi_count << " ROIs of a " << FRAME_SIZE.width << "x" << FRAME_SIZE.height << " frame, us per patch,"
+       << " opencv is the original cv::resize/cvtColor chain on a frame already converted to BGR" << std::endl;
+    os << std::left << std::setw(8) << "format" << std::setw(10) << "mode"
+       << std::setw(11) << "opencv_us" << std::setw(10) << "fp32_us" << std::setw(10) << "fp16_us" << std::setw(10) << "uint8_us" << std::setw(10) << "speedup"
+       << std::setw(16) << "mean_diff_cv" << std::setw(14) << "max_diff_fp16" << "max_diff_uint8" << std::endl;
+
+    for (const auto &frame_format : bench::FRAME_FORMATS)
+    {
+        // Camera-like detail: blending YUV before or after conversion only agrees on smooth images
+        const CapturedFrame frame = bench::syntheticFrame(frame_format, FRAME_SIZE, rng, 4, VALUE_LOW, VALUE_HIGH);
+        cv::Mat bgr;
+        convertToBgr(frame, bgr);
+
+        for (auto interpolation : {resample::Interpolation::Bilinear, resample::Interpolation::Area})
+        {
+            patch_sampler::TensorSpec spec;
+            spec.interpolation = interpolation;
+            const patch_sampler::PatchPipeline fp32(spec, OutputType::Float32);
+            const patch_sampler::PatchPipeline fp16(spec, OutputType::Float16);
+            const patch_sampler::PatchPipeline uint8(spec, OutputType::Uint8);
+            const size_t elements = 3 * static_cast<size_t>(spec.size.area());
+
+            // Warm plan caches, as a running lot has them
+            std::vector<resample::PlanPtr> plans(roi_count);
+            std::vector<float> opencv_out(roi_count * elements), fp32_out(roi_count * elements), widened(roi_count * elements);
+            std::vector<uint16_t> fp16_out(roi_count * elements);
+            std::vector<uint8_t> uint8_out(roi_count * elements);
+
+            auto run_opencv = [&]
+            {
+                for (size_t i = 0; i < roi_count; i++)
+                    openCvPatch(bgr, ROIS[i], spec, opencv_out.data() + i * elements);
+            };
+            auto run = [&](const patch_sampler::PatchPipeline &pipeline, void *out)
+            {
+                const size_t bytes = pipeline.patch_bytes();
+                for (size_t i = 0; i < roi_count; i++)
+                    pipeline.sample(frame, ROIS[i], plans[i], static_cast<uint8_t *>(out) + i * bytes);
+            };
+            run_opencv();
+            run(fp32, fp32_out.data());
+            run(fp16, fp16_out.data());
+            run(uint8, uint8_out.data());
+            half_float::toFloat(fp16_out.data(), widened.data(), widened.size());
+
+            double diff_cv = 0.0;
+            float diff_fp16 = 0.0f;
+            int diff_uint8 = 0;
+            for (size_t i = 0; i < fp32_out.size(); i++)
+            {
+                diff_cv += std::abs(fp32_out[i] - opencv_out[i]);
+                diff_fp16 = std::max(diff_fp16, std::abs(widened[i] - fp32_out[i]));
+                // The default spec is a plain ToTensor(), so the uint8 patch is the fp32 one times 255
+                diff_uint8 = std::max(diff_uint8, std::abs(uint8_out[i] - static_cast<int>(std::lround(fp32_out[i] * 255.0f))));
+            }
+            diff_cv = 255.0 * diff_cv / fp32_out.size();
+            const bool ok = diff_cv <= OPENCV_TOLERANCE && diff_fp16 <= FP16_TOLERANCE && diff_uint8 <= 1;
+            passed = passed && ok;
+
+            const double opencv_us = timePerPatch(run_opencv);
+            const double fp32_us = timePerPatch([&]
+                                                { run(fp32, fp32_out.data()); });
+            const double fp16_us = timePerPatch([&]
+                                                { run(fp16, fp16_out.data()); });
+            const double uint8_us = timePerPatch([&]
+                                                 { run(uint8, uint8_out.data()); });
+
+            os << std::left << std::setw(8) << frame_format.name << std::setw(10) << resample::to_string(interpolation)
+               << std::setw(11) << opencv_us << std::setw(10) << fp32_us << std::setw(10) << fp16_us << std::setw(10) << uint8_us
+               << std::setw(10) << (fp32_us > 0 ? opencv_us / fp32_us : 0.0)
+               << std::setw(16) << diff_cv << std::setw(14) << diff_fp16 << diff_uint8 << (ok ? "" : "  FAIL") << std::endl;
+        }
+    }
+
+    os << (passed ? "all pipelines match the OpenCV chain" : "pipelines DISAGREE with the OpenCV chain") << std::endl;
+    return passed ? 0 : 1;
+}
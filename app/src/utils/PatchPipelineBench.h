@@ -0,0 +1,9 @@
+#pragma once
+
+#include <iostream>
+
+/// @brief `spark --bench-pipelines`: checks the PatchPipeline kernels against the worker's original
+///        cv::resize/cvtColor chain and the fp16 and uint8 outputs against fp32, and times them
+///        per source format and output type.
+/// @return process exit code, non-zero if any kernel disagrees beyond its tolerance
+int runPipelineBench(std::ostream &os);
@@ -0,0 +1,57 @@
+#include "PatchSampler.h"
+
+namespace
+{
+    /// @brief Where the Y of pixel (x, y) lives, for the packed 4:2:2 and semi-planar 4:2:0 layouts
+    struct YuvLayout
+    {
+        bool semi_planar;
+        // packed 4:2:2: byte offset of the even pixel's Y inside a 4-byte macropixel
+        int y_offset;
+    };
+
+    bool layoutFor(uint16_t format, YuvLayout &layout)
+    {
+        switch (format)
+        {
+        case FORMAT_YUYV_422:
+        case FORMAT_YVYU_422:
+            layout = {false, 0};
+            return true;
+        case FORMAT_UYUV_422:
+            layout = {false, 1};
+            return true;
+        case FORMAT_NV12_420:
+        case FORMAT_NV21_420:
+            layout = {true, 0};
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+namespace patch_sampler
+{
+    uint8_t lumaAt(const CapturedFrame &frame, int x, int y)
+    {
+        YuvLayout layout;
+        if (layoutFor(frame.format, layout))
+        {
+            if (layout.semi_planar)
+            {
+                return frame.image.ptr<uchar>(y)[x];
+            }
+            return frame.image.ptr<uchar>(y)[(x & ~1) * 2 + layout.y_offset + (x & 1) * 2];
+        }
+        if (frame.format == FORMAT_GRAY)
+        {
+            return frame.image.ptr<uchar>(y)[x];
+        }
+
+        const uchar *pixel = frame.image.ptr<uchar>(y) + 3 * x;
+        const int b = frame.format == FORMAT_RGB ? pixel[2] : pixel[0];
+        const int r = frame.format == FORMAT_RGB ? pixel[0] : pixel[2];
+        return static_cast<uint8_t>((29 * b + 150 * pixel[1] + 77 * r) >> 8);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <opencv2/core.hpp>
+
+#include "CapturedFrame.h"
+#include "ResamplePlan.h"
+
+namespace patch_sampler
+{
+    using resample::Interpolation;
+    using resample::to_string;
+
+    /// @brief The model input patches are sampled to (see PatchPipeline): planar RGB, out = (rgb / 255 - mean) / std
+    struct TensorSpec
+    {
+        cv::Size size{28, 28};
+        Interpolation interpolation = Interpolation::Bilinear;
+        // Per RGB channel, on the 0..1 scale like torchvision's Normalize. The defaults are a plain ToTensor()
+        std::array<float, 3> mean{0.0f, 0.0f, 0.0f};
+        std::array<float, 3> std{1.0f, 1.0f, 1.0f};
+    };
+
+    /// @brief Luma of pixel (x, y) in any supported format; BT.601 weights for BGR/RGB frames
+    uint8_t lumaAt(const CapturedFrame &frame, int x, int y);
+}
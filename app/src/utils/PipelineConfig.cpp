@@ -0,0 +1,282 @@
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include "PipelineConfig.h"
+
+namespace
+{
+    const char *getEnv(const char *name)
+    {
+        const char *value = std::getenv(name);
+        return (value != nullptr && *value != '\0') ? value : nullptr;
+    }
+
+    // Upper bound for any count, byte size or duration read from the environment
+    const size_t MAX_SIZE_VALUE = UINT32_MAX;
+    // More queued frames than this is a typo, not a deeper buffer
+    const size_t MAX_FRAME_RING_CAPACITY = 1024;
+
+    void readSize(const char *name, size_t &out, size_t min_value, size_t max_value = MAX_SIZE_VALUE)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        try
+        {
+            // std::stoul would take "-1" as SIZE_MAX, and stops quietly at trailing junk
+            const std::string text(value);
+            size_t pos = 0;
+            const auto parsed = text.find('-') == std::string::npos ? std::stoul(text, &pos) : 0;
+            if (pos == text.size() && parsed >= min_value && parsed <= max_value)
+            {
+                out = parsed;
+                return;
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+    }
+
+    void readFlag(const char *name, bool &out)
+    {
+        const char *value = getEnv(name);
+        if (value != nullptr)
+        {
+            out = std::string(value) != "0";
+        }
+    }
+
+    void readMilliseconds(const char *name, std::chrono::milliseconds &out)
+    {
+        size_t value = out.count();
+        readSize(name, value, 0);
+        out = std::chrono::milliseconds(value);
+    }
+
+    void readIngestMode(const char *name, IngestMode &out)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        if (std::string(value) == "fifo")
+        {
+            out = IngestMode::Fifo;
+        }
+        else if (std::string(value) == "latest")
+        {
+            out = IngestMode::LatestWins;
+        }
+        else
+        {
+            std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+        }
+    }
+
+    void readCaptureBackend(const char *name, CaptureBackend &out)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        if (std::string(value) == "opencv")
+        {
+            out = CaptureBackend::OpenCv;
+        }
+        else if (std::string(value) == "v4l2")
+        {
+            out = CaptureBackend::V4l2;
+        }
+        else
+        {
+            std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+        }
+    }
+
+    void readCaptureFormat(const char *name, uint16_t &out)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        if (std::string(value) == "yuyv")
+        {
+            out = FORMAT_YUYV_422;
+        }
+        else if (std::string(value) == "nv12")
+        {
+            out = FORMAT_NV12_420;
+        }
+        else
+        {
+            std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+        }
+    }
+
+    void readDouble(const char *name, double &out)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        try
+        {
+            const double parsed = std::stod(value);
+            if (parsed >= 0)
+            {
+                out = parsed;
+                return;
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+    }
+
+    void readInterpolation(const char *name, patch_sampler::Interpolation &out)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        for (auto interpolation : {patch_sampler::Interpolation::Nearest, patch_sampler::Interpolation::Bilinear, patch_sampler::Interpolation::Area})
+        {
+            if (std::string(value) == patch_sampler::to_string(interpolation))
+            {
+                out = interpolation;
+                return;
+            }
+        }
+        std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+    }
+
+    /// @brief Reads "a,b,c"; every value must be positive if positive is set
+    void readTriple(const char *name, std::array<float, 3> &out, bool positive)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        std::array<float, 3> parsed;
+        std::istringstream stream(value);
+        bool valid = true;
+        for (size_t i = 0; i < parsed.size() && valid; i++)
+        {
+            char separator = ',';
+            valid = static_cast<bool>(stream >> parsed[i]) && (!positive || parsed[i] > 0) && (i + 1 == parsed.size() || (stream >> separator && separator == ','));
+        }
+        if (valid && stream.eof())
+        {
+            out = parsed;
+            return;
+        }
+        std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+    }
+
+    void readOverflowPolicy(const char *name, OverflowPolicy &out)
+    {
+        const char *value = getEnv(name);
+        if (value == nullptr)
+        {
+            return;
+        }
+        for (auto policy : {OverflowPolicy::Block, OverflowPolicy::DropOldest, OverflowPolicy::DropNewest})
+        {
+            if (std::string(value) == to_string(policy))
+            {
+                out = policy;
+                return;
+            }
+        }
+        std::cerr << "Ignoring invalid " << name << "=" << value << std::endl;
+    }
+}
+
+PipelineConfig PipelineConfig::fromEnvironment()
+{
+    PipelineConfig config;
+    readSize("SPARK_FRAME_RING_CAPACITY", config.frame_ring_capacity, 1, MAX_FRAME_RING_CAPACITY);
+    readOverflowPolicy("SPARK_OVERFLOW_POLICY", config.overflow_policy);
+    readIngestMode("SPARK_INGEST_MODE", config.ingest_mode);
+    readMilliseconds("SPARK_MAX_FRAME_AGE_MS", config.max_frame_age);
+    readFlag("SPARK_MEASURE_WAKEUPS", config.measure_wakeups);
+    readDouble("SPARK_INFERENCE_HZ", config.inference_hz);
+    readSize("SPARK_INFERENCE_EVERY_N", config.inference_every_n, 1);
+    readDouble("SPARK_CHANGE_THRESHOLD", config.change_threshold);
+    size_t force_refresh = config.force_refresh.count();
+    readSize("SPARK_FORCE_REFRESH_S", force_refresh, 0);
+    config.force_refresh = std::chrono::seconds(force_refresh);
+    readSize("SPARK_PIPELINE_DEPTH", config.pipeline_depth, 1);
+    readSize("SPARK_PIPELINE_CHUNK", config.pipeline_chunk, 1);
+    readSize("SPARK_INFERENCE_QUEUE", config.inference_queue, 1);
+    readSize("SPARK_PROFILE_EVERY_N", config.profile_every_n, 0);
+    readSize("SPARK_MODEL_DRPAI_BYTES", config.model_drpai_bytes, 0);
+    readCaptureBackend("SPARK_CAPTURE_BACKEND", config.capture_backend);
+    size_t width = config.capture_size.width;
+    size_t height = config.capture_size.height;
+    readSize("SPARK_CAPTURE_WIDTH", width, 2);
+    readSize("SPARK_CAPTURE_HEIGHT", height, 2);
+    config.capture_size = cv::Size(static_cast<int>(width), static_cast<int>(height));
+    readCaptureFormat("SPARK_CAPTURE_FORMAT", config.capture_format);
+    readDouble("SPARK_RAW_FPS", config.raw_fps);
+    readInterpolation("SPARK_INTERPOLATION", config.tensor_spec.interpolation);
+    readTriple("SPARK_INPUT_MEAN", config.tensor_spec.mean, false);
+    readTriple("SPARK_INPUT_STD", config.tensor_spec.std, true);
+    readSize("SPARK_PYRAMID_LEVELS", config.pyramid_levels, 0);
+    readFlag("SPARK_ROI_CROP", config.roi_crop);
+    readFlag("SPARK_ADAPTIVE_CAPTURE", config.adaptive_capture);
+    readSize("SPARK_MIN_ROI_PIXELS", config.min_roi_pixels, 1);
+
+    if (config.ingest_mode == IngestMode::LatestWins)
+    {
+        // A single slot that the reader keeps overwriting is what "latest wins" means
+        config.frame_ring_capacity = 1;
+        config.overflow_policy = OverflowPolicy::DropOldest;
+    }
+    return config;
+}
+
+std::ostream &operator<<(std::ostream &os, const PipelineConfig &config)
+{
+    os << "{"
+       << "frame_ring_capacity: " << config.frame_ring_capacity << ", "
+       << "overflow_policy: " << to_string(config.overflow_policy) << ", "
+       << "ingest_mode: " << (config.ingest_mode == IngestMode::LatestWins ? "latest" : "fifo") << ", "
+       << "max_frame_age_ms: " << config.max_frame_age.count() << ", "
+       << "measure_wakeups: " << config.measure_wakeups << ", "
+       << "inference_hz: " << config.inference_hz << ", "
+       << "inference_every_n: " << config.inference_every_n << ", "
+       << "change_threshold: " << config.change_threshold << ", "
+       << "force_refresh_s: " << config.force_refresh.count() << ", "
+       << "pipeline_depth: " << config.pipeline_depth << ", "
+       << "pipeline_chunk: " << config.pipeline_chunk << ", "
+       << "inference_queue: " << config.inference_queue << ", "
+       << "profile_every_n: " << config.profile_every_n << ", "
+       << "model_drpai_bytes: " << config.model_drpai_bytes << ", "
+       << "capture_backend: " << (config.capture_backend == CaptureBackend::V4l2 ? "v4l2" : "opencv") << ", "
+       << "capture_size: " << config.capture_size.width << "x" << config.capture_size.height << ", "
+       << "capture_format: " << format_string_table.at(config.capture_format) << ", "
+       << "raw_fps: " << config.raw_fps << ", "
+       << "interpolation: " << patch_sampler::to_string(config.tensor_spec.interpolation) << ", "
+       << "input_mean: " << config.tensor_spec.mean[0] << "," << config.tensor_spec.mean[1] << "," << config.tensor_spec.mean[2] << ", "
+       << "input_std: " << config.tensor_spec.std[0] << "," << config.tensor_spec.std[1] << "," << config.tensor_spec.std[2] << ", "
+       << "pyramid_levels: " << config.pyramid_levels << ", "
+       << "roi_crop: " << config.roi_crop << ", "
+       << "adaptive_capture: " << config.adaptive_capture << ", "
+       << "min_roi_pixels: " << config.min_roi_pixels
+       << "}";
+    return os;
+}
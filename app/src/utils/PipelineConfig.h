@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <opencv2/core.hpp>
+
+#include "FrameRing.h"
+#include "PatchSampler.h"
+#include "PreRuntime.h"
+
+enum class IngestMode
+{
+    Fifo,       // process every frame the ring hands us, oldest first
+    LatestWins  // reader keeps only the freshest capture, processor always takes the newest
+};
+
+enum class CaptureBackend
+{
+    OpenCv, // cv::VideoCapture, decoded to BGR
+    V4l2    // VIDIOC_REQBUFS mmap streaming, native YUV
+};
+
+/// @brief Tunables for the capture -> inference pipeline.
+/// Each field can be overridden with a SPARK_* environment variable. Defaults keep the app's original
+/// behaviour: every frame is classified, every spot each time; the optimisations are opt-in.
+struct PipelineConfig
+{
+    // SPARK_FRAME_RING_CAPACITY
+    size_t frame_ring_capacity = 4;
+    // SPARK_OVERFLOW_POLICY = block | drop-oldest | drop-newest. Blocking loses no frame, like the
+    // unbounded queue it replaced; dropping keeps latency down when inference can't keep up
+    OverflowPolicy overflow_policy = OverflowPolicy::Block;
+    // SPARK_INGEST_MODE = fifo | latest
+    IngestMode ingest_mode = IngestMode::Fifo;
+    // SPARK_MAX_FRAME_AGE_MS, frames older than this are dropped unprocessed. 0 disables the check
+    std::chrono::milliseconds max_frame_age{0};
+    // SPARK_MEASURE_WAKEUPS = 1, report consumer idle percentage and wakeup latency
+    bool measure_wakeups = false;
+
+    // SPARK_INFERENCE_HZ, run occupancy inference at most this often. 0 falls back to inference_every_n
+    double inference_hz = 0;
+    // SPARK_INFERENCE_EVERY_N, classify every Nth displayed frame
+    size_t inference_every_n = 1;
+    // SPARK_CHANGE_THRESHOLD, mean luma difference below which a spot keeps its last decision, e.g. 4.
+    // 0 disables change detection, so every spot is classified every time
+    double change_threshold = 0;
+    // SPARK_FORCE_REFRESH_S, a spot is reclassified at least this often regardless of change detection
+    std::chrono::seconds force_refresh{30};
+    // SPARK_PIPELINE_DEPTH, chunks of patches preprocessed ahead of the one the DRP-AI is running.
+    // 2 double buffers, 3 triple buffers, 1 alternates preprocessing and inference
+    size_t pipeline_depth = 2;
+    // SPARK_PIPELINE_CHUNK, patches handed from preprocessing to inference at a time; rounded up
+    // to a multiple of the model's compiled batch size
+    size_t pipeline_chunk = 4;
+    // SPARK_INFERENCE_QUEUE, chunks queued or running on the inference thread before submitting
+    // blocks. 2 preprocesses one while the DRP-AI runs the other
+    size_t inference_queue = 2;
+    // SPARK_PROFILE_EVERY_N, profiles every Nth model run per op on the debug graph executor.
+    // 0 runs the plain graph executor and profiles nothing
+    size_t profile_every_n = 0;
+    // SPARK_MODEL_DRPAI_BYTES, DRP-AI memory the model is given. 0 takes it from the address maps
+    // of the model's DRP-AI subgraphs
+    size_t model_drpai_bytes = 0;
+
+    // SPARK_CAPTURE_BACKEND = opencv | v4l2, only applies to camera input
+    CaptureBackend capture_backend = CaptureBackend::OpenCv;
+    // SPARK_CAPTURE_WIDTH / SPARK_CAPTURE_HEIGHT, requested from the camera; also the geometry of raw dumps
+    cv::Size capture_size{1920, 1080};
+    // SPARK_CAPTURE_FORMAT = yuyv | nv12, requested from a V4L2 camera
+    uint16_t capture_format = FORMAT_YUYV_422;
+    // SPARK_RAW_FPS, replay rate of raw dumps. 0 replays as fast as the pipeline consumes
+    double raw_fps = 0;
+    // SPARK_INTERPOLATION = nearest | bilinear | area, SPARK_INPUT_MEAN / SPARK_INPUT_STD = "r,g,b".
+    // Model input preprocessing; must match what the model was trained with
+    patch_sampler::TensorSpec tensor_spec;
+    // SPARK_PYRAMID_LEVELS, deepest ImagePyramid level large ROIs are sampled from, e.g. 4.
+    // 0 samples every ROI from the frame itself
+    size_t pyramid_levels = 0;
+
+    // SPARK_ROI_CROP = 1 queues only the bounding union of the ROIs instead of whole frames
+    bool roi_crop = false;
+    // SPARK_ADAPTIVE_CAPTURE = 1 lets a cropped camera capture at the lowest mode its ROIs allow
+    // instead of capture_size. Only applies with SPARK_ROI_CROP = 1
+    bool adaptive_capture = false;
+    // SPARK_MIN_ROI_PIXELS, smallest ROI side, in captured pixels, adaptive capture may go down to
+    size_t min_roi_pixels = 28;
+
+    /// @brief Buffers a FrameSource needs: every ring slot plus the ones being filled, processed and evicted
+    size_t capture_buffer_count() const { return frame_ring_capacity + 3; }
+
+    static PipelineConfig fromEnvironment();
+};
+
+std::ostream &operator<<(std::ostream &os, const PipelineConfig &config);
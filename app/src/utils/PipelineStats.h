@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+/// @brief Running min/mean/max of a latency, in milliseconds
+class LatencyStats
+{
+public:
+    void record(std::chrono::steady_clock::duration latency)
+    {
+        const double ms = std::chrono::duration<double, std::milli>(latency).count();
+        min_ms = count == 0 ? ms : std::min(min_ms, ms);
+        max_ms = std::max(max_ms, ms);
+        total_ms += ms;
+        count++;
+    }
+
+    void reset() { *this = LatencyStats(); }
+
+    uint64_t samples() const { return count; }
+    double mean() const { return count == 0 ? 0.0 : total_ms / count; }
+    double min() const { return min_ms; }
+    double max() const { return max_ms; }
+
+private:
+    uint64_t count = 0;
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const LatencyStats &stats)
+{
+    os << "{"
+       << "samples: " << stats.samples() << ", "
+       << "min_ms: " << stats.min() << ", "
+       << "mean_ms: " << stats.mean() << ", "
+       << "max_ms: " << stats.max()
+       << "}";
+    return os;
+}
+
+/// @brief How the processing thread spends its time waiting for frames
+class WakeupStats
+{
+public:
+    void record_idle(std::chrono::steady_clock::duration waited) { idle += waited; }
+    // time from the producer publishing a frame to the consumer returning from its wait
+    void record_wakeup(std::chrono::steady_clock::duration latency) { wakeup_latency.record(latency); }
+
+    void reset() { *this = WakeupStats(); }
+
+    double idle_percent(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const
+    {
+        const auto elapsed = now - since;
+        return elapsed.count() <= 0 ? 0.0 : 100.0 * idle.count() / elapsed.count();
+    }
+    const LatencyStats &wakeups() const { return wakeup_latency; }
+
+private:
+    std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration idle{0};
+    LatencyStats wakeup_latency;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const WakeupStats &stats)
+{
+    os << "{"
+       << "idle_percent: " << stats.idle_percent() << ", "
+       << "wakeup_latency: " << stats.wakeups()
+       << "}";
+    return os;
+}
+
+/// @brief Stages of the processing thread, for duty-cycle accounting
+enum class Stage
+{
+    Wait,       // blocked on the frame ring
+    Preprocess, // patch sampling and tensor layout
+    Inference,  // submitting to and waiting on the inference thread
+    Render,     // overlays, imshow and the UI event pump
+    Count
+};
+
+inline const char *to_string(Stage stage)
+{
+    switch (stage)
+    {
+    case Stage::Wait:
+        return "wait";
+    case Stage::Preprocess:
+        return "preprocess";
+    case Stage::Inference:
+        return "inference";
+    case Stage::Render:
+        return "render";
+    default:
+        return "unknown";
+    }
+}
+
+/// @brief Share of wall time the processing thread spends in each Stage
+class DutyCycleStats
+{
+public:
+    void add(Stage stage, std::chrono::steady_clock::duration busy)
+    {
+        auto &entry = stages[static_cast<size_t>(stage)];
+        entry.busy += busy;
+        entry.calls++;
+    }
+
+    void reset() { *this = DutyCycleStats(); }
+
+    double percent(Stage stage, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const
+    {
+        const auto elapsed = now - since;
+        const auto &entry = stages[static_cast<size_t>(stage)];
+        return elapsed.count() <= 0 ? 0.0 : 100.0 * entry.busy.count() / elapsed.count();
+    }
+
+    double mean_ms(Stage stage) const
+    {
+        const auto &entry = stages[static_cast<size_t>(stage)];
+        return entry.calls == 0 ? 0.0 : std::chrono::duration<double, std::milli>(entry.busy).count() / entry.calls;
+    }
+
+private:
+    struct Entry
+    {
+        std::chrono::steady_clock::duration busy{0};
+        uint64_t calls = 0;
+    };
+
+    std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+    std::array<Entry, static_cast<size_t>(Stage::Count)> stages{};
+};
+
+inline std::ostream &operator<<(std::ostream &os, const DutyCycleStats &stats)
+{
+    const auto now = std::chrono::steady_clock::now();
+    os << "{";
+    for (size_t i = 0; i < static_cast<size_t>(Stage::Count); i++)
+    {
+        const auto stage = static_cast<Stage>(i);
+        os << (i == 0 ? "" : ", ") << to_string(stage) << ": " << stats.percent(stage, now) << "% (" << stats.mean_ms(stage) << " ms)";
+    }
+    os << "}";
+    return os;
+}
+
+/// @brief Adds the lifetime of the scope to one Stage of a DutyCycleStats
+class StageTimer
+{
+public:
+    StageTimer(DutyCycleStats &stats, Stage stage) : stats(stats), stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~StageTimer() { stats.add(stage, std::chrono::steady_clock::now() - start); }
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+    DutyCycleStats &stats;
+    const Stage stage;
+    const std::chrono::steady_clock::time_point start;
+};
+
+/// @brief What happened to the frames the processing thread dequeued
+struct IngestStats
+{
+    uint64_t processed = 0;
+    // superseded by a newer frame before we got to them (latest-frame-wins mode)
+    uint64_t skipped = 0;
+    // older than PipelineConfig::max_frame_age
+    uint64_t stale = 0;
+    // capture -> occupancy decision
+    LatencyStats latency;
+    // only filled in when PipelineConfig::measure_wakeups is set
+    WakeupStats wakeups;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const IngestStats &stats)
+{
+    os << "{"
+       << "processed: " << stats.processed << ", "
+       << "skipped: " << stats.skipped << ", "
+       << "stale: " << stats.stale << ", "
+       << "capture_to_decision: " << stats.latency;
+    if (stats.wakeups.wakeups().samples() > 0)
+    {
+        os << ", consumer: " << stats.wakeups;
+    }
+    os << "}";
+    return os;
+}
@@ -0,0 +1,185 @@
+#include "PipelinedExecutor.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double to_ms(OverlapStats::Duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+OverlapStats &OverlapStats::operator+=(const OverlapStats &other)
+{
+    runs += other.runs;
+    items += other.items;
+    wall += other.wall;
+    preprocess_busy += other.preprocess_busy;
+    inference_busy += other.inference_busy;
+    inference_starved += other.inference_starved;
+    preprocess_blocked += other.preprocess_blocked;
+    return *this;
+}
+
+std::ostream &operator<<(std::ostream &os, const OverlapStats &stats)
+{
+    os << "{"
+       << "runs: " << stats.runs << ", "
+       << "items: " << stats.items << ", "
+       << "wall_ms: " << to_ms(stats.wall) << ", "
+       << "preprocess: " << 100.0 * stats.preprocess_utilisation() << "%, "
+       << "inference: " << 100.0 * stats.inference_utilisation() << "%, "
+       << "inference_starved_ms: " << to_ms(stats.inference_starved) << ", "
+       << "preprocess_blocked_ms: " << to_ms(stats.preprocess_blocked) << ", "
+       << "overlap_ms: " << to_ms(stats.overlap()) << " (" << 100.0 * stats.overlap_ratio() << "%)"
+       << "}";
+    return os;
+}
+
+PipelinedExecutor::PipelinedExecutor(size_t depth) : slots(std::max<size_t>(depth, 1))
+{
+    worker = std::thread(&PipelinedExecutor::preprocess_loop, this);
+}
+
+PipelinedExecutor::~PipelinedExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+bool PipelinedExecutor::run(size_t items, const Produce &produce_item, const Consume &consume)
+{
+    latest = OverlapStats();
+    if (items == 0)
+    {
+        return true;
+    }
+
+    const auto start = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    produce = &produce_item;
+    count = items;
+    produced = 0;
+    consumed = 0;
+    abort = false;
+    producer_done = false;
+    error = nullptr;
+    producer_side = OverlapStats();
+    generation++;
+    changed.notify_all();
+
+    bool completed = true;
+    for (size_t i = 0; i < items; i++)
+    {
+        const auto wait_start = Clock::now();
+        changed.wait(lock, [&]
+                     { return produced > i || abort; });
+        latest.inference_starved += Clock::now() - wait_start;
+        if (produced <= i)
+        {
+            // produce() threw
+            completed = false;
+            break;
+        }
+
+        lock.unlock();
+        const auto busy_start = Clock::now();
+        const bool keep_going = consume(i, i % slots);
+        latest.inference_busy += Clock::now() - busy_start;
+        lock.lock();
+
+        consumed = i + 1;
+        latest.items++;
+        if (!keep_going)
+        {
+            abort = true;
+            completed = false;
+        }
+        changed.notify_all();
+        if (!keep_going)
+        {
+            break;
+        }
+    }
+
+    // The caller's buffers must outlive every produce() of this run
+    changed.wait(lock, [&]
+                 { return producer_done; });
+    produce = nullptr;
+    latest.preprocess_busy = producer_side.preprocess_busy;
+    latest.preprocess_blocked = producer_side.preprocess_blocked;
+    const std::exception_ptr failure = error;
+    lock.unlock();
+
+    latest.runs = 1;
+    latest.wall = Clock::now() - start;
+    totals += latest;
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+    return completed;
+}
+
+void PipelinedExecutor::preprocess_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t seen = generation;
+    while (true)
+    {
+        changed.wait(lock, [&]
+                     { return quit || generation != seen; });
+        if (quit)
+        {
+            return;
+        }
+        seen = generation;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            // Slot i % depth is free once item i - depth has been consumed
+            const auto wait_start = Clock::now();
+            changed.wait(lock, [&]
+                         { return abort || i < consumed + slots; });
+            producer_side.preprocess_blocked += Clock::now() - wait_start;
+            if (abort)
+            {
+                break;
+            }
+
+            lock.unlock();
+            const auto busy_start = Clock::now();
+            std::exception_ptr failure;
+            try
+            {
+                (*produce)(i, i % slots);
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+            const auto busy = Clock::now() - busy_start;
+            lock.lock();
+
+            producer_side.preprocess_busy += busy;
+            if (failure)
+            {
+                error = failure;
+                abort = true;
+                changed.notify_all();
+                break;
+            }
+            produced = i + 1;
+            changed.notify_all();
+        }
+
+        producer_done = true;
+        changed.notify_all();
+    }
+}
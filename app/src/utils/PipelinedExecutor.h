@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+/// @brief Time each stage of a PipelinedExecutor was busy or held up, and how much of it overlapped
+struct OverlapStats
+{
+    using Duration = std::chrono::steady_clock::duration;
+
+    uint64_t runs = 0;
+    uint64_t items = 0;
+    // run() entry to exit
+    Duration wall{0};
+    Duration preprocess_busy{0};
+    Duration inference_busy{0};
+    // inference waiting for an item still being preprocessed
+    Duration inference_starved{0};
+    // preprocessing waiting for inference to free a slot
+    Duration preprocess_blocked{0};
+
+    double preprocess_utilisation() const { return ratio(preprocess_busy, wall); }
+    double inference_utilisation() const { return ratio(inference_busy, wall); }
+    /// @brief Busy time of both stages beyond the wall time, i.e. what ran concurrently
+    Duration overlap() const { return std::max(Duration(0), preprocess_busy + inference_busy - wall); }
+    /// @brief overlap() as a share of the shorter stage; 1 when that stage is hidden completely
+    double overlap_ratio() const { return ratio(overlap(), std::min(preprocess_busy, inference_busy)); }
+
+    OverlapStats &operator+=(const OverlapStats &other);
+
+private:
+    static double ratio(Duration part, Duration whole) { return whole.count() <= 0 ? 0.0 : static_cast<double>(part.count()) / whole.count(); }
+};
+
+std::ostream &operator<<(std::ostream &os, const OverlapStats &stats);
+
+/// @brief Two-stage software pipeline: a preprocessing thread prepares items while the calling
+///        thread runs inference on the ones before them.
+///
+/// run() hands items 0..count-1 to produce() on the executor's thread and to consume() on the
+/// caller's, in order. produce() may run at most depth() items ahead of the item being consumed,
+/// so depth 2 is double buffering, 3 triple buffering and 1 strictly alternating stages; the slot
+/// each call is given is item % depth() and names the buffer it owns until consume() returns.
+/// The thread lives as long as the executor, so a run costs two handoffs per item, not a thread.
+class PipelinedExecutor
+{
+public:
+    using Produce = std::function<void(size_t item, size_t slot)>;
+    /// @brief Returns false to stop the run; items not yet consumed are dropped
+    using Consume = std::function<bool(size_t item, size_t slot)>;
+
+    explicit PipelinedExecutor(size_t depth = 2);
+    ~PipelinedExecutor();
+
+    PipelinedExecutor(const PipelinedExecutor &) = delete;
+    PipelinedExecutor &operator=(const PipelinedExecutor &) = delete;
+
+    /// @brief Runs count items through both stages and returns once neither is using them.
+    ///        An exception from produce() is rethrown here
+    /// @return false if consume() stopped the run
+    bool run(size_t count, const Produce &produce, const Consume &consume);
+
+    size_t depth() const { return slots; }
+    /// @brief Totals since the last reset_stats()
+    const OverlapStats &stats() const { return totals; }
+    const OverlapStats &last_run() const { return latest; }
+    void reset_stats() { totals = OverlapStats(); }
+
+private:
+    void preprocess_loop();
+
+    const size_t slots;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread worker;
+
+    // The current run, guarded by mutex
+    uint64_t generation = 0;
+    bool quit = false;
+    const Produce *produce = nullptr;
+    size_t count = 0;
+    size_t produced = 0;
+    size_t consumed = 0;
+    bool abort = false;
+    bool producer_done = true;
+    std::exception_ptr error;
+    OverlapStats producer_side;
+
+    OverlapStats latest;
+    OverlapStats totals;
+};
@@ -33,7 +33,11 @@
 #include <dirent.h>
 #include "PreRuntime.h"
 
-PreRuntime::PreRuntime()
+PreRuntime::PreRuntime() : PreRuntime(DrpaiDriver::system())
+{
+};
+
+PreRuntime::PreRuntime(DrpaiDriver &driver) : driver(&driver)
 {
 };
 
@@ -48,7 +52,7 @@ PreRuntime::~PreRuntime()
     if (0 <= drpai_obj_info.drpai_fd )
     {
         errno = 0;
-        if (PRE_SUCCESS != close(drpai_obj_info.drpai_fd ))
+        if (PRE_SUCCESS != driver->close(drpai_obj_info.drpai_fd ))
         {
             std::cerr << "[ERROR] Failed to close DRP-AI Driver : errno=" << errno << std::endl;
         }
@@ -224,11 +228,11 @@ bool PreRuntime::StartsWith(std::string str, std::string prefix)
 uint8_t PreRuntime::LoadFileToMemDynamic(std::string data, unsigned long offset, unsigned long size, uint32_t file_type)
 {
     int8_t ret_load_data = PRE_SUCCESS;
-    uint8_t obj_fd = 0;
+    int32_t obj_fd = -1;
     uint8_t drpai_buf[BUF_SIZE];
     int8_t drpai_fd = drpai_obj_info.drpai_fd;
     drpai_data_dynamic_t drpai_data_dynamic;
-    uint8_t ret = 0;
+    int32_t ret = 0;
     int32_t i = 0;
 
     errno = 0;
@@ -244,7 +248,7 @@ uint8_t PreRuntime::LoadFileToMemDynamic(std::string data, unsigned long offset,
     drpai_data_dynamic.size = size;
     drpai_data_dynamic.file_type = file_type;
     errno = 0;
-    ret = ioctl(drpai_fd, DRPAI_ASSIGN_DYNAMIC, &drpai_data_dynamic);
+    ret = driver->ioctl(drpai_fd, DRPAI_ASSIGN_DYNAMIC, &drpai_data_dynamic);
     if ( -1 == ret )
     {
         std::cerr << "[ERROR] Failed to run DRPAI_ASSIGN_DYNAMIC : errno=" << errno << std::endl;
@@ -262,7 +266,7 @@ uint8_t PreRuntime::LoadFileToMemDynamic(std::string data, unsigned long offset,
             ret_load_data = PRE_ERROR;
             goto end;
         }
-        ret = write(drpai_fd , drpai_buf,  BUF_SIZE);
+        ret = driver->write(drpai_fd , drpai_buf,  BUF_SIZE);
         if ( -1 == ret )
         {
             std::cerr << "[ERROR] Failed to write via DRP-AI Driver : errno=" << errno << std::endl;
@@ -280,7 +284,7 @@ uint8_t PreRuntime::LoadFileToMemDynamic(std::string data, unsigned long offset,
             ret_load_data = PRE_ERROR;
             goto end;
         }
-        ret = write(drpai_fd , drpai_buf, (drpai_data_dynamic.size % BUF_SIZE));
+        ret = driver->write(drpai_fd , drpai_buf, (drpai_data_dynamic.size % BUF_SIZE));
         if ( -1 == ret )
         {
             std::cerr << "[ERROR] Failed to write via DRP-AI Driver : errno=" << errno << std::endl;
@@ -310,13 +314,13 @@ uint8_t PreRuntime::LoadDataToMem(std::vector<uint8_t> data, unsigned long from,
 {
     int8_t drpai_fd = drpai_obj_info.drpai_fd;
     drpai_data_t drpai_data;
-    uint8_t ret = 0;
+    int32_t ret = 0;
     int32_t i = 0;
 
     errno = 0;
     drpai_data.address = from;
     drpai_data.size = size;
-    ret = ioctl(drpai_fd, DRPAI_ASSIGN, &drpai_data);
+    ret = driver->ioctl(drpai_fd, DRPAI_ASSIGN, &drpai_data);
     if ( -1 == ret )
     {
         std::cerr << "[ERROR] Failed to run DRPAI_ASSIGN : errno=" << errno << std::endl;
@@ -325,7 +329,7 @@ uint8_t PreRuntime::LoadDataToMem(std::vector<uint8_t> data, unsigned long from,
     for (i = 0 ; i<(drpai_data.size/BUF_SIZE) ; i++)
     {
         errno = 0;
-        ret = write(drpai_fd, &data[BUF_SIZE*i], BUF_SIZE);
+        ret = driver->write(drpai_fd, &data[BUF_SIZE*i], BUF_SIZE);
         if ( -1 == ret )
         {
             std::cerr << "[ERROR] Failed to write via DRP-AI Driver : errno=" << errno << std::endl;
@@ -336,7 +340,7 @@ uint8_t PreRuntime::LoadDataToMem(std::vector<uint8_t> data, unsigned long from,
     if ( 0 != (drpai_data.size%BUF_SIZE))
     {
         errno = 0;
-        ret = write(drpai_fd, &data[BUF_SIZE*(int)(drpai_data.size/BUF_SIZE)], (drpai_data.size % BUF_SIZE));
+        ret = driver->write(drpai_fd, &data[BUF_SIZE*(int)(drpai_data.size/BUF_SIZE)], (drpai_data.size % BUF_SIZE));
         if ( -1 == ret )
         {
             std::cerr << "[ERROR] Failed to write via DRP-AI Driver : errno=" << errno << std::endl;
@@ -467,7 +471,7 @@ uint8_t PreRuntime::ParseParamInfo(const std::string info_file)
     drpai_param.obj.address = drpai_obj_info.drpai_address.drp_param_addr + drpai_obj_info.data_inout.start_address;
     drpai_param.obj.size = drpai_obj_info.drpai_address.drp_param_size;
     
-    if (0 != ioctl(drpai_fd, DRPAI_ASSIGN_PARAM, &drpai_param))
+    if (0 != driver->ioctl(drpai_fd, DRPAI_ASSIGN_PARAM, &drpai_param))
     {
         std::cerr << "[ERROR] Failed to run DRPAI_ASSIGN_PARAM : errno="<<errno << std::endl;
         return PRE_ERROR;
@@ -485,7 +489,7 @@ uint8_t PreRuntime::ParseParamInfo(const std::string info_file)
         /*Add newline character at the end for DRP-AI Driver write().*/
         str_return = str + "\n"; 
         /*Write to DRP-AI Driver*/
-        if ( 0 > write(drpai_fd, str_return.c_str(), str_return.size()))
+        if ( 0 > driver->write(drpai_fd, str_return.c_str(), str_return.size()))
         {
             std::cerr << "[ERROR] Failed to write to DRP-AI Driver : errno="<<errno << std::endl;
             param_file.close();
@@ -543,7 +547,8 @@ uint8_t PreRuntime::ParseParamInfo(const std::string info_file)
             clear_param(&tmp_param);
             /* Param */
             str_value = element.substr(param_head.size());
-            tmp_param.name = str_value;
+            /*Some PreRuntime Compile versions spell the input width IMG_IWIDHT*/
+            tmp_param.name = (str_value == "IMG_IWIDHT") ? std::string(P_IMG_IWIDTH) : str_value;
 
             /*Get param info*/
             while(getline(iss, element, ','))
@@ -985,7 +990,7 @@ uint32_t PreRuntime::GetStartAddress(uint32_t addr, drpai_data_t drpai_data)
 ******************************************/
 uint8_t PreRuntime::Load(const std::string pre_dir, uint32_t start_addr, uint8_t mode)
 {
-    uint8_t ret = 0;
+    int32_t ret = 0;
     struct stat statBuf;
     std::string tmp_dir = "/";
     std::string dir = pre_dir;
@@ -1033,7 +1038,7 @@ uint8_t PreRuntime::Load(const std::string pre_dir, uint32_t start_addr, uint8_t
     drpai_obj_info.data_inout.directory_name = dir;
     errno = 0;
     /*Open DRP-AI Driver*/
-    drpai_obj_info.drpai_fd = open("/dev/drpai0", O_RDWR);
+    drpai_obj_info.drpai_fd = driver->open();
     if (PRE_SUCCESS > drpai_obj_info.drpai_fd )
     {
         std::cerr << "[ERROR] Failed to open DRP-AI Driver : errno=" << errno << std::endl;
@@ -1041,7 +1046,7 @@ uint8_t PreRuntime::Load(const std::string pre_dir, uint32_t start_addr, uint8_t
     }
 
     /* Get DRP-AI Memory Area Address via DRP-AI Driver */
-    ret = ioctl(drpai_obj_info.drpai_fd , DRPAI_GET_DRPAI_AREA, &drpai_data0);
+    ret = driver->ioctl(drpai_obj_info.drpai_fd , DRPAI_GET_DRPAI_AREA, &drpai_data0);
     if (-1 == ret)
     {
         std::cerr << "[ERROR] Failed to get DRP-AI Memory Area : errno=" << errno << std::endl;
@@ -2205,7 +2210,7 @@ int8_t PreRuntime::UpdateWeightData(const s_preproc_param_t param)
 ******************************************/
 uint8_t PreRuntime::GetResult(unsigned long output_addr, unsigned long output_size)
 {
-    int8_t ret = 0;
+    int32_t ret = 0;
     drpai_data_t drpai_data;
     drpai_data.address = output_addr;
     drpai_data.size = output_size;
@@ -2247,7 +2252,7 @@ uint8_t PreRuntime::GetResult(unsigned long output_addr, unsigned long output_si
 
     errno = 0;
     /* Assign the memory address and size to be read */
-    ret = ioctl(drpai_obj_info.drpai_fd , DRPAI_ASSIGN, &drpai_data);
+    ret = driver->ioctl(drpai_obj_info.drpai_fd , DRPAI_ASSIGN, &drpai_data);
     if (-1 == ret)
     {
         std::cerr << "[ERROR] Failed to run DRPAI_ASSIGN: errno=" << errno << std::endl;
@@ -2256,7 +2261,7 @@ uint8_t PreRuntime::GetResult(unsigned long output_addr, unsigned long output_si
 
     /* Read the memory via DRP-AI Driver and store the output to buffer */
     errno = 0;
-    ret = read(drpai_obj_info.drpai_fd , internal_buffer, drpai_data.size);
+    ret = driver->read(drpai_obj_info.drpai_fd , internal_buffer, drpai_data.size);
     if ( -1 == ret )
     {
         std::cerr << "[ERROR] Failed to read via DRP-AI Driver: errno=" << errno << std::endl;
@@ -2282,7 +2287,6 @@ uint8_t PreRuntime::Pre(s_preproc_param_t* param, void** out_ptr, uint32_t* out_
     drpai_data_t proc[DRPAI_INDEX_NUM];
     struct timespec ts_start, ts_end;
     drpai_status_t drpai_status;
-    fd_set rfds;
     struct timespec tv;
     int8_t ret_drpai;
     double preproc_time = 0;
@@ -2405,18 +2409,16 @@ uint8_t PreRuntime::Pre(s_preproc_param_t* param, void** out_ptr, uint32_t* out_
     timespec_get(&ts_start, TIME_UTC);
 #endif
     errno = 0;
-    if ( PRE_SUCCESS != ioctl(drpai_obj_info.drpai_fd , DRPAI_START, &proc[0]))
+    if ( PRE_SUCCESS != driver->ioctl(drpai_obj_info.drpai_fd , DRPAI_START, &proc[0]))
     {
         std::cerr << "[ERROR] Failed to run DRPAI_START : errno=" <<  errno << std::endl;
         return PRE_ERROR;
     }
     /* Wait till DRP-AI ends */
-    FD_ZERO(&rfds);
-    FD_SET(drpai_obj_info.drpai_fd , &rfds);
     tv.tv_sec = 5;
     tv.tv_nsec = 0;
 
-    ret_drpai = pselect(drpai_obj_info.drpai_fd +1, &rfds, NULL, NULL, &tv, &sigset);
+    ret_drpai = driver->wait(drpai_obj_info.drpai_fd, tv, &sigset);
 
     if(0 == ret_drpai)
     {
@@ -2429,15 +2431,12 @@ uint8_t PreRuntime::Pre(s_preproc_param_t* param, void** out_ptr, uint32_t* out_
         return PRE_ERROR;
     }
 
-    if (FD_ISSET(drpai_obj_info.drpai_fd , &rfds))
+    errno = 0;
+    ret_drpai = driver->ioctl(drpai_obj_info.drpai_fd, DRPAI_GET_STATUS, &drpai_status);
+    if (-1 == ret_drpai)
     {
-        errno = 0;
-        ret_drpai = ioctl(drpai_obj_info.drpai_fd, DRPAI_GET_STATUS, &drpai_status);
-        if (-1 == ret_drpai)
-        {
-            std::cerr << "[ERROR] Failed to run DRPAI_GET_STATUS : errno=" << errno << std::endl;
-            return PRE_ERROR;
-        }
+        std::cerr << "[ERROR] Failed to run DRPAI_GET_STATUS : errno=" << errno << std::endl;
+        return PRE_ERROR;
     }
 #ifdef DEBUG_LOG
     /*Stop Timer */
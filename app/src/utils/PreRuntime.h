@@ -61,6 +61,7 @@
 #include <cmath>
 
 #include <builtin_fp16.h>
+#include "DrpaiDriver.h"
 /***********************************************************************************************************************
 * Macro
 ***********************************************************************************************************************/
@@ -360,10 +361,15 @@ static void print_preproc_param(const s_preproc_param_t data, uint8_t mode=MODE_
 class PreRuntime {
     public:
         PreRuntime();
+        /*Runs on driver instead of /dev/drpai0, e.g. a MockDrpaiDriver off the board.
+          driver must outlive the PreRuntime.*/
+        explicit PreRuntime(DrpaiDriver &driver);
         ~PreRuntime();
 
         uint8_t Load(const std::string pre_dir, uint32_t start_addr = INVALID_ADDR, uint8_t mode = MODE_PRE);
         uint8_t Pre(s_preproc_param_t* param, void** out_ptr, uint32_t* out_size);
+        /*Operators of the loaded drp_param_info.txt, e.g. for DrpOpInterpreter*/
+        const std::vector<s_op_t>& GetOpList() const { return param_info; }
 
     private:
         /*Internal parameter value holder*/
@@ -372,6 +378,8 @@ class PreRuntime {
         void* internal_buffer = NULL;
         /*Internal output buffer size*/
         uint32_t internal_buffer_size = 0;
+        /*DRP-AI Driver every call on drpai_obj_info.drpai_fd goes through*/
+        DrpaiDriver* driver;
         /*DRP-AI Driver dynamic allocation function*/
         drpai_handle_t drpai_obj_info;
         drpai_data_t drpai_data0;
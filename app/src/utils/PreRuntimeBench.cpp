@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "DrpOpInterpreter.h"
+#include "DrpaiDriver.h"
+#include "DrpaiMemoryPlanner.h"
+#include "PatchPipeline.h"
+#include "PipelineStats.h"
+#include "PreRuntime.h"
+#include "PreRuntimeBench.h"
+
+namespace
+{
+    const int ITERATIONS = 500;
+    // Room for the largest camera frame the pipeline feeds the DRP-AI, reserved at the top of the
+    // area; the objects are planned around it
+    const uint32_t INPUT_BYTES = (1920 * 1080 * 3 + 63) / 64 * 64;
+    const uint16_t RESIZED_INPUT[2][2] = {{640, 480}, {320, 240}};
+    // ImageNet normalisation, handed to Pre so the CPU run also covers the coefficient update
+    const std::array<float, 3> MEAN{0.485f, 0.456f, 0.406f};
+    const std::array<float, 3> STD{0.229f, 0.224f, 0.225f};
+    // One uint8 LSB after normalisation, plus fp16 rounding of the coefficients and the output
+    const float CPU_TOLERANCE = 0.03f;
+
+    using Call = MockDrpaiDriver::Call;
+
+    struct Scenario
+    {
+        MockDrpaiDriver::Fault fault;
+        // Load rather than Pre is expected to fail
+        bool load;
+    };
+
+    const Scenario SCENARIOS[] = {
+        {{Call::Open, EACCES}, true},
+        {{Call::GetArea, EIO}, true},
+        {{Call::AssignDynamic, EIO}, true},
+        {{Call::Write, EIO, 3}, true},
+        {{Call::AssignParam, EINVAL}, true},
+        {{Call::Assign, EIO}, false},
+        {{Call::Start, EBUSY}, false},
+        {{Call::Wait, 0}, false},
+        {{Call::Wait, EINTR}, false},
+        {{Call::GetStatus, EIO}, false},
+        {{Call::Read, EIO}, false},
+    };
+
+    /// @brief Copies a frame into the area the way the camera's DMA would, through the driver
+    bool writeInput(MockDrpaiDriver &driver, uint32_t address, const std::vector<uint8_t> &frame)
+    {
+        const int fd = driver.open();
+        drpai_data_t window{address, static_cast<uint32_t>(frame.size())};
+        const bool ok = fd >= 0 && driver.ioctl(fd, DRPAI_ASSIGN, &window) == 0 &&
+                        driver.write(fd, frame.data(), frame.size()) == static_cast<ssize_t>(frame.size());
+        if (fd >= 0)
+        {
+            driver.close(fd);
+        }
+        return ok;
+    }
+
+    struct Counts
+    {
+        uint64_t calls[static_cast<size_t>(Call::Count)];
+        uint64_t written;
+        uint64_t read;
+
+        explicit Counts(const MockDrpaiDriver &driver) : written(driver.bytes_written()), read(driver.bytes_read())
+        {
+            for (size_t i = 0; i < static_cast<size_t>(Call::Count); i++)
+            {
+                calls[i] = driver.calls(static_cast<Call>(i));
+            }
+        }
+    };
+
+    /// @brief Driver traffic between two snapshots, per operation
+    void printTraffic(std::ostream &os, const Counts &before, const Counts &after, uint64_t operations)
+    {
+        os << "{";
+        for (size_t i = 0; i < static_cast<size_t>(Call::Count); i++)
+        {
+            const uint64_t calls = after.calls[i] - before.calls[i];
+            if (calls > 0)
+            {
+                os << to_string(static_cast<Call>(i)) << ": " << static_cast<double>(calls) / operations << ", ";
+            }
+        }
+        os << "bytes_written: " << (after.written - before.written) / operations << ", "
+           << "bytes_read: " << (after.read - before.read) / operations << "}";
+    }
+
+    /// @brief Times ITERATIONS calls of Pre; with reparameterise every call switches the input size,
+    ///        so drp_param.bin is rewritten each time as when ROIs of different sizes alternate
+    bool timePre(std::ostream &os, const char *name, PreRuntime &runtime, MockDrpaiDriver &driver, s_preproc_param_t param, bool reparameterise)
+    {
+        LatencyStats latency;
+        const Counts before(driver);
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            if (reparameterise)
+            {
+                param.pre_in_shape_w = RESIZED_INPUT[i % 2][0];
+                param.pre_in_shape_h = RESIZED_INPUT[i % 2][1];
+            }
+            void *output = nullptr;
+            uint32_t output_size = 0;
+            const auto start = std::chrono::steady_clock::now();
+            if (PRE_SUCCESS != runtime.Pre(&param, &output, &output_size))
+            {
+                os << name << ": Pre failed on iteration " << i << std::endl;
+                return false;
+            }
+            latency.record(std::chrono::steady_clock::now() - start);
+        }
+        os << std::left << std::setw(9) << name << latency << std::endl
+           << std::setw(9) << "" << "per call: ";
+        printTraffic(os, before, Counts(driver), ITERATIONS);
+        os << std::endl;
+        return true;
+    }
+}
+
+int runPreRuntimeBench(std::ostream &os, const std::string &pre_dir)
+{
+    const auto config = MockDrpaiDriver::Config::fromEnvironment();
+    // Faults from the environment apply to loading and the timed runs; the scenarios set their own
+    MockDrpaiDriver driver(config);
+    os << "PreRuntime on the mock DRP-AI driver: {"
+       << "area: 0x" << std::hex << driver.area_address() << "+0x" << driver.area_size() << std::dec << ", "
+       << "latency_us: " << config.latency.count() << ", "
+       << "objects: " << pre_dir << "}" << std::endl;
+
+    // Two instances of the objects, as a second camera or model would load them, and the frame
+    DrpaiMemoryPlanner planner(driver.area_address(), driver.area_size());
+    const auto footprint = DrpaiMemoryPlanner::preRuntimeFootprint(pre_dir);
+    const auto input_region = planner.reserve("input frame", driver.area_address() + driver.area_size() - INPUT_BYTES, INPUT_BYTES);
+    const auto objects = footprint ? planner.allocate("preprocess", *footprint) : std::nullopt;
+    const auto second_objects = footprint ? planner.allocate("preprocess #2", *footprint) : std::nullopt;
+    if (!footprint || !input_region || !objects || !second_objects)
+    {
+        os << "cannot plan the mock area" << (footprint ? "" : ", no relocatable address map in " + pre_dir) << std::endl;
+        planner.report(os);
+        return 1;
+    }
+    planner.report(os);
+    const uint32_t input_address = *input_region;
+    std::vector<uint8_t> frame(INPUT_BYTES);
+    std::mt19937 rng(2024);
+    for (auto &byte : frame)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    if (!writeInput(driver, input_address, frame))
+    {
+        os << "failed to write the input frame to the mock area" << std::endl;
+        return 1;
+    }
+
+    auto runtime = std::make_unique<PreRuntime>(driver);
+    Counts before(driver);
+    const auto load_start = std::chrono::steady_clock::now();
+    if (PRE_SUCCESS != runtime->Load(pre_dir, *objects))
+    {
+        os << "Load failed" << std::endl;
+        return 1;
+    }
+    os << std::left << std::setw(9) << "load" << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count() << " ms, traffic: ";
+    printTraffic(os, before, Counts(driver), 1);
+    os << std::endl;
+
+    s_preproc_param_t param;
+    param.pre_in_addr = input_address;
+    bool passed = timePre(os, "pre", *runtime, driver, param, false) &&
+                  timePre(os, "reparam", *runtime, driver, param, true);
+
+    // Loaded after the first, so the CPU run below also checks nothing of the first was overwritten
+    PreRuntime second(driver);
+    const bool second_loaded = PRE_SUCCESS == second.Load(pre_dir, *second_objects);
+    // The plan must refuse what the area cannot hold rather than overlap
+    DrpaiMemoryPlanner exhausted = planner;
+    const bool refused = !exhausted.allocate("overflow", planner.largest_free() + 1);
+    passed = passed && second_loaded && refused;
+    os << std::setw(9) << "" << "second instance: " << (second_loaded ? "loaded" : "FAILED")
+       << ", oversized region: " << (refused ? "refused" : "NOT refused") << std::endl;
+
+    // The CPU interpreter as the mock's DRP-AI: Pre then produces the model input for real,
+    // which must match the app's own preprocessing of the same frame
+    DrpOpInterpreter interpreter(runtime->GetOpList());
+    if (!interpreter.IsSupported())
+    {
+        os << "cpu: the op list uses operators without a CPU implementation" << std::endl;
+        passed = false;
+    }
+    else
+    {
+        s_preproc_param_t cpu_param = param;
+        cpu_param.pre_in_shape_w = RESIZED_INPUT[0][0];
+        cpu_param.pre_in_shape_h = RESIZED_INPUT[0][1];
+        for (int c = 0; c < 3; c++)
+        {
+            cpu_param.cof_add[c] = -MEAN[c] * 255.0f;
+            cpu_param.cof_mul[c] = 1.0f / (STD[c] * 255.0f);
+        }
+        driver.set_job(interpreter.AsMockJob());
+        passed = timePre(os, "cpu", *runtime, driver, cpu_param, false) && passed;
+
+        void *output = nullptr;
+        uint32_t output_size = 0;
+        patch_sampler::TensorSpec spec;
+        spec.mean = MEAN;
+        spec.std = STD;
+        CapturedFrame captured;
+        captured.image = cv::Mat(RESIZED_INPUT[0][1], RESIZED_INPUT[0][0], CV_8UC3, frame.data());
+        captured.format = FORMAT_BGR;
+        std::vector<float> reference(3 * spec.size.area());
+        resample::PlanPtr plan;
+        const patch_sampler::PatchPipeline pipeline(spec, patch_sampler::OutputType::Float32);
+        pipeline.sample(captured, cv::Rect(cv::Point(0, 0), captured.size()), plan, reference.data());
+
+        float max_difference = -1;
+        if (PRE_SUCCESS == runtime->Pre(&cpu_param, &output, &output_size) && output_size == reference.size())
+        {
+            const float *values = static_cast<const float *>(output);
+            max_difference = 0;
+            for (size_t i = 0; i < reference.size(); i++)
+            {
+                max_difference = std::max(max_difference, std::abs(values[i] - reference[i]));
+            }
+        }
+        const bool ok = max_difference >= 0 && max_difference <= CPU_TOLERANCE;
+        passed = passed && ok;
+        os << std::setw(9) << "" << "max difference to PatchPipeline: " << max_difference << (ok ? "" : "  FAIL") << std::endl;
+        driver.set_job(nullptr);
+    }
+
+    os << std::left << std::setw(16) << "fault" << std::setw(10) << "errno" << std::setw(8) << "stage" << std::setw(10) << "reported" << "recovered" << std::endl;
+    for (const auto &scenario : SCENARIOS)
+    {
+        void *output = nullptr;
+        uint32_t output_size = 0;
+        uint8_t result;
+        bool recovered = true;
+        driver.set_faults({scenario.fault});
+        if (scenario.load)
+        {
+            PreRuntime fresh(driver);
+            result = fresh.Load(pre_dir, *second_objects);
+        }
+        else
+        {
+            result = runtime->Pre(&param, &output, &output_size);
+            driver.set_faults({});
+            recovered = PRE_SUCCESS == runtime->Pre(&param, &output, &output_size);
+        }
+        driver.set_faults({});
+
+        const bool reported = PRE_SUCCESS != result;
+        passed = passed && reported && recovered;
+        os << std::left << std::setw(16) << to_string(scenario.fault.call)
+           << std::setw(10) << (scenario.fault.error == 0 ? "timeout" : std::to_string(scenario.fault.error))
+           << std::setw(8) << (scenario.load ? "load" : "pre")
+           << std::setw(10) << (reported ? "yes" : "NO") << (scenario.load ? "-" : (recovered ? "yes" : "NO")) << std::endl;
+    }
+
+    os << (passed ? "all driver faults reported" : "PreRuntime FAILED on the mock driver") << std::endl;
+    return passed ? 0 : 1;
+}
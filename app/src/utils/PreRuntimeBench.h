@@ -0,0 +1,12 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+/// @brief `spark --bench-preruntime [pre_dir]`: loads the PreRuntime objects of pre_dir onto a
+///        MockDrpaiDriver, times Load and Pre, with DrpOpInterpreter as the DRP-AI and without,
+///        checks the interpreted output against PatchPipeline, then injects driver faults
+///        into each call Load and Pre make and checks they are reported and that Pre recovers.
+///        Mock latency and extra faults come from SPARK_DRPAI_MOCK_LATENCY_US / _FAULTS.
+/// @return process exit code, non-zero if Load or Pre fail unprompted or a fault goes unnoticed
+int runPreRuntimeBench(std::ostream &os, const std::string &pre_dir);
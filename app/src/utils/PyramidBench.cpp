@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "BenchUtils.h"
+#include "PatchBatch.h"
+#include "PatchPipeline.h"
+#include "PyramidBench.h"
+
+namespace
+{
+    using patch_sampler::OutputType;
+
+    const cv::Size FRAME_SIZE(1920, 1080);
+    // Same spread as the downscale bench, far spots to ones right in front of the camera
+    const cv::Size ROI_SIZES[] = {{32, 28}, {48, 36}, {64, 48}, {100, 80}, {160, 120}, {220, 150}, {300, 200}, {480, 320}};
+    const int SPOTS = 8;
+    const int LEVELS = 4;
+    const int ITERATIONS = 100;
+    // Mean absolute difference, in 0..255, that sampling a box-filtered level may add to an area
+    // resize at this frame's level of detail
+    const double AREA_TOLERANCE = 4.0;
+    // One of each layout: packed colour, packed 4:2:2 and semi-planar 4:2:0
+    const uint16_t FORMATS[] = {FORMAT_BGR, FORMAT_YUYV_422, FORMAT_NV12_420};
+
+    /// @brief Up to SPOTS ROIs of size, spread over the frame in two rows
+    std::vector<cv::Rect> layOut(cv::Size size)
+    {
+        std::vector<cv::Rect> rois;
+        const int columns = std::min(SPOTS / 2, FRAME_SIZE.width / size.width);
+        const int rows = std::min(2, FRAME_SIZE.height / size.height);
+        for (int row = 0; row < rows; row++)
+        {
+            for (int column = 0; column < columns; column++)
+            {
+                // Odd offsets, so ROIs don't line up with the pyramid's grid
+                rois.emplace_back(7 + column * (FRAME_SIZE.width / columns), 5 + row * (FRAME_SIZE.height / rows), size.width, size.height);
+            }
+        }
+        return rois;
+    }
+
+    /// @brief Mean absolute difference of two fp32 ToTensor() batches, in 0..255
+    double meanError(const PatchBatch &batch, const std::vector<float> &reference)
+    {
+        const float *values = static_cast<const float *>(batch.data());
+        double sum = 0;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            sum += std::abs(values[i] - reference[i]);
+        }
+        return reference.empty() ? 0.0 : 255.0 * sum / reference.size();
+    }
+}
+
+int runPyramidBench(std::ostream &os)
+{
+    // Per patch cost, not how well it spreads over cores
+    const int threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+    cv::RNG rng(2024);
+    bool passed = true;
+
+    os << "pyramid sampling: up to " << SPOTS << " ROIs of a " << FRAME_SIZE.width << "x" << FRAME_SIZE.height
+       << " frame, " << LEVELS << " levels, us per patch (pyramid_us includes its share of the"
+       << " per-frame build, sample_us does not),"
+       << " error vs area resize in 0..255" << std::endl;
+    os << std::left << std::setw(8) << "format" << std::setw(10) << "mode" << std::setw(10) << "roi" << std::setw(7) << "level"
+       << std::setw(11) << "direct_us" << std::setw(12) << "pyramid_us" << std::setw(11) << "sample_us" << std::setw(10) << "build_us" << std::setw(9) << "speedup"
+       << std::setw(14) << "direct_error" << "pyramid_error" << std::endl;
+
+    for (const uint16_t format : FORMATS)
+    {
+        const bench::FrameFormat &frame_format = bench::frameFormat(format);
+        const CapturedFrame frame = bench::syntheticFrame(frame_format, FRAME_SIZE, rng, 4);
+
+        // Area at full resolution is the alias-free reference both paths are held against
+        patch_sampler::TensorSpec reference_spec;
+        reference_spec.interpolation = resample::Interpolation::Area;
+        const patch_sampler::PatchPipeline reference_pipeline(reference_spec, OutputType::Float32);
+
+        for (auto interpolation : {resample::Interpolation::Bilinear, resample::Interpolation::Area})
+        {
+            patch_sampler::TensorSpec spec;
+            spec.interpolation = interpolation;
+            const patch_sampler::PatchPipeline pipeline(spec, OutputType::Float32);
+            const ImagePyramid levels(LEVELS);
+
+            for (const auto &roi_size : ROI_SIZES)
+            {
+                const std::vector<cv::Rect> rois = layOut(roi_size);
+                std::vector<resample::PlanPtr> direct_plans(rois.size()), pyramid_plans(rois.size()), reference_plans(rois.size());
+                PatchBatch direct(pipeline), pyramid(pipeline, LEVELS), reference(reference_pipeline);
+                for (size_t i = 0; i < rois.size(); i++)
+                {
+                    direct.add(i, rois[i], direct_plans[i]);
+                    pyramid.add(i, rois[i], pyramid_plans[i]);
+                    reference.add(i, rois[i], reference_plans[i]);
+                }
+                direct.fill(frame);
+                pyramid.fill(frame);
+                reference.fill(frame);
+
+                const size_t elements = rois.size() * pipeline.patch_bytes() / sizeof(float);
+                const std::vector<float> expected(static_cast<const float *>(reference.data()), static_cast<const float *>(reference.data()) + elements);
+                const std::vector<float> direct_values(static_cast<const float *>(direct.data()), static_cast<const float *>(direct.data()) + elements);
+                const double direct_error = meanError(direct, expected);
+                const double pyramid_error = meanError(pyramid, expected);
+
+                const int level = levels.level_for(roi_size, pipeline.pyramid_target());
+                bool ok;
+                if (level == 0)
+                {
+                    // Below twice the patch size the pyramid must not be used at all
+                    ok = meanError(pyramid, direct_values) == 0.0;
+                }
+                else
+                {
+                    // Bilinear is not meant to match area, only to alias less once prefiltered
+                    ok = interpolation == resample::Interpolation::Area ? pyramid_error <= AREA_TOLERANCE : pyramid_error < direct_error;
+                }
+                passed = passed && ok;
+
+                pyramid.reset_stats();
+                const double direct_us = bench::medianTime([&]
+                                                           { direct.fill(frame); },
+                                                           ITERATIONS) /
+                                         rois.size();
+                const double pyramid_us = bench::medianTime([&]
+                                                            { pyramid.fill(frame); },
+                                                            ITERATIONS) /
+                                          rois.size();
+                const double build_us = pyramid.stats().pyramid_time.samples() == 0 ? 0.0 : 1000.0 * pyramid.stats().pyramid_time.mean();
+                const double sample_us = std::max(0.0, pyramid_us - build_us / rois.size());
+
+                os << std::left << std::setw(8) << frame_format.name << std::setw(10) << resample::to_string(interpolation)
+                   << std::setw(10) << (std::to_string(roi_size.width) + "x" + std::to_string(roi_size.height)) << std::setw(7) << level
+                   << std::setw(11) << direct_us << std::setw(12) << pyramid_us << std::setw(11) << sample_us << std::setw(10) << build_us
+                   << std::setw(9) << (pyramid_us > 0 ? direct_us / pyramid_us : 0.0)
+                   << std::setw(14) << direct_error << pyramid_error << (ok ? "" : "  FAIL") << std::endl;
+            }
+        }
+    }
+
+    cv::setNumThreads(threads);
+    os << (passed ? "pyramid sampling within tolerance" : "pyramid sampling OUT OF TOLERANCE") << std::endl;
+    return passed ? 0 : 1;
+}
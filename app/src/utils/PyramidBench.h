@@ -0,0 +1,10 @@
+#pragma once
+
+#include <iostream>
+
+/// @brief `spark --bench-pyramid`: samples a lot of equal ROIs per size straight from the frame
+///        and through an ImagePyramid, single-threaded, and reports the cost per patch and each
+///        path's mean error against an area resize of the full-resolution ROI.
+/// @return process exit code, non-zero if the pyramid path alters ROIs it should leave to the
+///         frame, aliases more than direct bilinear sampling or drifts from the area reference
+int runPyramidBench(std::ostream &os);
@@ -0,0 +1,137 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "RawFileFrameSource.h"
+
+namespace
+{
+    // A consumer that holds every slot this long is stuck, not slow
+    const auto SLOT_WAIT_TIMEOUT = std::chrono::seconds(2);
+}
+
+RawFileFrameSource::RawFileFrameSource(const std::string &path, cv::Size frame_size, uint16_t format, size_t buffer_count, double fps)
+    : path(path), size(frame_size), format(format), fps(fps), slot_out(buffer_count, false) {}
+
+RawFileFrameSource::~RawFileFrameSource()
+{
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mapping_length);
+    }
+}
+
+bool RawFileFrameSource::open()
+{
+    frame_bytes = format == FORMAT_NV12_420 ? size.area() * 3 / 2 : size.area() * 2;
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "[ERROR] Failed to open " << path << " : errno=" << errno << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < frame_bytes)
+    {
+        std::cerr << "[ERROR] " << path << " holds less than one " << size.width << "x" << size.height << " frame" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    mapping_length = st.st_size;
+    // Private and writable so consumers may draw on a frame without touching the file
+    void *addr = mmap(nullptr, mapping_length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        std::cerr << "[ERROR] Failed to mmap " << path << " : errno=" << errno << std::endl;
+        return false;
+    }
+    mapping = static_cast<uint8_t *>(addr);
+    frame_count = mapping_length / frame_bytes;
+    next_frame = 0;
+    next_due = CapturedFrame::Clock::now();
+    return true;
+}
+
+bool RawFileFrameSource::read(CapturedFrame &frame)
+{
+    if (next_frame >= frame_count)
+    {
+        return false;
+    }
+
+    size_t slot = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto free_slot = [&]
+        {
+            for (slot = 0; slot < slot_out.size(); slot++)
+            {
+                if (!slot_out[slot])
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (!free_slot())
+        {
+            starved++;
+            if (!buffer_returned.wait_for(lock, SLOT_WAIT_TIMEOUT, free_slot))
+            {
+                std::cerr << "[ERROR] All " << slot_out.size() << " replay buffers are still held by the consumer" << std::endl;
+                return false;
+            }
+        }
+        slot_out[slot] = true;
+        delivered++;
+    }
+
+    if (fps > 0)
+    {
+        // Pace the replay like a real camera would
+        std::this_thread::sleep_until(next_due);
+        next_due += std::chrono::duration_cast<CapturedFrame::Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    }
+
+    const int rows = format == FORMAT_NV12_420 ? size.height * 3 / 2 : size.height;
+    const int type = format == FORMAT_NV12_420 ? CV_8UC1 : CV_8UC2;
+    frame.image = cv::Mat(rows, size.width, type, mapping + next_frame * frame_bytes);
+    frame.format = format;
+    frame.buffer_index = static_cast<int>(slot);
+    frame.captured_at = CapturedFrame::Clock::now();
+    next_frame++;
+    return true;
+}
+
+void RawFileFrameSource::release(CapturedFrame &&frame)
+{
+    if (frame.buffer_index < 0)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        slot_out[frame.buffer_index] = false;
+        returned++;
+    }
+    buffer_returned.notify_one();
+    frame.image.release();
+    frame.buffer_index = -1;
+}
+
+void RawFileFrameSource::print_stats(std::ostream &os) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    os << "{backend: raw-file, "
+       << "frames_in_file: " << frame_count << ", "
+       << "delivered: " << delivered << ", "
+       << "returned: " << returned << ", "
+       << "starved: " << starved
+       << "}";
+}
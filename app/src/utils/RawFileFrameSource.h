@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "FrameSource.h"
+
+/// @brief Replays a headerless dump of YUYV or NV12 frames, e.g. captured with
+///        `v4l2-ctl --stream-mmap --stream-to=lot.yuyv`.
+///
+/// Follows the same zero-copy contract as V4l2FrameSource: the file is mmap'd once, read()
+/// returns views into the mapping, and at most buffer_count frames can be outstanding before
+/// read() blocks, just like a driver running out of queued buffers. This is what lets the
+/// V4L2 buffer handling be exercised and benchmarked without a camera.
+class RawFileFrameSource : public FrameSource
+{
+public:
+    RawFileFrameSource(const std::string &path, cv::Size frame_size, uint16_t format, size_t buffer_count, double fps);
+    ~RawFileFrameSource() override;
+
+    bool open() override;
+    bool read(CapturedFrame &frame) override;
+    void release(CapturedFrame &&frame) override;
+
+    cv::Size frame_size() const override { return size; }
+    uint16_t pixel_format() const override { return format; }
+
+    void print_stats(std::ostream &os) const override;
+
+private:
+    const std::string path;
+    const cv::Size size;
+    const uint16_t format;
+    const double fps;
+
+    uint8_t *mapping = nullptr;
+    size_t mapping_length = 0;
+    size_t frame_bytes = 0;
+    size_t frame_count = 0;
+    size_t next_frame = 0;
+    CapturedFrame::Clock::time_point next_due;
+
+    mutable std::mutex mutex;
+    std::condition_variable buffer_returned;
+    // Emulated driver queue: true while the slot is handed out
+    std::vector<bool> slot_out;
+
+    uint64_t delivered = 0;
+    uint64_t returned = 0;
+    uint64_t starved = 0;
+};
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ResamplePlan.h"
+
+namespace
+{
+    using resample::AxisPlan;
+    using resample::COEF_SCALE;
+
+    void addTap(AxisPlan &axis, int index, float weight)
+    {
+        axis.taps.push_back({index, weight, static_cast<short>(std::lrint(weight * COEF_SCALE))});
+    }
+
+    // The axis functions sample [origin, origin + extent) of src_len source pixels; for a whole
+    // ROI origin is 0 and extent src_len
+
+    void nearestTaps(double origin, double extent, int src_len, int dst_len, AxisPlan &axis)
+    {
+        const double scale = extent / dst_len;
+        for (int dst = 0; dst < dst_len; dst++)
+        {
+            axis.begin.push_back(static_cast<int>(axis.taps.size()));
+            addTap(axis, std::max(0, std::min(static_cast<int>(std::floor(origin + dst * scale)), src_len - 1)), 1.0f);
+        }
+    }
+
+    /// @brief Same coefficient computation as cv::resize with INTER_LINEAR
+    void linearTaps(double origin, double extent, int src_len, int dst_len, AxisPlan &axis)
+    {
+        const double scale = extent / dst_len;
+        for (int dst = 0; dst < dst_len; dst++)
+        {
+            float frac = static_cast<float>(origin + (dst + 0.5) * scale - 0.5);
+            int src = static_cast<int>(std::floor(frac));
+            frac -= src;
+            if (src < 0)
+            {
+                frac = 0.0f;
+                src = 0;
+            }
+            if (src >= src_len - 1)
+            {
+                frac = 0.0f;
+                src = src_len - 1;
+            }
+            axis.begin.push_back(static_cast<int>(axis.taps.size()));
+            addTap(axis, src, 1.0f - frac);
+            addTap(axis, std::min(src + 1, src_len - 1), frac);
+        }
+    }
+
+    /// @brief Same cell decomposition as OpenCV's computeResizeAreaTab
+    void areaTaps(double origin, double extent, int src_len, int dst_len, AxisPlan &axis)
+    {
+        const double scale = extent / dst_len;
+        for (int dst = 0; dst < dst_len; dst++)
+        {
+            axis.begin.push_back(static_cast<int>(axis.taps.size()));
+            const double start = origin + dst * scale;
+            const double end = start + scale;
+            const double cell = std::min(scale, src_len - start);
+
+            const int last = std::min(static_cast<int>(std::floor(end)), src_len - 1);
+            const int first = std::min(static_cast<int>(std::ceil(start)), last);
+
+            if (first - start > 1e-3)
+            {
+                addTap(axis, first - 1, static_cast<float>((first - start) / cell));
+            }
+            for (int src = first; src < last; src++)
+            {
+                addTap(axis, src, static_cast<float>(1.0 / cell));
+            }
+            if (end - last > 1e-3)
+            {
+                addTap(axis, last, static_cast<float>(std::min(std::min(end - last, 1.0), cell) / cell));
+            }
+        }
+    }
+
+    void buildAxis(resample::Interpolation interpolation, double origin, double extent, int src_len, int dst_len, AxisPlan &axis)
+    {
+        axis.taps.clear();
+        axis.begin.clear();
+        switch (interpolation)
+        {
+        case resample::Interpolation::Nearest:
+            nearestTaps(origin, extent, src_len, dst_len, axis);
+            break;
+        case resample::Interpolation::Area:
+            areaTaps(origin, extent, src_len, dst_len, axis);
+            break;
+        default:
+            linearTaps(origin, extent, src_len, dst_len, axis);
+            break;
+        }
+        axis.begin.push_back(static_cast<int>(axis.taps.size()));
+    }
+}
+
+namespace resample
+{
+    const char *to_string(Interpolation interpolation)
+    {
+        switch (interpolation)
+        {
+        case Interpolation::Nearest:
+            return "nearest";
+        case Interpolation::Bilinear:
+            return "bilinear";
+        case Interpolation::Area:
+            return "area";
+        }
+        return "unknown";
+    }
+
+    bool Plan::fits(const cv::Rect &roi, cv::Size size, Interpolation interpolation) const
+    {
+        return fits(roi, cv::Rect2d(roi), size, interpolation);
+    }
+
+    bool Plan::fits(const cv::Rect &roi, const cv::Rect2d &window, cv::Size size, Interpolation interpolation) const
+    {
+        return this->roi == roi && this->window == window && this->size == size && requested == interpolation;
+    }
+
+    Plan buildPlan(const cv::Rect &roi, cv::Size size, Interpolation interpolation)
+    {
+        return buildPlan(roi, cv::Rect2d(roi), size, interpolation);
+    }
+
+    Plan buildPlan(const cv::Rect &roi, const cv::Rect2d &window, cv::Size size, Interpolation interpolation)
+    {
+        CV_Assert(!roi.empty() && window.width > 0 && window.height > 0 && size.width > 0 && size.height > 0);
+
+        Plan plan;
+        plan.roi = roi;
+        plan.window = window;
+        plan.size = size;
+        plan.requested = interpolation;
+        plan.interpolation = interpolation;
+        if (interpolation == Interpolation::Area && (size.width > window.width || size.height > window.height))
+        {
+            plan.interpolation = Interpolation::Bilinear;
+        }
+        buildAxis(plan.interpolation, window.x - roi.x, window.width, roi.width, size.width, plan.x);
+        buildAxis(plan.interpolation, window.y - roi.y, window.height, roi.height, size.height, plan.y);
+        return plan;
+    }
+
+    const Plan &cachedPlan(PlanPtr &cache, const cv::Rect &roi, cv::Size size, Interpolation interpolation)
+    {
+        return cachedPlan(cache, roi, cv::Rect2d(roi), size, interpolation);
+    }
+
+    const Plan &cachedPlan(PlanPtr &cache, const cv::Rect &roi, const cv::Rect2d &window, cv::Size size, Interpolation interpolation)
+    {
+        if (!cache || !cache->fits(roi, window, size, interpolation))
+        {
+            cache = std::make_shared<const Plan>(buildPlan(roi, window, size, interpolation));
+        }
+        return *cache;
+    }
+}
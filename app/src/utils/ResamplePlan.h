@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/// @brief Precomputed source taps for shrinking one ROI to a fixed patch size.
+///
+/// Where a patch pixel reads from and with which weights depends only on the ROI rectangle,
+/// the output size and the interpolation, none of which change from frame to frame. A Plan
+/// holds that mapping so per-frame sampling is a gather-and-blend over the cached taps.
+namespace resample
+{
+    enum class Interpolation
+    {
+        Nearest,
+        Bilinear, // cv::INTER_LINEAR
+        Area      // cv::INTER_AREA; bilinear when enlarging
+    };
+
+    const char *to_string(Interpolation interpolation);
+
+    // Fixed-point precision of Tap::fixed, INTER_RESIZE_COEF_BITS in OpenCV
+    const int COEF_BITS = 11;
+    const int COEF_SCALE = 1 << COEF_BITS;
+
+    /// @brief One source pixel along an axis, relative to the ROI, and its weight
+    struct Tap
+    {
+        int index;
+        float weight;
+        // weight in Q11; for bilinear these are OpenCV's exact coefficients
+        short fixed;
+    };
+
+    /// @brief taps[begin[o], begin[o + 1]) make output coordinate o. Bilinear outputs always have two taps
+    struct AxisPlan
+    {
+        std::vector<Tap> taps;
+        std::vector<int> begin;
+    };
+
+    struct Plan
+    {
+        // The image-space ROI the plan was built for; tap indices are relative to its top-left corner
+        cv::Rect roi;
+        // The part of roi that is resampled, in the same coordinates; roi itself unless the ROI
+        // was mapped onto a coarser grid, e.g. an ImagePyramid level
+        cv::Rect2d window;
+        cv::Size size;
+        // What was asked for and what the taps implement: Area enlarging along either axis is planned as Bilinear
+        Interpolation requested = Interpolation::Bilinear;
+        Interpolation interpolation = Interpolation::Bilinear;
+        AxisPlan x;
+        AxisPlan y;
+
+        /// @brief True if the plan was built for exactly this ROI, output size and requested interpolation
+        bool fits(const cv::Rect &roi, cv::Size size, Interpolation interpolation) const;
+        bool fits(const cv::Rect &roi, const cv::Rect2d &window, cv::Size size, Interpolation interpolation) const;
+    };
+
+    // Shared and immutable once built, so copying a ParkingSpot doesn't copy its taps
+    using PlanPtr = std::shared_ptr<const Plan>;
+
+    /// @brief Same tap positions and weights cv::resize computes for roi.size() -> size
+    Plan buildPlan(const cv::Rect &roi, cv::Size size, Interpolation interpolation);
+    /// @brief Taps over roi that resample the sub-pixel window inside it, as cv::resize would
+    ///        resample window if its edges fell on pixel boundaries
+    Plan buildPlan(const cv::Rect &roi, const cv::Rect2d &window, cv::Size size, Interpolation interpolation);
+
+    /// @brief The plan in cache, rebuilt first if cache is empty or was built for another ROI or spec
+    const Plan &cachedPlan(PlanPtr &cache, const cv::Rect &roi, cv::Size size, Interpolation interpolation);
+    const Plan &cachedPlan(PlanPtr &cache, const cv::Rect &roi, const cv::Rect2d &window, cv::Size size, Interpolation interpolation);
+}
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cmath>
+
+#include "RoiCropFrameSource.h"
+
+namespace
+{
+    // Capture scales tried by chooseCaptureSize, smallest last
+    const double CAPTURE_SCALES[] = {1.0, 2.0 / 3.0, 1.0 / 2.0, 1.0 / 3.0, 1.0 / 4.0};
+    // Extra pixels around the ROI union so bilinear taps at the ROI edges stay inside the crop
+    const int CROP_MARGIN = 2;
+
+    bool isSemiPlanar(uint16_t format)
+    {
+        return format == FORMAT_NV12_420 || format == FORMAT_NV21_420;
+    }
+
+    bool isYuv(uint16_t format)
+    {
+        return isSemiPlanar(format) || format == FORMAT_YUYV_422 || format == FORMAT_YVYU_422 || format == FORMAT_UYUV_422;
+    }
+
+    int alignDown(int value, int alignment) { return value / alignment * alignment; }
+    int alignUp(int value, int alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+    /// @brief Buffer geometry and type for a picture of size in format, see CapturedFrame::image
+    void bufferShape(uint16_t format, cv::Size size, cv::Size &buffer_size, int &type)
+    {
+        if (isSemiPlanar(format))
+        {
+            buffer_size = cv::Size(size.width, size.height * 3 / 2);
+            type = CV_8UC1;
+        }
+        else if (isYuv(format))
+        {
+            buffer_size = size;
+            type = CV_8UC2;
+        }
+        else
+        {
+            buffer_size = size;
+            type = format == FORMAT_GRAY ? CV_8UC1 : CV_8UC3;
+        }
+    }
+}
+
+cv::Size chooseCaptureSize(cv::Size full_size, const std::vector<cv::Rect> &rois, int min_roi_pixels)
+{
+    if (rois.empty())
+    {
+        return full_size;
+    }
+
+    int smallest_side = INT32_MAX;
+    for (const auto &roi : rois)
+    {
+        smallest_side = std::min({smallest_side, roi.width, roi.height});
+    }
+
+    cv::Size chosen = full_size;
+    for (double scale : CAPTURE_SCALES)
+    {
+        if (smallest_side * scale < min_roi_pixels)
+        {
+            break;
+        }
+        // Even dimensions keep every YUV layout valid
+        chosen = cv::Size(alignDown(static_cast<int>(full_size.width * scale), 2), alignDown(static_cast<int>(full_size.height * scale), 2));
+    }
+    return chosen;
+}
+
+RoiCropFrameSource::RoiCropFrameSource(std::unique_ptr<FrameSource> inner, const std::vector<cv::Rect> &rois, cv::Size reference_size, size_t buffer_count)
+    : inner(std::move(inner)), rois(rois), reference_size(reference_size), pool(buffer_count) {}
+
+bool RoiCropFrameSource::open()
+{
+    if (!inner->open())
+    {
+        return false;
+    }
+
+    const cv::Size delivered = inner->frame_size();
+    if (!reference_size.empty())
+    {
+        // The camera may not have honoured the requested mode exactly
+        scale = cv::Point2d(static_cast<double>(delivered.width) / reference_size.width, static_cast<double>(delivered.height) / reference_size.height);
+    }
+
+    CapturedFrame mapping;
+    mapping.scale = scale;
+    cv::Rect roi_union;
+    for (const auto &roi : rois)
+    {
+        roi_union |= mapping.toImage(roi);
+    }
+    if (roi_union.empty())
+    {
+        roi_union = cv::Rect(cv::Point(0, 0), delivered);
+    }
+
+    // Whole 2x2 chroma cells, so the crop is valid in every YUV layout
+    const int x0 = alignDown(std::max(0, roi_union.x - CROP_MARGIN), 2);
+    const int y0 = alignDown(std::max(0, roi_union.y - CROP_MARGIN), 2);
+    const int x1 = std::min(alignUp(roi_union.br().x + CROP_MARGIN, 2), alignDown(delivered.width, 2));
+    const int y1 = std::min(alignUp(roi_union.br().y + CROP_MARGIN, 2), alignDown(delivered.height, 2));
+    crop = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+
+    cv::Size buffer_size;
+    int type;
+    bufferShape(inner->pixel_format(), crop.size(), buffer_size, type);
+    pool.preallocate(buffer_size, type);
+    return !crop.empty();
+}
+
+void RoiCropFrameSource::copyCrop(const CapturedFrame &full, cv::Mat &out) const
+{
+    if (isSemiPlanar(full.format))
+    {
+        // Y plane rows, then the interleaved chroma rows at half vertical resolution
+        const int height = full.size().height;
+        cv::Mat luma = out.rowRange(0, crop.height);
+        cv::Mat chroma = out.rowRange(crop.height, crop.height * 3 / 2);
+        full.image(crop).copyTo(luma);
+        full.image(cv::Rect(crop.x, height + crop.y / 2, crop.width, crop.height / 2)).copyTo(chroma);
+        return;
+    }
+    full.image(crop).copyTo(out);
+}
+
+bool RoiCropFrameSource::read(CapturedFrame &frame)
+{
+    CapturedFrame full;
+    if (!inner->read(full))
+    {
+        return false;
+    }
+
+    frame.image = pool.acquire();
+    const uchar *buffer = frame.image.data;
+    copyCrop(full, frame.image);
+    pool.note_capture(buffer, frame.image);
+
+    frame.format = full.format;
+    frame.buffer_index = -1;
+    frame.captured_at = full.captured_at;
+    frame.scale = scale;
+    frame.origin = crop.tl();
+
+    bytes_in += full.image.total() * full.image.elemSize();
+    bytes_out += frame.image.total() * frame.image.elemSize();
+    // The crop is ours now; the driver can refill its buffer
+    inner->release(std::move(full));
+    return true;
+}
+
+void RoiCropFrameSource::release(CapturedFrame &&frame)
+{
+    pool.release(std::move(frame.image));
+}
+
+void RoiCropFrameSource::print_stats(std::ostream &os) const
+{
+    const double kept = bytes_in == 0 ? 0.0 : 100.0 * bytes_out / bytes_in;
+    os << "{backend: roi-crop, "
+       << "capture_scale: " << scale.x << "x" << scale.y << ", "
+       << "crop: " << crop.width << "x" << crop.height << "+" << crop.x << "+" << crop.y << ", "
+       << "bytes_kept_percent: " << kept << ", "
+       << "pool: " << pool.stats() << ", "
+       << "inner: " << *inner
+       << "}";
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "FramePool.h"
+#include "FrameSource.h"
+
+/// @brief Lowest capture resolution at which every ROI still spans min_roi_pixels in both directions.
+///
+/// Candidates are full_size scaled by 1, 2/3, 1/2, 1/3 and 1/4 (1080p, 720p, 540p, 360p, 270p for a
+/// 1080p camera). rois are in full_size coordinates. Returns full_size if no ROIs are given.
+cv::Size chooseCaptureSize(cv::Size full_size, const std::vector<cv::Rect> &rois, int min_roi_pixels);
+
+/// @brief Decorates another FrameSource so that frames only carry the bounding union of the ROIs.
+///
+/// Each captured frame is copied, cropped, into a pooled buffer and the inner frame goes straight
+/// back to its source, so the ring holds crop-sized buffers and the driver gets its buffers back
+/// immediately. The crop is aligned to whole chroma cells and padded by a couple of pixels for
+/// the bilinear taps. Frames carry the origin/scale that map ROI coordinates into them.
+class RoiCropFrameSource : public FrameSource
+{
+public:
+    /// @param rois In reference_size coordinates
+    /// @param reference_size Geometry the ROIs were drawn at; an empty size means "whatever the inner source delivers"
+    RoiCropFrameSource(std::unique_ptr<FrameSource> inner, const std::vector<cv::Rect> &rois, cv::Size reference_size, size_t buffer_count);
+
+    bool open() override;
+    bool read(CapturedFrame &frame) override;
+    void release(CapturedFrame &&frame) override;
+
+    cv::Size frame_size() const override { return crop.size(); }
+    uint16_t pixel_format() const override { return inner->pixel_format(); }
+
+    void print_stats(std::ostream &os) const override;
+
+private:
+    void copyCrop(const CapturedFrame &full, cv::Mat &out) const;
+
+    std::unique_ptr<FrameSource> inner;
+    const std::vector<cv::Rect> rois;
+    const cv::Size reference_size;
+
+    cv::Point2d scale{1.0, 1.0};
+    cv::Rect crop;
+    FramePool pool;
+
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+};
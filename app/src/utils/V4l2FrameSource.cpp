@@ -0,0 +1,273 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#include "V4l2FrameSource.h"
+
+namespace
+{
+    // How long read() waits for the camera before treating the stream as dead
+    const int DEQUEUE_TIMEOUT_SEC = 2;
+
+    uint32_t toFourcc(uint16_t format)
+    {
+        return format == FORMAT_NV12_420 ? V4L2_PIX_FMT_NV12 : V4L2_PIX_FMT_YUYV;
+    }
+
+    uint16_t fromFourcc(uint32_t fourcc)
+    {
+        switch (fourcc)
+        {
+        case V4L2_PIX_FMT_YUYV:
+            return FORMAT_YUYV_422;
+        case V4L2_PIX_FMT_NV12:
+            return FORMAT_NV12_420;
+        default:
+            return FORMAT_UNKNOWN;
+        }
+    }
+}
+
+V4l2FrameSource::V4l2FrameSource(const std::string &device, cv::Size requested_size, uint16_t requested_format, size_t buffer_count)
+    : device(device), requested_size(requested_size), requested_format(requested_format), requested_buffers(buffer_count) {}
+
+V4l2FrameSource::~V4l2FrameSource()
+{
+    close();
+}
+
+int V4l2FrameSource::xioctl(unsigned long request, void *arg) const
+{
+    int ret;
+    do
+    {
+        ret = ioctl(fd, request, arg);
+    } while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+bool V4l2FrameSource::open()
+{
+    fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0)
+    {
+        std::cerr << "[ERROR] Failed to open " << device << " : errno=" << errno << std::endl;
+        return false;
+    }
+
+    v4l2_capability cap;
+    std::memset(&cap, 0, sizeof(cap));
+    if (xioctl(VIDIOC_QUERYCAP, &cap) == -1 || !(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(cap.capabilities & V4L2_CAP_STREAMING))
+    {
+        std::cerr << "[ERROR] " << device << " is not a streaming capture device" << std::endl;
+        close();
+        return false;
+    }
+
+    v4l2_format fmt;
+    std::memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = requested_size.width;
+    fmt.fmt.pix.height = requested_size.height;
+    fmt.fmt.pix.pixelformat = toFourcc(requested_format);
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(VIDIOC_S_FMT, &fmt) == -1)
+    {
+        std::cerr << "[ERROR] VIDIOC_S_FMT failed : errno=" << errno << std::endl;
+        close();
+        return false;
+    }
+    // The driver may have adjusted any of these
+    size = cv::Size(fmt.fmt.pix.width, fmt.fmt.pix.height);
+    format = fromFourcc(fmt.fmt.pix.pixelformat);
+    bytes_per_line = fmt.fmt.pix.bytesperline;
+    if (format == FORMAT_UNKNOWN)
+    {
+        std::cerr << "[ERROR] " << device << " offers neither YUYV nor NV12" << std::endl;
+        close();
+        return false;
+    }
+
+    v4l2_requestbuffers req;
+    std::memset(&req, 0, sizeof(req));
+    req.count = requested_buffers;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(VIDIOC_REQBUFS, &req) == -1 || req.count < 2)
+    {
+        std::cerr << "[ERROR] VIDIOC_REQBUFS failed : errno=" << errno << std::endl;
+        close();
+        return false;
+    }
+
+    buffers.resize(req.count);
+    for (uint32_t i = 0; i < req.count; i++)
+    {
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(VIDIOC_QUERYBUF, &buf) == -1)
+        {
+            std::cerr << "[ERROR] VIDIOC_QUERYBUF failed : errno=" << errno << std::endl;
+            close();
+            return false;
+        }
+
+        buffers[i].length = buf.length;
+        buffers[i].start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+        if (buffers[i].start == MAP_FAILED)
+        {
+            buffers[i].start = nullptr;
+            std::cerr << "[ERROR] mmap of V4L2 buffer " << i << " failed : errno=" << errno << std::endl;
+            close();
+            return false;
+        }
+
+        if (xioctl(VIDIOC_QBUF, &buf) == -1)
+        {
+            std::cerr << "[ERROR] VIDIOC_QBUF failed : errno=" << errno << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(VIDIOC_STREAMON, &type) == -1)
+    {
+        std::cerr << "[ERROR] VIDIOC_STREAMON failed : errno=" << errno << std::endl;
+        close();
+        return false;
+    }
+    streaming = true;
+    return true;
+}
+
+bool V4l2FrameSource::read(CapturedFrame &frame)
+{
+    v4l2_buffer buf;
+    bool stalled = false;
+    while (true)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        timeval tv{DEQUEUE_TIMEOUT_SEC, 0};
+        const int ret = select(fd + 1, &fds, nullptr, nullptr, &tv);
+        if (ret == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret == -1)
+        {
+            std::cerr << "[ERROR] select on " << device << " failed : errno=" << errno << std::endl;
+            return false;
+        }
+        if (ret == 0)
+        {
+            // read() blocks: a camera that stalls for a while is waited for, not given up on
+            timeouts++;
+            if (!stalled)
+            {
+                std::cerr << "[WARNING] No frame from " << device << " for " << DEQUEUE_TIMEOUT_SEC << " s, still waiting" << std::endl;
+                stalled = true;
+            }
+            if (!streaming)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(VIDIOC_DQBUF, &buf) == 0)
+        {
+            break;
+        }
+        if (errno != EAGAIN)
+        {
+            std::cerr << "[ERROR] VIDIOC_DQBUF failed : errno=" << errno << std::endl;
+            return false;
+        }
+    }
+    dequeued++;
+
+    const int rows = format == FORMAT_NV12_420 ? size.height * 3 / 2 : size.height;
+    const int type = format == FORMAT_NV12_420 ? CV_8UC1 : CV_8UC2;
+    frame.image = cv::Mat(rows, size.width, type, buffers[buf.index].start, bytes_per_line);
+    frame.format = format;
+    frame.buffer_index = static_cast<int>(buf.index);
+
+    // UVC timestamps are CLOCK_MONOTONIC, the same clock steady_clock reads on Linux
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+    {
+        frame.captured_at = CapturedFrame::Clock::time_point(std::chrono::seconds(buf.timestamp.tv_sec) + std::chrono::microseconds(buf.timestamp.tv_usec));
+    }
+    else
+    {
+        frame.captured_at = CapturedFrame::Clock::now();
+    }
+    return true;
+}
+
+void V4l2FrameSource::release(CapturedFrame &&frame)
+{
+    if (frame.buffer_index < 0 || !streaming)
+    {
+        return;
+    }
+
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = frame.buffer_index;
+    if (xioctl(VIDIOC_QBUF, &buf) == -1)
+    {
+        std::cerr << "[ERROR] VIDIOC_QBUF failed : errno=" << errno << std::endl;
+        return;
+    }
+    requeued++;
+    frame.image.release();
+    frame.buffer_index = -1;
+}
+
+void V4l2FrameSource::close()
+{
+    if (streaming.exchange(false))
+    {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(VIDIOC_STREAMOFF, &type);
+    }
+    for (auto &buffer : buffers)
+    {
+        if (buffer.start != nullptr)
+        {
+            munmap(buffer.start, buffer.length);
+        }
+    }
+    buffers.clear();
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void V4l2FrameSource::print_stats(std::ostream &os) const
+{
+    os << "{backend: v4l2, "
+       << "buffers: " << buffers.size() << ", "
+       << "dequeued: " << dequeued << ", "
+       << "requeued: " << requeued << ", "
+       << "timeouts: " << timeouts
+       << "}";
+}
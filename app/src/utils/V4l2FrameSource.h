@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "FrameSource.h"
+
+/// @brief Direct V4L2 streaming capture with VIDIOC_REQBUFS mmap'd buffers.
+///
+/// read() dequeues a driver buffer and returns a cv::Mat header over its mapping; release()
+/// queues it back. Nothing is copied or converted, so frames arrive in the camera's native
+/// YUYV or NV12 layout.
+class V4l2FrameSource : public FrameSource
+{
+public:
+    V4l2FrameSource(const std::string &device, cv::Size requested_size, uint16_t requested_format, size_t buffer_count);
+    ~V4l2FrameSource() override;
+
+    bool open() override;
+    bool read(CapturedFrame &frame) override;
+    void release(CapturedFrame &&frame) override;
+
+    cv::Size frame_size() const override { return size; }
+    uint16_t pixel_format() const override { return format; }
+
+    void print_stats(std::ostream &os) const override;
+
+private:
+    struct MappedBuffer
+    {
+        void *start = nullptr;
+        size_t length = 0;
+    };
+
+    void close();
+    int xioctl(unsigned long request, void *arg) const;
+
+    const std::string device;
+    const cv::Size requested_size;
+    const uint16_t requested_format;
+    const size_t requested_buffers;
+
+    int fd = -1;
+    cv::Size size;
+    uint16_t format = FORMAT_UNKNOWN;
+    size_t bytes_per_line = 0;
+    std::vector<MappedBuffer> buffers;
+    std::atomic<bool> streaming{false};
+
+    std::atomic<uint64_t> dequeued{0};
+    std::atomic<uint64_t> requeued{0};
+    std::atomic<uint64_t> timeouts{0};
+};